@@ -0,0 +1,128 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cppaikit/bt/BehaviorTree.hpp>
+#include <cppaikit/bt/EventDrivenExecutor.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+using aikit::bt::Status;
+
+struct Agent {
+  float health = 1.0f;
+  float distance = 10.0f;
+  float ammo = 5.0f;
+  std::uint32_t ticks = 0;
+};
+
+bool isHurt(Agent& agent) { return agent.health < 0.3f; }
+bool isEnemyClose(Agent& agent) { return agent.distance < 2.0f; }
+bool hasAmmo(Agent& agent) { return agent.ammo > 0.0f; }
+
+Status flee(Agent& agent) {
+  agent.health += 0.01f;
+  return Status::Running;
+}
+
+Status attack(Agent& agent) {
+  agent.ammo -= 1.0f;
+  return Status::Success;
+}
+
+Status approach(Agent& agent) {
+  agent.distance -= 0.5f;
+  return (agent.distance < 2.0f) ? Status::Success : Status::Running;
+}
+
+Status reload(Agent& agent) {
+  agent.ammo += 0.5f;
+  return (agent.ammo >= 5.0f) ? Status::Success : Status::Running;
+}
+
+Status wander(Agent& agent) {
+  ++agent.ticks;
+  agent.distance = static_cast<float>((agent.ticks * 7u) % 16u);
+  return Status::Running;
+}
+
+}
+
+AIKIT_BENCHMARK(BehaviorTreeTick) {
+  const auto tree = aikit::bt::BehaviorTree<Agent>::Builder()
+      .selector()
+        .sequence()
+          .condition(isHurt)
+          .action(flee)
+        .end()
+        .sequence()
+          .condition(isEnemyClose)
+          .selector()
+            .sequence()
+              .condition(hasAmmo)
+              .action(attack)
+            .end()
+            .action(reload)
+          .end()
+        .end()
+        .sequence()
+          .inverter().condition(isEnemyClose).end()
+          .action(approach)
+        .end()
+        .action(wander)
+      .end()
+      .build();
+
+  for (const std::size_t agentCount : {std::size_t{1000}, std::size_t{10000}, std::size_t{100000}}) {
+    std::vector<Agent> agents(agentCount);
+    for (std::size_t i = 0; i < agentCount; ++i) {
+      agents[i].health = static_cast<float>(i % 10) / 10.0f;
+      agents[i].distance = static_cast<float>(i % 16);
+    }
+    // The instances of all agents in a single block
+    std::vector<std::uint32_t> instances(agentCount * tree.instanceSize());
+
+    context.measure("agents:" + std::to_string(agentCount), agentCount, [&] {
+      for (std::size_t i = 0; i < agentCount; ++i) {
+        tree.tick(agents[i], {instances.data() + i * tree.instanceSize(), tree.instanceSize()});
+      }
+    });
+
+    aikit::bench::doNotOptimize(agents.back().ticks);
+  }
+}
+
+AIKIT_BENCHMARK(BehaviorTreeEventDriven) {
+  constexpr std::size_t agentCount = 10000;
+
+  // Nested sequences guarding a running leaf: ticking the tree walks down to the leaf, the executor ticks it directly
+  for (const std::uint32_t depth : {4u, 64u, 512u}) {
+    aikit::bt::BehaviorTree<Agent>::Builder builder;
+    for (std::uint32_t i = 0; i < depth; ++i) {
+      builder.sequence().inverter().condition(isHurt).end();
+    }
+    builder.action(wander);
+    const auto tree = builder.build();
+    const aikit::bt::EventDrivenExecutor<Agent> executor(tree);
+
+    std::vector<Agent> agents(agentCount);
+    std::vector<std::uint32_t> treeInstances(agentCount * tree.instanceSize());
+    std::vector<std::uint32_t> executorInstances(agentCount * executor.instanceSize());
+
+    context.measure("tree/depth:" + std::to_string(depth), agentCount, [&] {
+      for (std::size_t i = 0; i < agentCount; ++i) {
+        tree.tick(agents[i], {treeInstances.data() + i * tree.instanceSize(), tree.instanceSize()});
+      }
+    });
+
+    context.measure("executor/depth:" + std::to_string(depth), agentCount, [&] {
+      for (std::size_t i = 0; i < agentCount; ++i) {
+        executor.tick(agents[i], {executorInstances.data() + i * executor.instanceSize(), executor.instanceSize()});
+      }
+    });
+
+    aikit::bench::doNotOptimize(agents.back().ticks);
+  }
+}
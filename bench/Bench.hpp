@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace aikit::bench {
+
+/**
+ * Prevent the compiler from optimizing away the computation of \a value.
+ */
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+/**
+ * Number of calls to the global operator new since the start of the program, counted by the replacement in Main.cpp.
+ */
+inline std::atomic<std::uint64_t>& allocationCount() {
+  static std::atomic<std::uint64_t> count{0};
+  return count;
+}
+
+/**
+ * Measures and reports the cost of operations for a benchmark.
+ */
+class Context {
+ public:
+  explicit Context(std::string benchmarkName) : mName(std::move(benchmarkName)) {}
+
+  /**
+   * Measure the time per operation of \a fn.
+   * \a fn is run repeatedly until a minimum amount of time has passed, the best of a few repetitions is reported.
+   * @param label Label of the measurement, reported together with the benchmark name.
+   * @param opsPerRun Number of operations executed by each call to \a fn.
+   * @param fn Function executing the operations being measured.
+   */
+  template<typename TFn>
+  void measure(const std::string& label, std::size_t opsPerRun, TFn&& fn) {
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t runs = 1;
+    for (;;) {
+      const auto start = Clock::now();
+      for (std::size_t i = 0; i < runs; ++i) {
+        fn();
+      }
+      if (Clock::now() - start >= kMinTime || runs >= kMaxRuns) {
+        break;
+      }
+      runs *= 2;
+    }
+
+    double bestNs = 0.0;
+    const std::uint64_t allocationsBefore = allocationCount().load(std::memory_order_relaxed);
+    for (int repetition = 0; repetition < kRepetitions; ++repetition) {
+      const auto start = Clock::now();
+      for (std::size_t i = 0; i < runs; ++i) {
+        fn();
+      }
+      const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+      const double ns = elapsed.count() / static_cast<double>(runs * opsPerRun);
+      bestNs = (repetition == 0) ? ns : std::min(bestNs, ns);
+    }
+    const std::uint64_t allocations = allocationCount().load(std::memory_order_relaxed) - allocationsBefore;
+    const double allocationsPerOp =
+        static_cast<double>(allocations) / static_cast<double>(kRepetitions * runs * opsPerRun);
+
+    std::cout << std::left << std::setw(64) << (mName + "/" + label)
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2) << bestNs << " ns/op"
+              << std::setw(12) << std::setprecision(2) << allocationsPerOp << " allocs/op"
+              << std::endl;
+  }
+
+ private:
+  static constexpr std::chrono::milliseconds kMinTime{20};
+  static constexpr std::size_t kMaxRuns = std::size_t{1} << 24;
+  static constexpr int kRepetitions = 5;
+
+  std::string mName;
+};
+
+typedef void (*BenchmarkFunction)(Context&);
+
+struct Benchmark {
+  const char* name;
+  BenchmarkFunction function;
+};
+
+/**
+ * All benchmarks registered with AIKIT_BENCHMARK().
+ */
+inline std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+struct Registrar {
+  Registrar(const char* name, BenchmarkFunction function) {
+    registry().push_back({name, function});
+  }
+};
+
+}
+
+/**
+ * Define and register a benchmark. The body receives an aikit::bench::Context named \a context.
+ */
+#define AIKIT_BENCHMARK(benchName)                                                            \
+  static void benchName(aikit::bench::Context& context);                                     \
+  static const aikit::bench::Registrar benchName##Registrar(#benchName, &benchName);         \
+  static void benchName(aikit::bench::Context& context)
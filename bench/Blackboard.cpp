@@ -0,0 +1,59 @@
+#include <any>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cppaikit/Blackboard.hpp>
+
+#include "Bench.hpp"
+
+AIKIT_BENCHMARK(BlackboardReadWrite) {
+  constexpr std::size_t agentCount = 1000;
+  const std::vector<std::string> names = {"health", "ammo", "alertLevel", "distance", "cover", "morale"};
+
+  // Agents on a squad blackboard, the alert level is read through the parent
+  aikit::BlackboardSchema schema;
+  std::vector<aikit::BlackboardKey<float>> keys;
+  for (const auto& name : names) {
+    keys.push_back(schema.addKey<float>(name));
+  }
+
+  aikit::Blackboard squad(schema);
+  squad.set(keys[2], 1.0f);
+  std::vector<aikit::Blackboard> agents;
+  agents.reserve(agentCount);
+  for (std::size_t i = 0; i < agentCount; ++i) {
+    agents.emplace_back(schema, &squad);
+    for (std::size_t key = 0; key < keys.size(); ++key) {
+      if (key != 2) {
+        agents.back().set(keys[key], static_cast<float>(i));
+      }
+    }
+  }
+
+  float sum = 0.0f;
+  context.measure("slots", agentCount, [&] {
+    for (auto& agent : agents) {
+      agent.set(keys[0], agent.get(keys[0]) + agent.get(keys[2]) * agent.get(keys[3]));
+      sum += agent.get(keys[0]);
+    }
+  });
+
+  // The string keyed blackboard being replaced
+  std::vector<std::unordered_map<std::string, std::any>> maps(agentCount);
+  for (std::size_t i = 0; i < agentCount; ++i) {
+    for (const auto& name : names) {
+      maps[i][name] = static_cast<float>(i);
+    }
+  }
+
+  context.measure("string_any_map", agentCount, [&] {
+    for (auto& map : maps) {
+      map["health"] = std::any_cast<float>(map["health"]) +
+                      std::any_cast<float>(map["alertLevel"]) * std::any_cast<float>(map["distance"]);
+      sum += std::any_cast<float>(map["health"]);
+    }
+  });
+
+  aikit::bench::doNotOptimize(sum);
+}
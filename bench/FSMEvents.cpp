@@ -0,0 +1,76 @@
+#include <array>
+#include <string>
+
+#include <cppaikit/fsm/FSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+constexpr std::size_t kStates = 16;
+constexpr std::size_t kEvents = 8;
+constexpr std::size_t kDispatches = 1024;
+
+class EmptyState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override {}
+};
+
+// Next state of a transition, the same rule is used by both variants
+std::size_t targetOf(std::size_t state, std::size_t event) {
+  return (state * 7 + event * 3 + 1) % kStates;
+}
+
+}
+
+AIKIT_BENCHMARK(FSMEventDispatch) {
+  aikit::fsm::FSM<> fsm;
+  std::array<aikit::fsm::StateHandle, kStates> states{};
+  std::array<std::string, kStates> ids{};
+  std::array<aikit::fsm::EventHandle, kEvents> events{};
+
+  for (std::size_t state = 0; state < kStates; ++state) {
+    ids[state] = "state" + std::to_string(state);
+    states[state] = fsm.addState(ids[state], EmptyState());
+  }
+  for (auto& event : events) {
+    event = fsm.addEvent();
+  }
+  for (std::size_t state = 0; state < kStates; ++state) {
+    for (std::size_t event = 0; event < kEvents; ++event) {
+      fsm.addTransition(states[state], events[event], states[targetOf(state, event)]);
+    }
+  }
+  fsm.setCurrentState(states[0]);
+
+  // Baselines: the current state picks the target with a chain of comparisons on the event
+  const auto pickTarget = [&](std::size_t event) {
+    const std::size_t current = fsm.currentStateHandle().index;
+    for (std::size_t candidate = 0; candidate < kEvents; ++candidate) {
+      if (candidate == event) {
+        return targetOf(current, candidate);
+      }
+    }
+    return current;
+  };
+
+  context.measure("if-else/transitionTo(id)", kDispatches, [&] {
+    for (std::size_t i = 0; i < kDispatches; ++i) {
+      fsm.transitionTo(ids[pickTarget(i % kEvents)]);
+    }
+  });
+
+  context.measure("if-else/transitionTo(handle)", kDispatches, [&] {
+    for (std::size_t i = 0; i < kDispatches; ++i) {
+      fsm.transitionTo(states[pickTarget(i % kEvents)]);
+    }
+  });
+
+  context.measure("dispatch(event)", kDispatches, [&] {
+    for (std::size_t i = 0; i < kDispatches; ++i) {
+      fsm.dispatch(events[i % kEvents]);
+    }
+  });
+
+  aikit::bench::doNotOptimize(fsm.currentStateHandle().index);
+}
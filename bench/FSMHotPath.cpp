@@ -0,0 +1,197 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cppaikit/fsm/FSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+class BenchState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { mAccumulated += updateData; }
+
+ private:
+  int mAccumulated = 0;
+};
+
+enum class BenchStateId : std::uint32_t {};
+
+constexpr std::size_t kTransitions = 1024;
+
+template<typename TId>
+TId makeId(std::size_t index);
+
+template<>
+std::string makeId<std::string>(std::size_t index) {
+  return "agent/state/" + std::to_string(index);
+}
+
+template<>
+int makeId<int>(std::size_t index) {
+  return static_cast<int>(index);
+}
+
+template<>
+BenchStateId makeId<BenchStateId>(std::size_t index) {
+  return static_cast<BenchStateId>(index);
+}
+
+template<typename TId>
+std::vector<TId> makeIds(std::size_t count) {
+  std::vector<TId> ids;
+  ids.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    ids.emplace_back(makeId<TId>(i));
+  }
+  return ids;
+}
+
+/// Random picks among \a count states, the same for every id type.
+std::vector<std::size_t> makeTargets(std::size_t count) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<std::size_t> pick(0, count - 1);
+
+  std::vector<std::size_t> targets(kTransitions);
+  for (auto& target : targets) {
+    target = pick(random);
+  }
+  return targets;
+}
+
+template<typename TId>
+void benchIdType(aikit::bench::Context& context, const char* idName) {
+  typedef aikit::fsm::FSM<TId> BenchFSM;
+
+  for (const std::size_t stateCount : {4, 16, 64, 256, 1024, 4096}) {
+    const auto ids = makeIds<TId>(stateCount);
+    const auto targets = makeTargets(stateCount);
+    const std::string suffix = std::string(idName) + "/states:" + std::to_string(stateCount);
+
+    // A new machine on every run, so the cost includes growing the storage
+    context.measure("addState/" + suffix, stateCount, [&] {
+      BenchFSM fsm;
+      for (const auto& id : ids) {
+        fsm.addState(id, BenchState());
+      }
+      aikit::bench::doNotOptimize(fsm.size());
+    });
+
+    BenchFSM fsm;
+    fsm.reserve(stateCount);
+    std::vector<aikit::fsm::StateHandle> handles;
+    for (const auto& id : ids) {
+      handles.emplace_back(fsm.addState(id, BenchState()));
+    }
+
+    // Removing and adding back the same states, after the first run slots are reused
+    context.measure("removeState+addState/" + suffix, stateCount, [&] {
+      for (const auto& id : ids) {
+        fsm.removeState(id);
+        fsm.addState(id, BenchState());
+      }
+    });
+
+    std::vector<TId> targetIds;
+    std::vector<aikit::fsm::StateHandle> targetHandles;
+    for (const auto target : targets) {
+      targetIds.emplace_back(ids[target]);
+      targetHandles.emplace_back(fsm.stateHandle(ids[target]));
+    }
+
+    context.measure("transitionTo(id)/" + suffix, kTransitions, [&] {
+      for (const auto& id : targetIds) {
+        aikit::bench::doNotOptimize(fsm.transitionTo(id));
+      }
+    });
+
+    context.measure("transitionTo(handle)/" + suffix, kTransitions, [&] {
+      for (const auto handle : targetHandles) {
+        aikit::bench::doNotOptimize(fsm.transitionTo(handle));
+      }
+    });
+
+    context.measure("update/" + suffix, kTransitions, [&] {
+      for (std::size_t i = 0; i < kTransitions; ++i) {
+        fsm.update(1);
+      }
+    });
+  }
+}
+
+}
+
+AIKIT_BENCHMARK(FSMHotPath) {
+  benchIdType<std::string>(context, "string");
+  benchIdType<int>(context, "int");
+  benchIdType<BenchStateId>(context, "enum");
+}
+
+AIKIT_BENCHMARK(FSMHotPathAgents) {
+  // Many small machines, one per agent, each updated and transitioning once per tick
+  constexpr std::size_t stateCount = 8;
+
+  for (const std::size_t agentCount : {100, 1000, 10000}) {
+    std::vector<aikit::fsm::FSM<int>> machines(agentCount);
+    std::vector<aikit::fsm::StateHandle> handles;
+    for (auto& machine : machines) {
+      machine.reserve(stateCount);
+      for (std::size_t state = 0; state < stateCount; ++state) {
+        handles.emplace_back(machine.addState(static_cast<int>(state), BenchState()));
+      }
+      machine.setCurrentState(0);
+    }
+
+    std::size_t tick = 0;
+    context.measure("update+transitionTo/agents:" + std::to_string(agentCount), agentCount, [&] {
+      ++tick;
+      for (std::size_t agent = 0; agent < agentCount; ++agent) {
+        machines[agent].update(1);
+        machines[agent].transitionTo(handles[agent * stateCount + (agent + tick) % stateCount]);
+      }
+    });
+  }
+}
+
+AIKIT_BENCHMARK(FSMProfiler) {
+  // Cost of the profiling policy on the hot paths, NoProfiler must match FSMHotPath
+  typedef aikit::fsm::FSM<int, aikit::fsm::State<>, aikit::fsm::storage::Map, aikit::fsm::Profiler> ProfiledFSM;
+
+  aikit::fsm::ProfileStats stats;
+  ProfiledFSM profiled;
+  profiled.profiler().attach(&stats);
+  aikit::fsm::FSM<int> plain;
+
+  std::vector<aikit::fsm::StateHandle> profiledHandles;
+  std::vector<aikit::fsm::StateHandle> plainHandles;
+  for (int state = 0; state < 16; ++state) {
+    profiledHandles.emplace_back(profiled.addState(state, BenchState()));
+    plainHandles.emplace_back(plain.addState(state, BenchState()));
+  }
+
+  context.measure("transitionTo(handle)/NoProfiler", kTransitions, [&] {
+    for (std::size_t i = 0; i < kTransitions; ++i) {
+      plain.transitionTo(plainHandles[i % plainHandles.size()]);
+    }
+  });
+
+  context.measure("transitionTo(handle)/Profiler", kTransitions, [&] {
+    for (std::size_t i = 0; i < kTransitions; ++i) {
+      profiled.transitionTo(profiledHandles[i % profiledHandles.size()]);
+    }
+  });
+
+  context.measure("update/NoProfiler", kTransitions, [&] {
+    for (std::size_t i = 0; i < kTransitions; ++i) {
+      plain.update(1);
+    }
+  });
+
+  context.measure("update/Profiler", kTransitions, [&] {
+    for (std::size_t i = 0; i < kTransitions; ++i) {
+      profiled.update(1);
+    }
+  });
+}
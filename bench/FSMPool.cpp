@@ -0,0 +1,85 @@
+#include <string>
+#include <vector>
+
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/FSMPool.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+constexpr std::size_t kStates = 8;
+
+template<int N>
+class AgentState : public aikit::fsm::State<float> {
+ public:
+  void update(float deltaTime) override { mValue += deltaTime * static_cast<float>(N + 1); }
+
+  float mValue = 0.0f;
+};
+
+// Same work as AgentState, with a batched update the compiler can vectorize when all agents are on the state
+template<int N>
+class BatchedAgentState : public aikit::fsm::State<float> {
+ public:
+  static void updateBatch(aikit::fsm::StateBatch<BatchedAgentState> batch, float deltaTime) {
+    const float step = deltaTime * static_cast<float>(N + 1);
+    if (batch.agents.size() == batch.states.size()) {
+      for (auto& state : batch.states) {
+        state.mValue += step;
+      }
+    } else {
+      for (const auto agent : batch.agents) {
+        batch.states[agent].mValue += step;
+      }
+    }
+  }
+
+  void update(float deltaTime) override { mValue += deltaTime * static_cast<float>(N + 1); }
+
+  float mValue = 0.0f;
+};
+
+template<typename TMachine, int... Ns>
+void addStates(TMachine& machine, std::integer_sequence<int, Ns...>) {
+  (machine.addState("state" + std::to_string(Ns), AgentState<Ns>()), ...);
+}
+
+}
+
+AIKIT_BENCHMARK(FSMPoolUpdate) {
+  for (const std::size_t agentCount : {std::size_t{1000}, std::size_t{10000}, std::size_t{50000}}) {
+    const std::string suffix = std::to_string(agentCount);
+
+    std::vector<aikit::fsm::FSM<std::string, aikit::fsm::State<float>>> machines(agentCount);
+    for (std::size_t agent = 0; agent < agentCount; ++agent) {
+      addStates(machines[agent], std::make_integer_sequence<int, kStates>());
+      machines[agent].setCurrentState("state" + std::to_string(agent % kStates));
+    }
+
+    context.measure("FSM/" + suffix, agentCount, [&] {
+      for (auto& machine : machines) {
+        machine.update(0.016f);
+      }
+    });
+
+    aikit::fsm::FSMPool<std::string, aikit::fsm::State<float>> pool;
+    addStates(pool, std::make_integer_sequence<int, kStates>());
+    pool.reserveAgents(agentCount);
+    for (std::size_t agent = 0; agent < agentCount; ++agent) {
+      pool.setCurrentState(pool.addAgent(), "state" + std::to_string(agent % kStates));
+    }
+
+    context.measure("FSMPool/" + suffix, agentCount, [&] { pool.updateAll(0.016f); });
+
+    aikit::fsm::FSMPool<std::string, aikit::fsm::State<float>> batchedPool;
+    batchedPool.addState("batched", BatchedAgentState<0>());
+    batchedPool.reserveAgents(agentCount);
+    for (std::size_t agent = 0; agent < agentCount; ++agent) {
+      batchedPool.setCurrentState(batchedPool.addAgent(), "batched");
+    }
+
+    context.measure("FSMPool(updateBatch, single state)/" + suffix, agentCount,
+                    [&] { batchedPool.updateAll(0.016f); });
+  }
+}
@@ -0,0 +1,52 @@
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/FSMScheduler.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+constexpr std::size_t kMachines = 20000;
+
+// State with enough work per update for the parallel speedup to be visible
+class WorkState : public aikit::fsm::State<float> {
+ public:
+  void update(float deltaTime) override {
+    for (int i = 0; i < 64; ++i) {
+      mValue = std::sin(mValue + deltaTime);
+    }
+  }
+
+  float mValue = 0.0f;
+};
+
+}
+
+AIKIT_BENCHMARK(FSMSchedulerScaling) {
+  typedef aikit::fsm::FSM<std::string, aikit::fsm::State<float>> WorkFSM;
+
+  std::vector<WorkFSM> machines(kMachines);
+  for (auto& machine : machines) {
+    machine.addState("work", WorkState());
+    machine.setCurrentState("work");
+  }
+
+  context.measure("serial", kMachines, [&] {
+    for (auto& machine : machines) {
+      machine.update(0.016f);
+    }
+  });
+
+  const std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+    for (const std::size_t chunkSize : {std::size_t{16}, std::size_t{256}}) {
+      aikit::fsm::FSMScheduler<WorkFSM> scheduler(threads, chunkSize);
+      context.measure("threads=" + std::to_string(threads) + "/chunk=" + std::to_string(chunkSize), kMachines,
+                      [&] { scheduler.update(machines, 0.016f); });
+    }
+  }
+}
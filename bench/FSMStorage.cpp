@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cppaikit/fsm/FSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+class BenchState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { mAccumulated += updateData; }
+
+ private:
+  int mAccumulated = 0;
+};
+
+constexpr std::size_t kLookups = 1024;
+
+std::vector<std::string> makeIds(std::size_t count) {
+  std::vector<std::string> ids;
+  ids.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    ids.emplace_back("agent/state/" + std::to_string(i));
+  }
+  return ids;
+}
+
+std::vector<std::string> makeLookups(const std::vector<std::string>& ids) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<std::size_t> pick(0, ids.size() - 1);
+
+  std::vector<std::string> lookups;
+  lookups.reserve(kLookups);
+  for (std::size_t i = 0; i < kLookups; ++i) {
+    lookups.emplace_back(ids[pick(random)]);
+  }
+  return lookups;
+}
+
+template<typename TStorage>
+void benchStorage(aikit::bench::Context& context, const char* storageName) {
+  for (const std::size_t stateCount : {std::size_t{8}, std::size_t{64}, std::size_t{512}}) {
+    const auto ids = makeIds(stateCount);
+    const auto lookups = makeLookups(ids);
+
+    aikit::fsm::FSM<std::string, aikit::fsm::State<>, TStorage> fsm;
+    fsm.reserve(stateCount);
+    for (const auto& id : ids) {
+      fsm.addState(id, BenchState());
+    }
+
+    const std::string suffix = std::string(storageName) + "/" + std::to_string(stateCount);
+
+    context.measure("hasState/" + suffix, kLookups, [&] {
+      for (const auto& id : lookups) {
+        aikit::bench::doNotOptimize(fsm.hasState(id));
+      }
+    });
+
+    context.measure("transitionTo/" + suffix, kLookups, [&] {
+      for (const auto& id : lookups) {
+        aikit::bench::doNotOptimize(fsm.transitionTo(id));
+      }
+    });
+
+    std::vector<aikit::fsm::StateHandle> handles;
+    handles.reserve(lookups.size());
+    for (const auto& id : lookups) {
+      handles.emplace_back(fsm.stateHandle(id));
+    }
+
+    context.measure("transitionTo(handle)/" + suffix, kLookups, [&] {
+      for (const auto handle : handles) {
+        aikit::bench::doNotOptimize(fsm.transitionTo(handle));
+      }
+    });
+
+    context.measure("setCurrentState/" + suffix, kLookups, [&] {
+      for (const auto& id : lookups) {
+        aikit::bench::doNotOptimize(fsm.setCurrentState(id));
+      }
+    });
+  }
+}
+
+}
+
+AIKIT_BENCHMARK(FSMStorage) {
+  benchStorage<aikit::fsm::storage::Map>(context, "Map");
+  benchStorage<aikit::fsm::storage::FlatMap>(context, "FlatMap");
+  benchStorage<aikit::fsm::storage::HashMap>(context, "HashMap");
+}
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cppaikit/goap/Planner.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+enum Fact : std::size_t {
+  HasWeapon, WeaponLoaded, HasAmmo, EnemyVisible, EnemyInRange, EnemyDead, InCover, Healthy, HasMedkit, NearAmmo,
+  NearMedkit, NearWeapon, Fact_count
+};
+
+typedef aikit::goap::WorldState<Fact_count> BenchWorldState;
+typedef aikit::goap::Planner<Fact_count> BenchPlanner;
+
+void addActions(BenchPlanner& planner) {
+  planner.addAction({BenchWorldState().set(NearWeapon), BenchWorldState().set(HasWeapon), 1.0f});
+  planner.addAction({BenchWorldState().set(NearAmmo), BenchWorldState().set(HasAmmo), 1.0f});
+  planner.addAction({BenchWorldState().set(NearMedkit), BenchWorldState().set(HasMedkit), 1.0f});
+  planner.addAction({BenchWorldState(), BenchWorldState().set(NearWeapon).set(NearAmmo, false), 3.0f});
+  planner.addAction({BenchWorldState(), BenchWorldState().set(NearAmmo).set(NearWeapon, false), 3.0f});
+  planner.addAction({BenchWorldState(), BenchWorldState().set(NearMedkit).set(InCover, false), 4.0f});
+  planner.addAction({BenchWorldState().set(HasWeapon).set(HasAmmo),
+                     BenchWorldState().set(WeaponLoaded).set(HasAmmo, false), 1.0f});
+  planner.addAction({BenchWorldState(), BenchWorldState().set(EnemyVisible), 2.0f});
+  planner.addAction({BenchWorldState().set(EnemyVisible), BenchWorldState().set(EnemyInRange).set(InCover, false),
+                     2.0f});
+  planner.addAction({BenchWorldState(), BenchWorldState().set(InCover), 2.0f});
+  planner.addAction({BenchWorldState().set(HasMedkit), BenchWorldState().set(Healthy).set(HasMedkit, false), 1.0f});
+  planner.addAction({BenchWorldState().set(WeaponLoaded).set(EnemyInRange).set(Healthy),
+                     BenchWorldState().set(EnemyDead).set(WeaponLoaded, false), 1.0f});
+  planner.addAction({BenchWorldState().set(WeaponLoaded).set(EnemyVisible).set(InCover),
+                     BenchWorldState().set(EnemyDead).set(WeaponLoaded, false), 3.0f});
+}
+
+}
+
+AIKIT_BENCHMARK(GOAPPlan) {
+  BenchPlanner planner;
+  addActions(planner);
+
+  // Agents start from different combinations of the facts
+  constexpr std::size_t agentCount = 256;
+  std::vector<BenchWorldState> starts(agentCount);
+  for (std::size_t i = 0; i < agentCount; ++i) {
+    for (std::size_t bit = 0; bit < Fact_count; ++bit) {
+      starts[i].set(bit, ((i * 2654435761u) >> bit) & 1u);
+    }
+    starts[i].set(EnemyDead, false);
+  }
+
+  const BenchWorldState goal = BenchWorldState().set(EnemyDead);
+  std::vector<std::uint32_t> plan;
+  std::size_t planned = 0;
+
+  context.measure("agents:" + std::to_string(agentCount), agentCount, [&] {
+    for (const auto& start : starts) {
+      planned += planner.plan(start, goal, plan) ? 1 : 0;
+    }
+  });
+
+  // Same starts and goal every frame, all plans come from the cache after the first run
+  planner.enableCache(agentCount);
+  context.measure("cached/agents:" + std::to_string(agentCount), agentCount, [&] {
+    for (const auto& start : starts) {
+      planned += planner.plan(start, goal, plan) ? 1 : 0;
+    }
+  });
+
+  aikit::bench::doNotOptimize(planned);
+}
+
+AIKIT_BENCHMARK(GOAPIncremental) {
+  BenchPlanner planner;
+  addActions(planner);
+
+  constexpr std::size_t agentCount = 256;
+  std::vector<BenchWorldState> starts(agentCount);
+  for (std::size_t i = 0; i < agentCount; ++i) {
+    for (std::size_t bit = 0; bit < Fact_count; ++bit) {
+      starts[i].set(bit, ((i * 2654435761u) >> bit) & 1u);
+    }
+    starts[i].set(EnemyDead, false);
+  }
+
+  const BenchWorldState goal = BenchWorldState().set(EnemyDead);
+  std::vector<BenchPlanner::Search> searches;
+  for (std::size_t i = 0; i < agentCount; ++i) {
+    searches.emplace_back(1024);
+  }
+  std::vector<std::uint32_t> plan;
+  std::size_t planned = 0;
+
+  // Every agent gets a slice of expansions per frame until all searches finish
+  for (const std::size_t slice : {std::size_t{4}, std::size_t{16}, std::size_t{64}}) {
+    context.measure("slice:" + std::to_string(slice), agentCount, [&] {
+      for (std::size_t i = 0; i < agentCount; ++i) {
+        planner.begin(searches[i], starts[i], goal);
+      }
+
+      for (bool running = true; running;) {
+        running = false;
+        for (auto& search : searches) {
+          running |= planner.step(search, slice) == aikit::goap::PlanStatus::Running;
+        }
+      }
+
+      for (const auto& search : searches) {
+        planned += planner.result(search, plan) ? 1 : 0;
+      }
+    });
+  }
+
+  aikit::bench::doNotOptimize(planned);
+}
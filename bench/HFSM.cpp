@@ -0,0 +1,65 @@
+#include <string>
+
+#include <cppaikit/fsm/HFSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+constexpr std::size_t kTransitions = 1024;
+
+class CountingState : public aikit::fsm::State<> {
+ public:
+  void onEnter() override { ++mCalls; }
+  void onExit() override { ++mCalls; }
+  void update(int updateData) override { mCalls += updateData; }
+
+  int mCalls = 0;
+};
+
+}
+
+AIKIT_BENCHMARK(HFSMTransition) {
+  for (const int depth : {8, 12, 16}) {
+    const std::string suffix = "/depth:" + std::to_string(depth);
+
+    // A top level state with two chains of \a depth levels, the deepest leaves share only the top level state
+    aikit::fsm::HFSM<int> hfsm;
+    hfsm.addState(0, CountingState());
+    aikit::fsm::StateHandle leaves[2];
+    aikit::fsm::StateHandle siblings[2];
+    for (int branch = 0; branch < 2; ++branch) {
+      auto parent = hfsm.stateHandle(0);
+      for (int level = 1; level <= depth; ++level) {
+        parent = hfsm.addState((branch + 1) * 1000 + level, CountingState(), parent);
+      }
+      leaves[branch] = parent;
+    }
+    siblings[0] = leaves[0];
+    siblings[1] = hfsm.addState(-1, CountingState(), hfsm.parentOf(leaves[0]));
+    hfsm.build();
+    hfsm.setCurrentState(leaves[0]);
+
+    context.measure("deepest leaves" + suffix, kTransitions, [&] {
+      for (std::size_t i = 0; i < kTransitions; ++i) {
+        hfsm.transitionTo(leaves[(i + 1) & 1]);
+      }
+    });
+
+    hfsm.setCurrentState(siblings[0]);
+    context.measure("siblings" + suffix, kTransitions, [&] {
+      for (std::size_t i = 0; i < kTransitions; ++i) {
+        hfsm.transitionTo(siblings[(i + 1) & 1]);
+      }
+    });
+
+    hfsm.setCurrentState(leaves[0]);
+    context.measure("update active chain" + suffix, kTransitions, [&] {
+      for (std::size_t i = 0; i < kTransitions; ++i) {
+        hfsm.update(1);
+      }
+    });
+
+    aikit::bench::doNotOptimize(static_cast<const CountingState*>(hfsm.getState(leaves[0]))->mCalls);
+  }
+}
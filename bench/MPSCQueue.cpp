@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cppaikit/MPSCQueue.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+constexpr std::size_t kEventsPerRun = 1 << 16;
+
+class EmptyState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override {}
+};
+
+// Run \a producerCount threads pushing kEventsPerRun elements in total while the calling thread consumes them
+template<typename TPush, typename TConsume>
+void runProducers(std::size_t producerCount, const TPush& push, const TConsume& consume) {
+  std::atomic<bool> start{false};
+  std::vector<std::thread> producers;
+  producers.reserve(producerCount);
+
+  for (std::size_t producer = 0; producer < producerCount; ++producer) {
+    producers.emplace_back([&] {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (std::size_t i = 0; i < kEventsPerRun / producerCount; ++i) {
+        while (!push()) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  start.store(true, std::memory_order_release);
+  std::size_t consumed = 0;
+  const std::size_t total = (kEventsPerRun / producerCount) * producerCount;
+  while (consumed < total) {
+    const std::size_t popped = consume();
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+    consumed += popped;
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+}
+
+}
+
+AIKIT_BENCHMARK(MPSCQueueContention) {
+  const std::size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (std::size_t producerCount = 1; producerCount <= std::max<std::size_t>(hardwareThreads, 4);
+       producerCount *= 2) {
+    aikit::MPSCQueue<std::uint32_t> queue(1024);
+
+    context.measure("queue/producers:" + std::to_string(producerCount), kEventsPerRun, [&] {
+      runProducers(producerCount, [&] { return queue.tryPush(1); }, [&] {
+        std::size_t popped = 0;
+        std::uint32_t value = 0;
+        while (queue.tryPop(value)) {
+          ++popped;
+        }
+        return popped;
+      });
+    });
+
+    aikit::fsm::FSM<> fsm;
+    const auto first = fsm.addState("first", EmptyState());
+    const auto second = fsm.addState("second", EmptyState());
+    const auto toggle = fsm.addEvent();
+    fsm.addTransition(first, toggle, second);
+    fsm.addTransition(second, toggle, first);
+    fsm.setCurrentState(first);
+    fsm.enableInbox(1024);
+
+    context.measure("FSM inbox/producers:" + std::to_string(producerCount), kEventsPerRun, [&] {
+      runProducers(producerCount, [&] { return fsm.postEvent(toggle); }, [&] { return fsm.dispatchInbox(); });
+    });
+  }
+}
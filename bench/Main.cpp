@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "Bench.hpp"
+
+// Count every allocation of the program, reported as allocs/op by aikit::bench::Context::measure()
+void* operator new(std::size_t size) {
+  aikit::bench::allocationCount().fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc((size > 0) ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  aikit::bench::allocationCount().fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc needs a non zero size multiple of the alignment
+  const auto align = static_cast<std::size_t>(alignment);
+  const std::size_t rounded = (((size > 0) ? size : 1) + align - 1) / align * align;
+  if (void* memory = std::aligned_alloc(align, rounded)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+// Usage: CppAIKit-bench [filter], runs only the benchmarks whose name contains filter.
+int main(int argc, const char* argv[]) {
+  const char* filter = (argc > 1) ? argv[1] : "";
+
+  for (const auto& benchmark : aikit::bench::registry()) {
+    if (std::strstr(benchmark.name, filter) != nullptr) {
+      aikit::bench::Context context(benchmark.name);
+      benchmark.function(context);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/Snapshot.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+class BenchState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { mAccumulated += updateData; }
+
+ private:
+  int mAccumulated = 0;
+};
+
+constexpr int kStateCount = 8;
+
+}
+
+AIKIT_BENCHMARK(FSMSnapshot) {
+  typedef aikit::fsm::FSM<int> BenchFSM;
+
+  for (const std::size_t machineCount : {std::size_t{1000}, std::size_t{100000}}) {
+    std::vector<BenchFSM> machines(machineCount);
+    for (std::size_t i = 0; i < machineCount; ++i) {
+      for (int state = 0; state < kStateCount; ++state) {
+        machines[i].addState(state, BenchState());
+      }
+      machines[i].setCurrentState(static_cast<int>(i % kStateCount));
+      machines[i].transitionTo(static_cast<int>((i + 1) % kStateCount));
+    }
+
+    // The buffer keeps its capacity between runs, as a game saving every few seconds would
+    std::vector<unsigned char> buffer;
+    const std::string suffix = "/machines:" + std::to_string(machineCount);
+
+    context.measure("save" + suffix, machineCount, [&] {
+      aikit::bench::doNotOptimize(aikit::fsm::saveSnapshots<BenchFSM>(machines, buffer));
+    });
+
+    context.measure("load" + suffix, machineCount, [&] {
+      aikit::bench::doNotOptimize(aikit::fsm::loadSnapshots<BenchFSM>(machines, buffer.data(), buffer.size()));
+    });
+  }
+}
@@ -0,0 +1,51 @@
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/StaticFSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+constexpr std::size_t kUpdates = 1024;
+
+template<int N>
+class CountingState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { mAccumulated += updateData * N; }
+
+  int mAccumulated = 0;
+};
+
+}
+
+AIKIT_BENCHMARK(StaticFSMDispatch) {
+  aikit::fsm::FSM<> fsm;
+  fsm.addState("s0", CountingState<0>());
+  fsm.addState("s1", CountingState<1>());
+  fsm.addState("s2", CountingState<2>());
+  fsm.addState("s3", CountingState<3>());
+  const auto s0 = fsm.stateHandle("s0");
+  const auto s3 = fsm.stateHandle("s3");
+
+  context.measure("FSM/update+transition", kUpdates, [&] {
+    for (std::size_t i = 0; i < kUpdates; ++i) {
+      fsm.update(1);
+      fsm.transitionTo((i & 1) ? s0 : s3);
+    }
+  });
+
+  aikit::fsm::StaticFSM<CountingState<0>, CountingState<1>, CountingState<2>, CountingState<3>> staticFsm;
+  staticFsm.setCurrentState<CountingState<0>>();
+
+  context.measure("StaticFSM/update+transition", kUpdates, [&] {
+    for (std::size_t i = 0; i < kUpdates; ++i) {
+      staticFsm.update(1);
+      if (i & 1) {
+        staticFsm.transitionTo<CountingState<0>>();
+      } else {
+        staticFsm.transitionTo<CountingState<3>>();
+      }
+    }
+  });
+
+  aikit::bench::doNotOptimize(staticFsm.getState<CountingState<3>>().mAccumulated);
+}
@@ -0,0 +1,61 @@
+// Tracing changes the layout of fsm::FSM: this file only instantiates machines with TracedStateId, an id type local to
+// it, so the traced machines never clash with the machines of the other benchmarks.
+#define CppAIKit_TRACING
+
+#include <cstdint>
+#include <vector>
+
+#include <cppaikit/Trace.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+
+#include "Bench.hpp"
+
+namespace {
+
+class BenchState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { mAccumulated += updateData; }
+
+ private:
+  int mAccumulated = 0;
+};
+
+enum class TracedStateId : std::uint32_t {};
+
+constexpr std::size_t kTransitions = 1024;
+
+}
+
+AIKIT_BENCHMARK(FSMTrace) {
+  // Small enough to stay in cache, collected after every run so records are never dropped unread
+  aikit::trace::setBufferCapacity(kTransitions);
+  std::vector<aikit::trace::Record> records;
+  records.reserve(kTransitions);
+
+  context.measure("recordTransition", kTransitions, [&] {
+    for (std::uint32_t i = 0; i < kTransitions; ++i) {
+      aikit::trace::recordTransition(0, i, i + 1, aikit::trace::kNone);
+    }
+  });
+
+  aikit::fsm::FSM<TracedStateId> fsm;
+  std::vector<aikit::fsm::StateHandle> handles;
+  for (std::uint32_t state = 0; state < 16; ++state) {
+    handles.emplace_back(fsm.addState(static_cast<TracedStateId>(state), BenchState()));
+  }
+
+  context.measure("transitionTo(handle)", kTransitions, [&] {
+    for (std::size_t i = 0; i < kTransitions; ++i) {
+      fsm.transitionTo(handles[i % handles.size()]);
+    }
+  });
+
+  records.clear();
+  context.measure("collect", kTransitions, [&] {
+    for (std::size_t i = 0; i < kTransitions; ++i) {
+      fsm.transitionTo(handles[i % handles.size()]);
+    }
+    records.clear();
+    aikit::trace::collect(records);
+  });
+}
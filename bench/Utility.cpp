@@ -0,0 +1,40 @@
+#include <cstdint>
+#include <string>
+
+#include <cppaikit/utility/Scorer.hpp>
+
+#include "Bench.hpp"
+
+AIKIT_BENCHMARK(UtilityScore) {
+  using aikit::utility::ResponseCurve;
+
+  constexpr std::size_t agentCount = 10000;
+  constexpr std::uint32_t inputCount = 16;
+  const ResponseCurve curves[] = {ResponseCurve::linear(-1.0f, 0.0f, 1.0f), ResponseCurve::quadratic(1.0f, 0.2f),
+                                  ResponseCurve::logistic(8.0f, 0.4f),
+                                  ResponseCurve::piecewise({{0.0f, 0.2f}, {0.3f, 1.0f}, {0.7f, 0.6f}, {1.0f, 0.0f}})};
+
+  for (const std::uint32_t actionCount : {8u, 64u}) {
+    // Three considerations per action, spread over all inputs and curve shapes
+    aikit::utility::Scorer scorer(inputCount, agentCount);
+    for (std::uint32_t action = 0; action < actionCount; ++action) {
+      scorer.addAction();
+      for (std::uint32_t consideration = 0; consideration < 3; ++consideration) {
+        const std::uint32_t input = (action * 3 + consideration) % inputCount;
+        scorer.addConsideration(action, input, curves[(action + consideration) % 4]);
+      }
+    }
+
+    for (std::uint32_t input = 0; input < inputCount; ++input) {
+      auto values = scorer.input(input);
+      for (std::size_t agent = 0; agent < agentCount; ++agent) {
+        values[agent] = static_cast<float>((agent * 31 + input * 17) % 101) / 100.0f;
+      }
+    }
+
+    context.measure("agents:10000/actions:" + std::to_string(actionCount), agentCount * actionCount,
+                    [&] { scorer.score(); });
+
+    aikit::bench::doNotOptimize(scorer.winner(agentCount - 1));
+  }
+}
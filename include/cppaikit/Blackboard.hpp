@@ -0,0 +1,315 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Instrumentation.hpp"
+
+namespace aikit {
+
+/**
+ * Typed key of a value on a aikit::Blackboard, created by aikit::BlackboardSchema::addKey().
+ * A key is the dense slot of the value and its offset on the storage of the blackboards, so reading a value is an
+ * index and a copy, without hashing or comparing names.
+ * @tparam T Type of the value.
+ */
+template<typename T>
+struct BlackboardKey {
+  static constexpr std::uint32_t kInvalidSlot = ~std::uint32_t{0};
+
+  std::uint32_t slot = kInvalidSlot; ///< Index of the key on its schema.
+  std::uint32_t offset = 0; ///< Offset of the value on the storage of the blackboards, in bytes.
+
+  /**
+   * Check if the key was set by a schema.
+   * @return True if the key was returned by aikit::BlackboardSchema::addKey() or aikit::BlackboardSchema::key().
+   */
+  bool isSet() const { return slot != kInvalidSlot; }
+};
+
+/**
+ * The keys of a family of blackboards, resolving names to typed slots once, at registration time.
+ * All blackboards created with a schema have the same layout: the values of all keys on a single contiguous buffer.
+ * @note Keys are meant to be registered on setup, finding a key by name is a linear search.
+ * @sa aikit::Blackboard
+ */
+class BlackboardSchema {
+ public:
+  /**
+   * Register a key.
+   * @tparam T Type of the value, must be trivially copyable.
+   * @param name Name of the key.
+   * @return The key, or the existing key if \a name was already registered with the same type. Unset if \a name was
+   * registered with another type.
+   */
+  template<typename T>
+  BlackboardKey<T> addKey(std::string name) {
+    static_assert(std::is_trivially_copyable_v<T>, "Blackboard values must be trivially copyable");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Blackboard values can not be over aligned");
+
+    const std::uint32_t found = find(name);
+    if (found != BlackboardKey<T>::kInvalidSlot) {
+      return (mEntries[found].type == typeTag<T>()) ? BlackboardKey<T>{found, mEntries[found].offset}
+                                                    : BlackboardKey<T>{};
+    }
+
+    const auto offset = static_cast<std::uint32_t>((mSize + alignof(T) - 1) / alignof(T) * alignof(T));
+    mSize = offset + sizeof(T);
+    mEntries.push_back({std::move(name), typeTag<T>(), offset});
+    return {static_cast<std::uint32_t>(mEntries.size() - 1), offset};
+  }
+
+  /**
+   * Find a key registered before.
+   * @tparam T Type of the value.
+   * @param name Name of the key.
+   * @return The key, unset if there is no key \a name of type \a T.
+   */
+  template<typename T>
+  BlackboardKey<T> key(const std::string& name) const {
+    const std::uint32_t found = find(name);
+    if (found == BlackboardKey<T>::kInvalidSlot || mEntries[found].type != typeTag<T>()) {
+      return {};
+    }
+    return {found, mEntries[found].offset};
+  }
+
+  /**
+   * Number of keys registered.
+   */
+  std::size_t keyCount() const {
+    return mEntries.size();
+  }
+
+  /**
+   * Bytes needed to store the values of all keys.
+   */
+  std::size_t storageSize() const {
+    return mSize;
+  }
+
+ private:
+  typedef const void* TypeTag;
+
+  struct Entry {
+    std::string name;
+    TypeTag type;
+    std::uint32_t offset;
+  };
+
+  /// An address unique to each type, so keys can be checked without RTTI.
+  template<typename T>
+  static TypeTag typeTag() {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  std::uint32_t find(const std::string& name) const {
+    for (std::size_t i = 0; i < mEntries.size(); ++i) {
+      if (mEntries[i].name == name) {
+        return static_cast<std::uint32_t>(i);
+      }
+    }
+    return BlackboardKey<int>::kInvalidSlot;
+  }
+
+  detail::ModuleVector<Entry, InstrumentedModule::Blackboard> mEntries; ///< Keys by slot.
+  std::size_t mSize = 0;
+};
+
+/**
+ * Shared memory of an agent (or a squad, or the whole game) for FSM states, behavior tree leaves and GOAP actions.
+ * Values are stored on a single contiguous buffer, at offsets resolved by the aikit::BlackboardSchema, and each key has
+ * a version incremented on every change, so "has it changed since I last looked" is a compare of two integers.
+ * A blackboard can have a parent (e.g. agent -> squad -> global): keys without a value are looked up on the parent.
+ * A blackboard fits where the modules take per agent data: as the update data of fsm::State (`State<Blackboard&>`), as
+ * the agent of a bt::BehaviorTree (with bt::isTrue() and bt::hasValue() as conditions) or as the source of the facts of
+ * a goap::WorldState (through goap::BlackboardFacts).
+ * @note Only get() and find() follow the parents, every other method works on the blackboard itself.
+ * @attention The schema and the parent must outlive the blackboard.
+ * @sa aikit::BlackboardSchema
+ * @sa aikit::BlackboardKey
+ */
+class Blackboard {
+ public:
+  /**
+   * Create a blackboard without values.
+   * @param schema The keys of the blackboard.
+   * @param parent Blackboard looked up for keys without a value, nullptr for none.
+   * @param resource Memory resource used for all allocations of the blackboard, must outlive the blackboard.
+   */
+  explicit Blackboard(const BlackboardSchema& schema, const Blackboard* parent = nullptr,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : mSchema(&schema), mParent(parent), mStorage(resource), mVersions(Allocator<std::uint32_t>(resource)),
+        mPresent(Allocator<std::uint8_t>(resource)) {
+    reserve();
+  }
+
+  /**
+   * Set the value of a key, incrementing its version.
+   * @param key A key of the schema of the blackboard.
+   * @param value The new value.
+   */
+  template<typename T>
+  void set(BlackboardKey<T> key, const T& value) {
+    if (key.slot >= mVersions.size()) {
+      reserve();
+    }
+
+    std::memcpy(mStorage.data() + key.offset, &value, sizeof(T));
+    mPresent[key.slot] = 1;
+    ++mVersions[key.slot];
+  }
+
+  /**
+   * Remove the value of a key, incrementing its version. Later lookups of the key go to the parent.
+   * @param key A key of the schema of the blackboard.
+   * @return True if the key had a value.
+   */
+  template<typename T>
+  bool erase(BlackboardKey<T> key) {
+    if (!has(key)) {
+      return false;
+    }
+
+    mPresent[key.slot] = 0;
+    ++mVersions[key.slot];
+    return true;
+  }
+
+  /**
+   * Check if a key has a value on this blackboard, without looking at the parents.
+   * @param key A key of the schema of the blackboard.
+   * @return True if the key was set and not erased.
+   */
+  template<typename T>
+  bool has(BlackboardKey<T> key) const {
+    return key.slot < mPresent.size() && mPresent[key.slot] != 0;
+  }
+
+  /**
+   * Find the value of a key, on this blackboard or else on the closest parent with a value.
+   * @param key A key of the schema of the blackboard.
+   * @return The value, nullptr if no blackboard of the chain has a value for \a key.
+   * @attention The pointer is invalidated by set() calls for keys added to the schema after the blackboard.
+   */
+  template<typename T>
+  const T* find(BlackboardKey<T> key) const {
+    for (const Blackboard* blackboard = this; blackboard != nullptr; blackboard = blackboard->mParent) {
+      if (blackboard->has(key)) {
+        return reinterpret_cast<const T*>(blackboard->mStorage.data() + key.offset);
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Get the value of a key, on this blackboard or else on the closest parent with a value.
+   * @param key A key of the schema of the blackboard.
+   * @param fallback Value returned when no blackboard of the chain has a value.
+   * @return A copy of the value.
+   */
+  template<typename T>
+  T get(BlackboardKey<T> key, const T& fallback = T()) const {
+    const T* value = find(key);
+    return (value != nullptr) ? *value : fallback;
+  }
+
+  /**
+   * The version of a key on this blackboard, incremented on every set() and erase().
+   * @param key A key of the schema of the blackboard.
+   * @return Zero if the key was never changed.
+   */
+  template<typename T>
+  std::uint32_t version(BlackboardKey<T> key) const {
+    return (key.slot < mVersions.size()) ? mVersions[key.slot] : 0;
+  }
+
+  /**
+   * Check if a key changed on this blackboard since a version was read.
+   * @param key A key of the schema of the blackboard.
+   * @param seenVersion A value returned by version().
+   * @return True if the key was set or erased since.
+   */
+  template<typename T>
+  bool changedSince(BlackboardKey<T> key, std::uint32_t seenVersion) const {
+    return version(key) != seenVersion;
+  }
+
+  /**
+   * Remove the values of all keys, incrementing the versions of the keys that had one.
+   */
+  void clear() {
+    for (std::size_t slot = 0; slot < mPresent.size(); ++slot) {
+      if (mPresent[slot] != 0) {
+        mPresent[slot] = 0;
+        ++mVersions[slot];
+      }
+    }
+  }
+
+  /**
+   * The blackboard looked up for keys without a value.
+   * @return The parent, nullptr if there is none.
+   */
+  const Blackboard* parent() const {
+    return mParent;
+  }
+
+  /**
+   * Change the blackboard looked up for keys without a value.
+   * @param parent The new parent, nullptr for none. Must use the same schema.
+   */
+  void setParent(const Blackboard* parent) {
+    mParent = parent;
+  }
+
+  /**
+   * The keys of the blackboard.
+   */
+  const BlackboardSchema& schema() const {
+    return *mSchema;
+  }
+
+ private:
+  /// Allocator of the values, versions and presence of the keys, counted when CppAIKit_INSTRUMENTATION is defined.
+  template<typename T>
+  using Allocator = detail::ModuleAllocator<T, InstrumentedModule::Blackboard, std::pmr::polymorphic_allocator<T>>;
+
+  template<typename T>
+  using Vector = std::vector<T, Allocator<T>>;
+
+  /// Grow the storage to the keys of the schema, which can gain keys after the blackboard was created.
+  void reserve() {
+    const std::size_t words = (mSchema->storageSize() + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+    mStorage.resize(words * sizeof(std::max_align_t));
+    mVersions.resize(mSchema->keyCount(), 0);
+    mPresent.resize(mSchema->keyCount(), 0);
+  }
+
+  /**
+   * Raw bytes aligned for any value.
+   */
+  struct Storage {
+    explicit Storage(std::pmr::memory_resource* resource) : words(Allocator<std::max_align_t>(resource)) {}
+
+    unsigned char* data() { return reinterpret_cast<unsigned char*>(words.data()); }
+    const unsigned char* data() const { return reinterpret_cast<const unsigned char*>(words.data()); }
+    void resize(std::size_t bytes) { words.resize(bytes / sizeof(std::max_align_t)); }
+
+    Vector<std::max_align_t> words;
+  };
+
+  const BlackboardSchema* mSchema;
+  const Blackboard* mParent;
+  Storage mStorage; ///< Values of all keys, at the offsets of the schema.
+  Vector<std::uint32_t> mVersions; ///< Version of each key.
+  Vector<std::uint8_t> mPresent; ///< 1 for keys with a value.
+};
+
+}
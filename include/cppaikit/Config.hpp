@@ -4,3 +4,21 @@
 #define CppAIKit_VERSION_MINOR 0
 #define CppAIKit_VERSION_PATCH 1
 #define CppAIKit_VERSION "0.0.1"
+
+/**
+ * Allocation instrumentation, disabled by default.
+ * Uncomment (or define on the command line) to make every fsm::FSM count the allocations made on its memory resource
+ * and every other module count the allocations of its containers, see aikit::CountingResource,
+ * fsm::FSM::allocationStats() and aikit::moduleAllocationStats().
+ * @attention Every translation unit of a program must agree on it, as it changes the layout of the instrumented
+ * classes.
+ */
+// #define CppAIKit_INSTRUMENTATION
+
+/**
+ * Transition tracing, disabled by default.
+ * Uncomment (or define on the command line) to record every change of current state of every fsm::FSM on per thread
+ * ring buffers, see aikit::trace::writeChromeTrace().
+ * @attention Every translation unit of a program must agree on it, as it changes the layout of fsm::FSM.
+ */
+// #define CppAIKit_TRACING
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "Config.hpp"
+
+namespace aikit {
+
+/**
+ * Modules whose allocations are aggregated by aikit::CountingResource and aikit::CountingAllocator, see
+ * moduleAllocationStats().
+ */
+enum class InstrumentedModule : std::uint8_t {
+  User, ///< Counting resources created by the user.
+  FSM, ///< Resources of fsm::FSM instances, including the one of each fsm::StackFSM.
+  HFSM, ///< Containers and states of fsm::HFSM instances.
+  FSMPool, ///< Containers and states of fsm::FSMPool instances.
+  BehaviorTree, ///< Containers of bt::BehaviorTree, its builder and bt::EventDrivenExecutor.
+  GOAP, ///< Containers of goap::Planner, its searches, goap::PlanCache and goap::BlackboardFacts.
+  Blackboard, ///< Containers of aikit::BlackboardSchema and aikit::Blackboard.
+  Utility, ///< Containers of utility::Scorer.
+  Count ///< Number of modules, not a module.
+};
+
+/**
+ * Counters of the allocations made on a memory resource.
+ */
+struct AllocationStats {
+  std::uint64_t allocations = 0; ///< Number of calls to allocate().
+  std::uint64_t deallocations = 0; ///< Number of calls to deallocate().
+  std::uint64_t bytes = 0; ///< Bytes requested by all calls to allocate().
+  std::uint64_t liveBytes = 0; ///< Bytes allocated and not deallocated yet.
+  std::uint64_t peakBytes = 0; ///< Highest value of liveBytes.
+};
+
+namespace detail {
+
+/// Counters of a module, shared by the machines of all threads.
+struct ModuleCounters {
+  std::atomic<std::uint64_t> allocations{0};
+  std::atomic<std::uint64_t> deallocations{0};
+  std::atomic<std::uint64_t> bytes{0};
+  std::atomic<std::uint64_t> liveBytes{0};
+  std::atomic<std::uint64_t> peakBytes{0};
+
+  void allocated(std::uint64_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    const std::uint64_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+  }
+
+  void deallocated(std::uint64_t size) {
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+    liveBytes.fetch_sub(size, std::memory_order_relaxed);
+  }
+};
+
+inline ModuleCounters& moduleCounters(InstrumentedModule module) {
+  static std::array<ModuleCounters, static_cast<std::size_t>(InstrumentedModule::Count)> counters;
+  return counters[static_cast<std::size_t>(module)];
+}
+
+#ifdef CppAIKit_INSTRUMENTATION
+/// Memory resource adding its allocations to the totals of a module, forwarding to std::pmr::new_delete_resource().
+class ModuleResource : public std::pmr::memory_resource {
+ public:
+  ModuleCounters* counters = nullptr;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void* memory = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    counters->allocated(bytes);
+    return memory;
+  }
+
+  void do_deallocate(void* memory, std::size_t bytes, std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+    counters->deallocated(bytes);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+#endif
+
+/**
+ * Resource of the pmr containers of a module created without one (e.g. the indices of fsm::storage): counting on the
+ * totals of the module when CppAIKit_INSTRUMENTATION is defined, the default resource otherwise.
+ */
+inline std::pmr::memory_resource* moduleResource([[maybe_unused]] InstrumentedModule module) {
+#ifdef CppAIKit_INSTRUMENTATION
+  static std::array<ModuleResource, static_cast<std::size_t>(InstrumentedModule::Count)> resources = [] {
+    std::array<ModuleResource, static_cast<std::size_t>(InstrumentedModule::Count)> created;
+    for (std::size_t index = 0; index < created.size(); ++index) {
+      created[index].counters = &moduleCounters(static_cast<InstrumentedModule>(index));
+    }
+    return created;
+  }();
+  return &resources[static_cast<std::size_t>(module)];
+#else
+  return std::pmr::get_default_resource();
+#endif
+}
+
+}
+
+/**
+ * Allocator forwarding to another one, adding its allocations to the totals of a module.
+ * The library containers use it when CppAIKit_INSTRUMENTATION is defined, see moduleAllocationStats().
+ * @tparam T Type of the elements allocated.
+ * @tparam Module Module whose totals count the allocations.
+ * @tparam TUpstream Allocator the allocations are forwarded to, its propagation and comparison are kept.
+ */
+template<typename T, InstrumentedModule Module, typename TUpstream = std::allocator<T>>
+class CountingAllocator {
+  typedef std::allocator_traits<TUpstream> Traits;
+
+ public:
+  typedef T value_type;
+  typedef typename Traits::propagate_on_container_copy_assignment propagate_on_container_copy_assignment;
+  typedef typename Traits::propagate_on_container_move_assignment propagate_on_container_move_assignment;
+  typedef typename Traits::propagate_on_container_swap propagate_on_container_swap;
+  typedef typename Traits::is_always_equal is_always_equal;
+
+  template<typename U>
+  struct rebind {
+    typedef CountingAllocator<U, Module, typename Traits::template rebind_alloc<U>> other;
+  };
+
+  CountingAllocator() = default;
+
+  /**
+   * Create an allocator forwarding to \a upstream.
+   */
+  CountingAllocator(const TUpstream& upstream) : mUpstream(upstream) {}
+
+  template<typename U, typename TOtherUpstream>
+  CountingAllocator(const CountingAllocator<U, Module, TOtherUpstream>& other) : mUpstream(other.upstream()) {}
+
+  T* allocate(std::size_t count) {
+    T* memory = Traits::allocate(mUpstream, count);
+    detail::moduleCounters(Module).allocated(count * sizeof(T));
+    return memory;
+  }
+
+  void deallocate(T* memory, std::size_t count) {
+    Traits::deallocate(mUpstream, memory, count);
+    detail::moduleCounters(Module).deallocated(count * sizeof(T));
+  }
+
+  CountingAllocator select_on_container_copy_construction() const {
+    return CountingAllocator(Traits::select_on_container_copy_construction(mUpstream));
+  }
+
+  /**
+   * The allocator the allocations are forwarded to.
+   */
+  const TUpstream& upstream() const {
+    return mUpstream;
+  }
+
+  template<typename U, typename TOtherUpstream>
+  bool operator==(const CountingAllocator<U, Module, TOtherUpstream>& other) const {
+    return mUpstream == other.upstream();
+  }
+
+  template<typename U, typename TOtherUpstream>
+  bool operator!=(const CountingAllocator<U, Module, TOtherUpstream>& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  TUpstream mUpstream;
+};
+
+namespace detail {
+
+/**
+ * Allocator of the containers of a module: a CountingAllocator when CppAIKit_INSTRUMENTATION is defined, \a TUpstream
+ * otherwise.
+ */
+#ifdef CppAIKit_INSTRUMENTATION
+template<typename T, InstrumentedModule Module, typename TUpstream = std::allocator<T>>
+using ModuleAllocator = CountingAllocator<T, Module, TUpstream>;
+#else
+template<typename T, InstrumentedModule Module, typename TUpstream = std::allocator<T>>
+using ModuleAllocator = TUpstream;
+#endif
+
+/// Vector of a module, std::vector unless instrumented.
+template<typename T, InstrumentedModule Module>
+using ModuleVector = std::vector<T, ModuleAllocator<T, Module>>;
+
+#ifdef CppAIKit_INSTRUMENTATION
+/// Deleter of ModulePtr, remembering the size of the object since it may be of a type derived from T.
+template<typename T, InstrumentedModule Module>
+struct ModuleDeleter {
+  void operator()(T* object) const {
+    delete object;
+    moduleCounters(Module).deallocated(bytes);
+  }
+
+  std::size_t bytes = 0;
+};
+#else
+template<typename T, InstrumentedModule Module>
+using ModuleDeleter = std::default_delete<T>;
+#endif
+
+/// Owning pointer of a module, std::unique_ptr unless instrumented.
+template<typename T, InstrumentedModule Module>
+using ModulePtr = std::unique_ptr<T, ModuleDeleter<T, Module>>;
+
+/**
+ * Create a \a TCreated owned by a ModulePtr to \a T, counting it on the totals of \a Module when instrumented.
+ */
+template<typename T, InstrumentedModule Module, typename TCreated = T, typename... TArgs>
+ModulePtr<T, Module> makeModulePtr(TArgs&&... args) {
+#ifdef CppAIKit_INSTRUMENTATION
+  ModulePtr<T, Module> object(new TCreated(std::forward<TArgs>(args)...), ModuleDeleter<T, Module>{sizeof(TCreated)});
+  moduleCounters(Module).allocated(sizeof(TCreated));
+  return object;
+#else
+  return ModulePtr<T, Module>(new TCreated(std::forward<TArgs>(args)...));
+#endif
+}
+
+}
+
+/**
+ * Totals of all counting resources and allocators of a module, alive or destroyed.
+ * When CppAIKit_INSTRUMENTATION is defined every module of the library counts its allocations here, fsm::FSM also
+ * counts them per instance.
+ * @param module The module.
+ * @return A copy of the counters.
+ * @note Thread safe, resources of a module can be used concurrently from different threads.
+ */
+inline AllocationStats moduleAllocationStats(InstrumentedModule module) {
+  const auto& counters = detail::moduleCounters(module);
+  AllocationStats stats;
+  stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+  stats.deallocations = counters.deallocations.load(std::memory_order_relaxed);
+  stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+  stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+  stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+/**
+ * Reset the totals of a module, as in CountingResource::resetStats().
+ * @param module The module.
+ */
+inline void resetModuleAllocationStats(InstrumentedModule module) {
+  auto& counters = detail::moduleCounters(module);
+  counters.allocations.store(0, std::memory_order_relaxed);
+  counters.deallocations.store(0, std::memory_order_relaxed);
+  counters.bytes.store(0, std::memory_order_relaxed);
+  counters.peakBytes.store(counters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * Memory resource forwarding to another one, counting allocations, bytes and peak memory.
+ * Counters are kept for the resource itself and added to the totals of its module, so the memory of a single instance
+ * and of a whole module can be told apart.
+ * Any class taking a std::pmr::memory_resource (fsm::FSM, aikit::Blackboard, aikit::MPSCQueue) can be given one. When
+ * CppAIKit_INSTRUMENTATION is defined on Config.hpp, each fsm::FSM wraps its resource on one automatically.
+ * @note The counters of the resource itself are not atomic, like most memory resources it must be used from one
+ * thread at a time. The totals of the modules are atomic.
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  /**
+   * Create a counting resource.
+   * @param upstream Resource the allocations are forwarded to, must outlive the counting resource.
+   * @param module Module whose totals also count the allocations.
+   */
+  explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource(),
+                            InstrumentedModule module = InstrumentedModule::User)
+      : mUpstream(upstream), mModule(&detail::moduleCounters(module)) {}
+
+  CountingResource(const CountingResource&) = delete;
+  CountingResource& operator=(const CountingResource&) = delete;
+
+  /**
+   * The counters of this resource.
+   */
+  const AllocationStats& stats() const {
+    return mStats;
+  }
+
+  /**
+   * Reset the number of allocations, deallocations and bytes to zero and the peak to the memory in use.
+   * Memory in use is not reset, so memory allocated before a reset can still be deallocated after it.
+   * @note Useful to check that a warmed up instance stops allocating.
+   */
+  void resetStats() {
+    mStats.allocations = 0;
+    mStats.deallocations = 0;
+    mStats.bytes = 0;
+    mStats.peakBytes = mStats.liveBytes;
+  }
+
+  /**
+   * The resource the allocations are forwarded to.
+   */
+  std::pmr::memory_resource* upstream() const {
+    return mUpstream;
+  }
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void* memory = mUpstream->allocate(bytes, alignment);
+    ++mStats.allocations;
+    mStats.bytes += bytes;
+    mStats.liveBytes += bytes;
+    mStats.peakBytes = (mStats.liveBytes > mStats.peakBytes) ? mStats.liveBytes : mStats.peakBytes;
+    mModule->allocated(bytes);
+    return memory;
+  }
+
+  void do_deallocate(void* memory, std::size_t bytes, std::size_t alignment) override {
+    mUpstream->deallocate(memory, bytes, alignment);
+    ++mStats.deallocations;
+    mStats.liveBytes -= bytes;
+    mModule->deallocated(bytes);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* mUpstream;
+  detail::ModuleCounters* mModule; ///< Totals of the module of the resource.
+  AllocationStats mStats;
+};
+
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace aikit {
+
+/**
+ * Bounded lock free queue with many producers and a single consumer.
+ * Elements live on a ring buffer allocated once on construction, each cell has a sequence number telling if it is
+ * ready to be written or read, so producers only contend on a single atomic counter and never allocate.
+ * @tparam T Type of the elements, must be default constructible and move assignable.
+ * @note tryPush() can be called concurrently from any number of threads, tryPop() only from one thread at a time.
+ * @note The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class MPSCQueue {
+  static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>,
+                "MPSCQueue elements must be default constructible and move assignable");
+
+ public:
+  /**
+   * Create the queue.
+   * @param capacity Maximum number of elements on the queue, rounded up to a power of two.
+   * @param resource Memory resource the ring buffer is allocated from, must outlive the queue.
+   */
+  explicit MPSCQueue(std::size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : mResource(resource), mCapacity(roundUpPow2(capacity)), mMask(mCapacity - 1) {
+    mCells = static_cast<Cell*>(mResource->allocate(sizeof(Cell) * mCapacity, alignof(Cell)));
+    for (std::size_t i = 0; i < mCapacity; ++i) {
+      new (&mCells[i]) Cell();
+      mCells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  ~MPSCQueue() {
+    for (std::size_t i = 0; i < mCapacity; ++i) {
+      mCells[i].~Cell();
+    }
+    mResource->deallocate(mCells, sizeof(Cell) * mCapacity, alignof(Cell));
+  }
+
+  /**
+   * Push \a value to the back of the queue.
+   * @param value Element being pushed.
+   * @return False if the queue is full, in which case \a value is not pushed.
+   * @note Thread safe, can be called concurrently with other calls to tryPush() and with tryPop().
+   */
+  bool tryPush(T value) {
+    std::size_t position = mEnqueuePosition.value.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = mCells[position & mMask];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+      if (difference == 0) {
+        if (mEnqueuePosition.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The consumer did not read the cell yet, the queue is full
+        return false;
+      } else {
+        position = mEnqueuePosition.value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Pop the element on the front of the queue.
+   * @param value Receives the element popped.
+   * @return False if the queue is empty, in which case \a value is not changed.
+   * @attention Not thread safe with other calls to tryPop(), there must be a single consumer.
+   * @note An element being pushed concurrently may only become visible on a later call.
+   */
+  bool tryPop(T& value) {
+    Cell& cell = mCells[mDequeuePosition & mMask];
+    const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+    if (sequence != mDequeuePosition + 1) {
+      return false;
+    }
+
+    value = std::move(cell.value);
+    cell.sequence.store(mDequeuePosition + mCapacity, std::memory_order_release);
+    ++mDequeuePosition;
+    return true;
+  }
+
+  /**
+   * Maximum number of elements on the queue.
+   */
+  std::size_t capacity() const {
+    return mCapacity;
+  }
+
+  /**
+   * The memory resource used by the queue.
+   * @return Memory resource given on construction.
+   */
+  std::pmr::memory_resource* resource() const {
+    return mResource;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence{0}; ///< Position the cell is ready for: written at position, read at + 1.
+    T value{};
+  };
+
+  /// Counter on its own cache line, so producers do not invalidate the line read by the consumer.
+  struct alignas(64) Position {
+    std::atomic<std::size_t> value{0};
+  };
+
+  static std::size_t roundUpPow2(std::size_t value) {
+    std::size_t pow2 = 1;
+    while (pow2 < value) {
+      pow2 <<= 1;
+    }
+    return pow2;
+  }
+
+  std::pmr::memory_resource* mResource;
+  std::size_t mCapacity;
+  std::size_t mMask;
+  Cell* mCells = nullptr;
+  Position mEnqueuePosition; ///< Next position written by producers.
+  alignas(64) std::size_t mDequeuePosition = 0; ///< Next position read, only touched by the consumer.
+};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace aikit {
+
+/**
+ * Non owning view over a contiguous sequence of objects, a minimal replacement for C++20 std::span.
+ * @tparam T Type of the elements.
+ */
+template<typename T>
+class Span {
+ public:
+  typedef T element_type;
+  typedef T* iterator;
+
+  constexpr Span() = default;
+
+  /**
+   * Create a view over \a size elements starting at \a data.
+   */
+  constexpr Span(T* data, std::size_t size) : mData(data), mSize(size) {}
+
+  /**
+   * Create a view over all elements of a contiguous container (e.g. std::vector or std::array).
+   */
+  template<typename TContainer,
+           typename = std::enable_if_t<std::is_convertible_v<decltype(std::declval<TContainer&>().data()), T*>>>
+  constexpr Span(TContainer& container) : mData(container.data()), mSize(container.size()) {}
+
+  constexpr T* data() const { return mData; }
+
+  constexpr std::size_t size() const { return mSize; }
+
+  constexpr bool empty() const { return mSize == 0; }
+
+  constexpr T& operator[](std::size_t index) const { return mData[index]; }
+
+  constexpr iterator begin() const { return mData; }
+
+  constexpr iterator end() const { return mData + mSize; }
+
+ private:
+  T* mData = nullptr;
+  std::size_t mSize = 0;
+};
+
+}
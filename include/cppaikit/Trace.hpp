@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CppAIKit_TRACE_RDTSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CppAIKit_TRACE_RDTSC
+#endif
+
+#include "Config.hpp"
+
+namespace aikit::trace {
+
+/// Value of Record::from, Record::to and Record::event when there was no state or no event.
+constexpr std::uint32_t kNone = ~std::uint32_t{0};
+
+/**
+ * A transition of a machine, as returned by collect().
+ */
+struct Record {
+  std::uint64_t timestamp; ///< Nanoseconds since the first record of the program.
+  std::uint32_t machine; ///< Id of the machine, see fsm::FSM::traceId().
+  std::uint32_t from; ///< Index of the handle of the state left, kNone if there was no current state.
+  std::uint32_t to; ///< Index of the handle of the state entered, kNone if the machine was left without current state.
+  std::uint32_t event; ///< Index of the handle of the event dispatched, kNone if the transition was not dispatched.
+};
+
+namespace detail {
+
+/**
+ * Ring buffer of the records of one thread, written without locks by its thread and read by collect().
+ * Each record is encoded in three words: timestamp, machine and event, from and to. When full, the oldest records are
+ * overwritten.
+ * A push announces the record it writes on \a started before its first store, so collect() can tell which records
+ * may have been rewritten while it copied them.
+ */
+struct Buffer {
+  static constexpr std::size_t kWords = 3;
+
+  explicit Buffer(std::size_t capacity)
+      : words(new std::atomic<std::uint64_t>[capacity * kWords]), mask(capacity - 1) {}
+
+  void push(std::uint64_t timestamp, std::uint64_t machineEvent, std::uint64_t fromTo) {
+    const std::uint64_t position = head.load(std::memory_order_relaxed);
+    started.store(position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::atomic<std::uint64_t>* record = &words[(position & mask) * kWords];
+    record[0].store(timestamp, std::memory_order_relaxed);
+    record[1].store(machineEvent, std::memory_order_relaxed);
+    record[2].store(fromTo, std::memory_order_relaxed);
+    head.store(position + 1, std::memory_order_release);
+  }
+
+  std::unique_ptr<std::atomic<std::uint64_t>[]> words;
+  std::uint64_t mask;
+  std::atomic<std::uint64_t> head{0}; ///< Number of records ever pushed.
+  std::atomic<std::uint64_t> started{0}; ///< Number of records whose push started, head + 1 during a push.
+  std::uint64_t tail = 0; ///< Records before it were collected, only used by collect().
+  std::atomic<bool> owned{true}; ///< False once its thread exited, then reused by a new thread if of the same size.
+};
+
+/// Time source of the records, the time stamp counter where available since it is a few times cheaper to read.
+inline std::uint64_t now() {
+#ifdef CppAIKit_TRACE_RDTSC
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * All buffers ever created, and the time both clocks had on creation, used to convert ticks to nanoseconds.
+ */
+struct Registry {
+  Registry() : startTicks(now()), startTime(std::chrono::steady_clock::now()) {}
+
+  Buffer* acquire() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (auto& buffer : buffers) {
+      bool expected = false;
+      if (buffer->mask + 1 == capacity && buffer->owned.compare_exchange_strong(expected, true)) {
+        return buffer.get();
+      }
+    }
+    buffers.emplace_back(std::make_unique<Buffer>(capacity));
+    return buffers.back().get();
+  }
+
+  /// Nanoseconds per tick of now(), measured over at least a millisecond.
+  double nanosecondsPerTick() const {
+#ifdef CppAIKit_TRACE_RDTSC
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    while (elapsed < std::chrono::milliseconds(1)) {
+      elapsed = std::chrono::steady_clock::now() - startTime;
+    }
+    const auto ticks = now() - startTicks;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           static_cast<double>(ticks);
+#else
+    return static_cast<double>(std::chrono::steady_clock::period::num) * 1e9 /
+           static_cast<double>(std::chrono::steady_clock::period::den);
+#endif
+  }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  std::size_t capacity = 4096; ///< Records of buffers created from now on, a power of two.
+  const std::uint64_t startTicks;
+  const std::chrono::steady_clock::time_point startTime;
+  std::atomic<std::uint32_t> nextMachine{0};
+};
+
+inline Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+/// Returns the buffer of its thread to the registry when the thread exits.
+struct ThreadBuffer {
+  ThreadBuffer() : buffer(registry().acquire()) {}
+  ~ThreadBuffer() { buffer->owned.store(false, std::memory_order_release); }
+
+  Buffer* buffer;
+};
+
+inline Buffer& threadBuffer() {
+  static thread_local ThreadBuffer local;
+  return *local.buffer;
+}
+
+}
+
+/**
+ * Set the number of records kept per thread, for threads that record their first transition after the call.
+ * @param records Number of records, rounded up to a power of two.
+ */
+inline void setBufferCapacity(std::size_t records) {
+  std::size_t capacity = 1;
+  while (capacity < records) {
+    capacity *= 2;
+  }
+
+  auto& registry = detail::registry();
+  const std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.capacity = capacity;
+}
+
+/**
+ * A new id for a machine, unique in the program.
+ * @note Called by fsm::FSM on construction when CppAIKit_TRACING is defined.
+ */
+inline std::uint32_t newMachineId() {
+  return detail::registry().nextMachine.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Record a transition on the buffer of the calling thread.
+ * Lock free and wait free: a few stores on a buffer owned by the thread.
+ * @param machine Id of the machine.
+ * @param from Index of the state left, kNone for none.
+ * @param to Index of the state entered, or kNone if the machine was left without current state.
+ * @param event Index of the event dispatched, kNone for none.
+ * @note Called by fsm::FSM on every change of current state when CppAIKit_TRACING is defined.
+ */
+inline void recordTransition(std::uint32_t machine, std::uint32_t from, std::uint32_t to, std::uint32_t event) {
+  detail::threadBuffer().push(detail::now(), (std::uint64_t{machine} << 32) | event,
+                              (std::uint64_t{from} << 32) | to);
+}
+
+/**
+ * Move the records of all threads not collected yet to \a records, oldest first.
+ * @param records Receives the records, appended.
+ * @return Number of records appended.
+ * @note Can be called while other threads record. Records overwritten before being collected are lost, make the
+ * buffers large enough for the time between calls.
+ */
+inline std::size_t collect(std::vector<Record>& records) {
+  auto& registry = detail::registry();
+  const double nanosecondsPerTick = registry.nanosecondsPerTick();
+  const std::size_t first = records.size();
+
+  const std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto& buffer : registry.buffers) {
+    const std::uint64_t capacity = buffer->mask + 1;
+    const std::uint64_t end = buffer->head.load(std::memory_order_acquire);
+    const std::uint64_t begin = std::max(buffer->tail, (end > capacity) ? end - capacity : 0);
+    const std::size_t copied = records.size();
+
+    for (std::uint64_t position = begin; position < end; ++position) {
+      const std::atomic<std::uint64_t>* words = &buffer->words[(position & buffer->mask) * detail::Buffer::kWords];
+      const std::uint64_t ticks = words[0].load(std::memory_order_relaxed);
+      const std::uint64_t machineEvent = words[1].load(std::memory_order_relaxed);
+      const std::uint64_t fromTo = words[2].load(std::memory_order_relaxed);
+      const double elapsed = static_cast<double>(ticks - registry.startTicks) * nanosecondsPerTick;
+      records.push_back({static_cast<std::uint64_t>(elapsed), static_cast<std::uint32_t>(machineEvent >> 32),
+                         static_cast<std::uint32_t>(fromTo >> 32), static_cast<std::uint32_t>(fromTo),
+                         static_cast<std::uint32_t>(machineEvent)});
+    }
+
+    // Records overwritten by the thread while being copied may be torn, drop them. A push of record n rewrites the
+    // slot of record n - capacity after announcing n + 1 on started, so records before started - capacity are unsafe
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t started = buffer->started.load(std::memory_order_relaxed);
+    const std::uint64_t overwritten = (started > capacity) ? started - capacity : 0;
+    if (overwritten > begin) {
+      const auto torn = static_cast<std::ptrdiff_t>(std::min(overwritten, end) - begin);
+      records.erase(records.begin() + static_cast<std::ptrdiff_t>(copied),
+                    records.begin() + static_cast<std::ptrdiff_t>(copied) + torn);
+    }
+    buffer->tail = end;
+  }
+
+  return records.size() - first;
+}
+
+/**
+ * Collect the records of all threads and write them as a Chrome trace, readable by chrome://tracing and Perfetto.
+ * Each transition is an instant event on the track of its machine, named after the state entered ("no state" when
+ * the machine was left without current state), with the handle indices of the states and the event as arguments.
+ * @param output Stream receiving the JSON.
+ * @return Number of transitions written.
+ * @sa collect()
+ */
+inline std::size_t writeChromeTrace(std::ostream& output) {
+  std::vector<Record> records;
+  collect(records);
+
+  const auto index = [](std::uint32_t value) { return (value == kNone) ? std::string("null") : std::to_string(value); };
+
+  output << "{\"traceEvents\":[";
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    const Record& record = records[i];
+    const std::string name = (record.to == kNone) ? std::string("no state") : "state " + std::to_string(record.to);
+    output << ((i == 0) ? "\n" : ",\n") << "{\"name\":\"" << name
+           << "\",\"cat\":\"fsm\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << record.machine
+           << ",\"ts\":" << record.timestamp / 1000 << '.' << std::to_string(1000 + record.timestamp % 1000).substr(1)
+           << ",\"args\":{\"from\":" << index(record.from) << ",\"to\":" << index(record.to)
+           << ",\"event\":" << index(record.event) << "}}";
+  }
+  output << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+  return records.size();
+}
+
+/**
+ * Collect the records of all threads and write them as a Chrome trace file.
+ * @param path Path of the file, overwritten.
+ * @return False if the file could not be written.
+ * @sa writeChromeTrace(std::ostream&)
+ */
+inline bool writeChromeTrace(const std::string& path) {
+  std::ofstream file(path);
+  if (!file) {
+    return false;
+  }
+
+  writeChromeTrace(file);
+  return static_cast<bool>(file);
+}
+
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aikit {
+
+/**
+ * Thread pool running parallel loops with work stealing.
+ * The range of a loop is split in chunks that are distributed evenly between the threads. A thread that runs out of
+ * chunks steals chunks from the end of the queue of other threads, so uneven work is balanced automatically.
+ * The calling thread takes part on the loop, so a pool with N threads starts N - 1 threads.
+ * @note Only one loop can run at a time, parallelFor() must not be called concurrently or from inside a loop.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * Create the pool.
+   * @param threadCount Number of threads running loops, including the calling thread. Zero uses one thread per
+   * hardware thread.
+   */
+  explicit WorkStealingPool(std::size_t threadCount = 0)
+      : mQueues(std::max<std::size_t>(1, (threadCount != 0) ? threadCount : std::thread::hardware_concurrency())) {
+    mThreads.reserve(mQueues.size() - 1);
+    for (std::size_t worker = 1; worker < mQueues.size(); ++worker) {
+      mThreads.emplace_back([this, worker] { workerLoop(worker); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+    }
+    mStartCondition.notify_all();
+
+    for (auto& thread : mThreads) {
+      thread.join();
+    }
+  }
+
+  /**
+   * Number of threads running loops, including the calling thread.
+   */
+  std::size_t threadCount() const {
+    return mQueues.size();
+  }
+
+  /**
+   * Run \a fn over the range [0, \a count) split in chunks of \a chunkSize, blocking until all chunks are done.
+   * @param count Number of elements of the range.
+   * @param chunkSize Number of consecutive elements given to each call of \a fn.
+   * @param fn Function called as fn(begin, end) for each chunk, from any of the threads of the pool.
+   * @note Chunks boundaries do not depend on the number of threads, only which thread runs each chunk does.
+   * @note If \a fn throws, chunks not started yet are skipped and the first exception thrown is rethrown on the
+   * calling thread once every thread stopped running the loop.
+   * @attention The range must have at most 2^32 - 1 chunks.
+   */
+  template<typename TFn>
+  void parallelFor(std::size_t count, std::size_t chunkSize, TFn&& fn) {
+    chunkSize = std::max<std::size_t>(1, chunkSize);
+    const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (chunkCount == 0) {
+      return;
+    }
+    assert(chunkCount <= std::numeric_limits<std::uint32_t>::max() && "Chunk indices are 32 bits, use larger chunks");
+
+    using TFnNoRef = std::remove_reference_t<TFn>;
+    Job job{};
+    job.context = const_cast<void*>(static_cast<const void*>(&fn));
+    job.run = [](void* context, std::size_t begin, std::size_t end) { (*static_cast<TFnNoRef*>(context))(begin, end); };
+    job.count = count;
+    job.chunkSize = chunkSize;
+
+    // Without other threads or with a single chunk there is nothing to distribute
+    if (mThreads.empty() || chunkCount == 1) {
+      job.run(job.context, 0, count);
+      return;
+    }
+
+    const std::size_t workers = mQueues.size();
+    for (std::size_t worker = 0; worker < workers; ++worker) {
+      const auto begin = static_cast<std::uint32_t>(chunkCount * worker / workers);
+      const auto end = static_cast<std::uint32_t>(chunkCount * (worker + 1) / workers);
+      mQueues[worker].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mJob = job;
+      mPendingWorkers = workers;
+      mError = nullptr;
+      mFailed.store(false, std::memory_order_relaxed);
+      ++mEpoch;
+    }
+    mStartCondition.notify_all();
+
+    runChunks(0, job);
+    finishWorker();
+
+    // Join barrier, no thread is touching the job after this point. Always reached, runChunks() does not throw
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCondition.wait(lock, [this] { return mPendingWorkers == 0; });
+    if (mError) {
+      std::rethrow_exception(std::exchange(mError, nullptr));
+    }
+  }
+
+ private:
+  struct Job {
+    void* context;
+    void (*run)(void* context, std::size_t begin, std::size_t end);
+    std::size_t count;
+    std::size_t chunkSize;
+  };
+
+  /// Chunks of a thread, begin and end packed in a single atomic word so both ends can be taken lock free.
+  struct alignas(64) Queue {
+    std::atomic<std::uint64_t> range{0};
+  };
+
+  static std::uint64_t pack(std::uint32_t begin, std::uint32_t end) {
+    return (std::uint64_t{begin} << 32) | end;
+  }
+
+  static std::uint32_t beginOf(std::uint64_t range) {
+    return static_cast<std::uint32_t>(range >> 32);
+  }
+
+  static std::uint32_t endOf(std::uint64_t range) {
+    return static_cast<std::uint32_t>(range);
+  }
+
+  /// Owner takes chunks from the front of its queue.
+  bool popFront(Queue& queue, std::uint32_t& chunk) {
+    std::uint64_t range = queue.range.load(std::memory_order_relaxed);
+    while (beginOf(range) < endOf(range)) {
+      if (queue.range.compare_exchange_weak(range, pack(beginOf(range) + 1, endOf(range)),
+                                            std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        chunk = beginOf(range);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Thieves take chunks from the back of other queues.
+  bool popBack(Queue& queue, std::uint32_t& chunk) {
+    std::uint64_t range = queue.range.load(std::memory_order_relaxed);
+    while (beginOf(range) < endOf(range)) {
+      if (queue.range.compare_exchange_weak(range, pack(beginOf(range), endOf(range) - 1),
+                                            std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        chunk = endOf(range) - 1;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void runChunk(const Job& job, std::uint32_t chunk) {
+    const std::size_t begin = chunk * job.chunkSize;
+    job.run(job.context, begin, std::min(job.count, begin + job.chunkSize));
+  }
+
+  /// Run chunks until every queue is empty or a chunk threw, the exception is kept for parallelFor() to rethrow.
+  void runChunks(std::size_t worker, const Job& job) noexcept {
+    try {
+      std::uint32_t chunk = 0;
+      while (!failed() && popFront(mQueues[worker], chunk)) {
+        runChunk(job, chunk);
+      }
+
+      // Steal from the other threads until every queue is empty
+      bool stole = true;
+      while (stole && !failed()) {
+        stole = false;
+        for (std::size_t offset = 1; offset < mQueues.size(); ++offset) {
+          Queue& victim = mQueues[(worker + offset) % mQueues.size()];
+          while (!failed() && popBack(victim, chunk)) {
+            runChunk(job, chunk);
+            stole = true;
+          }
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!mError) {
+        mError = std::current_exception();
+      }
+      mFailed.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  bool failed() const {
+    return mFailed.load(std::memory_order_relaxed);
+  }
+
+  void finishWorker() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (--mPendingWorkers == 0) {
+      mDoneCondition.notify_one();
+    }
+  }
+
+  void workerLoop(std::size_t worker) {
+    std::uint64_t lastEpoch = 0;
+    for (;;) {
+      Job job{};
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStartCondition.wait(lock, [&] { return mStopping || mEpoch != lastEpoch; });
+        if (mStopping) {
+          return;
+        }
+        lastEpoch = mEpoch;
+        job = mJob;
+      }
+
+      runChunks(worker, job);
+      finishWorker();
+    }
+  }
+
+  std::vector<Queue> mQueues; ///< Chunks of each thread, index 0 belongs to the thread calling parallelFor().
+  std::vector<std::thread> mThreads;
+
+  std::mutex mMutex; ///< Protects the fields below.
+  std::condition_variable mStartCondition;
+  std::condition_variable mDoneCondition;
+  Job mJob{};
+  std::uint64_t mEpoch = 0; ///< Incremented for every loop, wakes up the threads.
+  std::size_t mPendingWorkers = 0; ///< Threads still running the current loop.
+  std::exception_ptr mError; ///< First exception thrown by the current loop.
+  bool mStopping = false;
+  std::atomic<bool> mFailed{false}; ///< Set once a chunk of the current loop threw, read without the lock.
+};
+
+}
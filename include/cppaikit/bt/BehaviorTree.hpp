@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "../Span.hpp"
+#include "Status.hpp"
+
+namespace aikit::bt {
+
+/**
+ * Types of the nodes of a behavior tree.
+ */
+enum class NodeType : std::uint8_t {
+  Sequence, ///< Ticks children in order until one fails or is running.
+  Selector, ///< Ticks children in order until one succeeds or is running.
+  Parallel, ///< Ticks all children, succeeds when enough children succeed.
+  Inverter, ///< Swaps success and failure of its child.
+  Repeat, ///< Ticks its child again every time it succeeds, a number of times or forever.
+  Action, ///< Leaf calling a function that returns a bt::Status.
+  Condition ///< Leaf calling a function that returns a bool.
+};
+
+/**
+ * Observer aborts of a condition, which make the condition be evaluated again while some nodes are running.
+ * Only used by bt::EventDrivenExecutor, BehaviorTree::tick() evaluates conditions only when it reaches them.
+ */
+enum class Abort : std::uint8_t {
+  None, ///< The condition is evaluated only when reached.
+  Self, ///< Restarts the parent from the condition when its result changes while later siblings run.
+  LowerPriority, ///< Restarts the selector above the parent when the result changes while a later child runs.
+  Both ///< Both Self and LowerPriority.
+};
+
+/**
+ * Implementation for a Behavior Tree shared by many agents.
+ * The tree is stored as a single contiguous array of nodes in pre-order, children of a node are the range of nodes
+ * right after it, so no node is allocated on its own and ticking walks the array forward.
+ * The tree only holds the definition. Everything an agent needs to resume a running tree (the running child of each
+ * composite and the counters of repeats) is kept on a small per agent instance, an array of instanceSize() words
+ * given to tick(). A single tree can be ticked for any number of agents, each with its own instance.
+ * Trees are created with a BehaviorTree::Builder.
+ * @tparam TAgent Type of the agents running the tree, passed to the leaves.
+ * @note Sequences and selectors have memory: when a child is running, the next tick resumes from that child.
+ * @sa bt::Status
+ */
+template<typename TAgent>
+class BehaviorTree {
+ public:
+  typedef TAgent Agent_type;
+  typedef Status (*Action_type)(TAgent& agent);
+  typedef bool (*Condition_type)(TAgent& agent);
+
+  class Builder;
+
+  /**
+   * A node of the tree.
+   */
+  struct Node {
+    NodeType type;
+    std::uint32_t parent; ///< Index of the parent, kNoParent for the root.
+    std::uint32_t end; ///< One past the last node of the subtree, also the index of the next sibling.
+    std::uint32_t param; ///< Success threshold of a parallel, repetitions of a repeat or bt::Abort of a condition.
+    std::uint32_t slotBegin; ///< First word of the instance used by the subtree, the word of the node if it has one.
+    std::uint32_t slotEnd; ///< One past the last word of the instance used by the subtree.
+    Action_type action; ///< Function of an action.
+    Condition_type condition; ///< Function of a condition.
+  };
+
+  static constexpr std::uint32_t kNoParent = ~std::uint32_t{0};
+
+  /**
+   * Create an empty tree, which always fails.
+   */
+  BehaviorTree() = default;
+
+  /**
+   * Tick the tree for an agent.
+   * @param agent The agent passed to the leaves.
+   * @param instance State of the agent on this tree, instanceSize() words zero initialized before the first tick.
+   * @return Status of the root node.
+   * @note When the root finishes (succeeds or fails) the instance is back to its initial state.
+   */
+  Status tick(TAgent& agent, Span<std::uint32_t> instance) const {
+    if (mNodes.empty()) {
+      return Status::Failure;
+    }
+
+    return tickNode(0, agent, instance.data());
+  }
+
+  /**
+   * Number of words of the per agent instance.
+   * @return Size of the instance given to tick().
+   */
+  std::size_t instanceSize() const {
+    return mInstanceSize;
+  }
+
+  /**
+   * Reset an instance to its initial state, aborting any running node.
+   * @param instance The instance being reset.
+   */
+  static void resetInstance(Span<std::uint32_t> instance) {
+    std::fill(instance.begin(), instance.end(), 0u);
+  }
+
+  /**
+   * The nodes of the tree, in pre-order.
+   * @return All nodes, the root first.
+   */
+  Span<const Node> nodes() const {
+    return {mNodes.data(), mNodes.size()};
+  }
+
+  /**
+   * Number of nodes in the tree.
+   * @return The number of nodes in the tree.
+   */
+  std::size_t size() const {
+    return mNodes.size();
+  }
+
+ private:
+  template<typename T>
+  using Vector = detail::ModuleVector<T, InstrumentedModule::BehaviorTree>;
+
+  Status tickNode(std::uint32_t index, TAgent& agent, std::uint32_t* instance) const {
+    const Node& node = mNodes[index];
+
+    switch (node.type) {
+      case NodeType::Action:
+        return node.action(agent);
+
+      case NodeType::Condition:
+        return node.condition(agent) ? Status::Success : Status::Failure;
+
+      case NodeType::Sequence:
+      case NodeType::Selector: {
+        // The child where the composite stops: a failing one for sequences, a succeeding one for selectors
+        const Status stopStatus = (node.type == NodeType::Sequence) ? Status::Failure : Status::Success;
+        std::uint32_t& running = instance[node.slotBegin];
+
+        for (std::uint32_t child = (running != 0) ? running : index + 1; child < node.end; child = mNodes[child].end) {
+          const Status status = tickNode(child, agent, instance);
+          if (status == Status::Running) {
+            running = child;
+            return Status::Running;
+          }
+          if (status == stopStatus) {
+            running = 0;
+            return stopStatus;
+          }
+        }
+
+        running = 0;
+        return (stopStatus == Status::Failure) ? Status::Success : Status::Failure;
+      }
+
+      case NodeType::Parallel: {
+        std::uint32_t successes = 0;
+        std::uint32_t failures = 0;
+        std::uint32_t children = 0;
+        for (std::uint32_t child = index + 1; child < node.end; child = mNodes[child].end) {
+          const Status status = tickNode(child, agent, instance);
+          successes += (status == Status::Success) ? 1 : 0;
+          failures += (status == Status::Failure) ? 1 : 0;
+          ++children;
+        }
+
+        const std::uint32_t threshold = std::min(node.param, children);
+        if (successes >= threshold || children - failures < threshold) {
+          // Children still running are aborted
+          std::fill(instance + node.slotBegin, instance + node.slotEnd, 0u);
+          return (successes >= threshold) ? Status::Success : Status::Failure;
+        }
+        return Status::Running;
+      }
+
+      case NodeType::Inverter: {
+        if (index + 1 == node.end) {
+          return Status::Failure;
+        }
+
+        const Status status = tickNode(index + 1, agent, instance);
+        if (status == Status::Running) {
+          return status;
+        }
+        return (status == Status::Success) ? Status::Failure : Status::Success;
+      }
+
+      case NodeType::Repeat: {
+        if (index + 1 == node.end) {
+          return Status::Failure;
+        }
+
+        std::uint32_t& count = instance[node.slotBegin];
+        const Status status = tickNode(index + 1, agent, instance);
+        if (status == Status::Failure) {
+          count = 0;
+          return Status::Failure;
+        }
+        if (status == Status::Success && node.param != 0 && ++count == node.param) {
+          count = 0;
+          return Status::Success;
+        }
+        // Running child or more repetitions left, one repetition per tick
+        return Status::Running;
+      }
+    }
+
+    return Status::Failure;
+  }
+
+  Vector<Node> mNodes; ///< Nodes of the tree in pre-order.
+  std::size_t mInstanceSize = 0; ///< Number of words of the instance.
+};
+
+/**
+ * Creates a bt::BehaviorTree, node by node in pre-order.
+ * Composites and decorators are opened by their method and closed by end(), leaves are added to the node currently
+ * open. For example:
+ * @code
+ * auto tree = BehaviorTree<Agent>::Builder()
+ *     .selector()
+ *       .sequence()
+ *         .condition(isEnemyVisible)
+ *         .action(attack)
+ *       .end()
+ *       .action(patrol)
+ *     .end()
+ *     .build();
+ * @endcode
+ * @note Decorators use only their first child, without children they fail.
+ * @note Nodes still open when build() is called are closed, extra calls to end() are ignored.
+ */
+template<typename TAgent>
+class BehaviorTree<TAgent>::Builder {
+ public:
+  /**
+   * Open a sequence, which succeeds when all children succeed.
+   */
+  Builder& sequence() {
+    return open(NodeType::Sequence, 0);
+  }
+
+  /**
+   * Open a selector, which succeeds when any child succeeds.
+   */
+  Builder& selector() {
+    return open(NodeType::Selector, 0);
+  }
+
+  /**
+   * Open a parallel, which ticks all its children on every tick.
+   * @param successThreshold Number of children that must succeed for the parallel to succeed. It fails as soon as
+   * the threshold can not be reached anymore. Capped to the number of children.
+   */
+  Builder& parallel(std::uint32_t successThreshold) {
+    return open(NodeType::Parallel, successThreshold);
+  }
+
+  /**
+   * Open an inverter, which succeeds when its child fails and fails when it succeeds.
+   */
+  Builder& inverter() {
+    return open(NodeType::Inverter, 0);
+  }
+
+  /**
+   * Open a repeat, which ticks its child again every time it succeeds.
+   * @param times Number of successes of the child for the repeat to succeed, zero repeats forever. Each repetition
+   * takes a tick. Fails when the child fails.
+   */
+  Builder& repeat(std::uint32_t times) {
+    return open(NodeType::Repeat, times);
+  }
+
+  /**
+   * Add an action leaf.
+   * @param task Function ticked with the agent, returning the status of the leaf.
+   */
+  Builder& action(Action_type task) {
+    add(NodeType::Action, 0).action = task;
+    close(static_cast<std::uint32_t>(mNodes.size() - 1));
+    return *this;
+  }
+
+  /**
+   * Add a condition leaf, which succeeds when \a predicate returns true and fails otherwise.
+   * @param predicate Function ticked with the agent.
+   * @param abort Observer aborts of the condition, used by bt::EventDrivenExecutor.
+   */
+  Builder& condition(Condition_type predicate, Abort abort = Abort::None) {
+    add(NodeType::Condition, static_cast<std::uint32_t>(abort)).condition = predicate;
+    close(static_cast<std::uint32_t>(mNodes.size() - 1));
+    return *this;
+  }
+
+  /**
+   * Close the composite or decorator opened last.
+   */
+  Builder& end() {
+    if (!mOpen.empty()) {
+      close(mOpen.back());
+      mOpen.pop_back();
+    }
+    return *this;
+  }
+
+  /**
+   * Create the tree with the nodes added so far.
+   * @return The tree, empty if no node was added.
+   * @note Only the first root is kept if more than one root node was added.
+   */
+  BehaviorTree build() {
+    while (!mOpen.empty()) {
+      end();
+    }
+
+    BehaviorTree tree;
+    if (!mNodes.empty()) {
+      mNodes.resize(mNodes.front().end);
+      tree.mInstanceSize = mNodes.front().slotEnd;
+    }
+    tree.mNodes = std::move(mNodes);
+
+    mNodes.clear();
+    mSlotCount = 0;
+    return tree;
+  }
+
+ private:
+  Builder& open(NodeType type, std::uint32_t param) {
+    add(type, param);
+    // Composites with memory and repeats keep a word of the instance
+    if (type == NodeType::Sequence || type == NodeType::Selector || type == NodeType::Repeat) {
+      ++mSlotCount;
+    }
+    mOpen.emplace_back(static_cast<std::uint32_t>(mNodes.size() - 1));
+    return *this;
+  }
+
+  Node& add(NodeType type, std::uint32_t param) {
+    const std::uint32_t parent = mOpen.empty() ? kNoParent : mOpen.back();
+    mNodes.push_back({type, parent, 0, param, mSlotCount, 0, nullptr, nullptr});
+    return mNodes.back();
+  }
+
+  void close(std::uint32_t index) {
+    mNodes[index].end = static_cast<std::uint32_t>(mNodes.size());
+    mNodes[index].slotEnd = mSlotCount;
+  }
+
+  Vector<Node> mNodes; ///< Nodes added so far, in pre-order.
+  Vector<std::uint32_t> mOpen; ///< Composites and decorators not closed yet.
+  std::uint32_t mSlotCount = 0; ///< Words of the instance used so far.
+};
+
+}
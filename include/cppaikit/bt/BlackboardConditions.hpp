@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../Blackboard.hpp"
+
+namespace aikit::bt {
+
+/**
+ * Condition of a behavior tree whose agent is a aikit::Blackboard, true when a bool key is true.
+ * Leaves are plain functions, so the key is a template argument: a key with static storage duration, set from the
+ * schema on setup.
+ * @code
+ * BlackboardKey<bool> enemyVisible; // enemyVisible = schema.addKey<bool>("enemyVisible") on setup
+ * auto tree = BehaviorTree<Blackboard>::Builder()
+ *     .sequence()
+ *       .condition(isTrue<enemyVisible>, Abort::Self)
+ *       .action(attack)
+ *     .end()
+ *     .build();
+ * @endcode
+ * @tparam Key The key read, looked up on the parents of the blackboard too.
+ * @param blackboard The agent ticking the tree.
+ * @return False if no blackboard of the chain has a value for \a Key.
+ */
+template<const BlackboardKey<bool>& Key>
+bool isTrue(Blackboard& blackboard) {
+  return blackboard.get(Key, false);
+}
+
+/**
+ * Condition of a behavior tree whose agent is a aikit::Blackboard, true when a key of any type has a value.
+ * @tparam Key The key read, looked up on the parents of the blackboard too.
+ * @param blackboard The agent ticking the tree.
+ * @return True if a blackboard of the chain has a value for \a Key.
+ * @sa isTrue()
+ */
+template<const auto& Key>
+bool hasValue(Blackboard& blackboard) {
+  return blackboard.find(Key) != nullptr;
+}
+
+}
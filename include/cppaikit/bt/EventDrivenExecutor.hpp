@@ -0,0 +1,502 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "../Span.hpp"
+#include "BehaviorTree.hpp"
+#include "Status.hpp"
+
+namespace aikit::bt {
+
+/**
+ * Event driven executor of a bt::BehaviorTree.
+ * Instead of traversing the tree from the root on every tick, each agent keeps a queue of its active nodes: the
+ * running leaves and the repeats waiting for their next repetition. A tick only ticks the active nodes, and when one
+ * of them finishes its result is handed to its parent, which decides which node starts next. The cost of a tick is
+ * proportional to the active nodes and armed observers, not to the size of the tree.
+ * Conditions are only evaluated again when they are observers (see bt::Abort): an observer is armed when the
+ * condition is passed and, while armed, is evaluated on every tick before the active nodes. When its result changes,
+ * the running nodes it guards are aborted and the tree restarts from the condition or its parent.
+ * As with BehaviorTree::tick(), the per agent state lives on a separate instance, so one executor serves any number of
+ * agents.
+ * @tparam TAgent Type of the agents running the tree, passed to the leaves.
+ * @note Unlike BehaviorTree::tick(), parallels remember which children finished and do not tick them again.
+ * @attention The tree must outlive the executor and must not change while the executor is used.
+ * @sa bt::BehaviorTree
+ * @sa bt::Abort
+ */
+template<typename TAgent>
+class EventDrivenExecutor {
+ public:
+  typedef BehaviorTree<TAgent> Tree_type;
+
+  /**
+   * Create an executor for \a tree, precomputing the layout of the instances.
+   * @param tree The tree being executed.
+   */
+  explicit EventDrivenExecutor(const Tree_type& tree) : mTree(&tree) {
+    const auto nodes = tree.nodes();
+    mChildCounts.assign(nodes.size(), 0);
+    for (std::size_t index = 0; index < nodes.size(); ++index) {
+      const auto& node = nodes[index];
+      if (node.parent != Tree_type::kNoParent) {
+        ++mChildCounts[node.parent];
+      }
+      if (node.type == NodeType::Action || node.type == NodeType::Repeat) {
+        ++mQueueCapacity;
+      }
+      if (node.type == NodeType::Condition && static_cast<Abort>(node.param) != Abort::None) {
+        ++mObserverCapacity;
+      }
+    }
+
+    mRootWord = static_cast<std::uint32_t>(nodes.size());
+    mActiveCountWord = mRootWord + 1;
+    mActiveBegin = mActiveCountWord + 1;
+    mSnapshotBegin = mActiveBegin + mQueueCapacity;
+    mObserverCountWord = mSnapshotBegin + mQueueCapacity;
+    mObserverBegin = mObserverCountWord + 1;
+    mInstanceSize = mObserverBegin + 2 * mObserverCapacity;
+  }
+
+  /**
+   * Tick the tree for an agent.
+   * Armed observers are evaluated first, then every active node is ticked once. A node finishing starts the next ones
+   * right away, so a tick only returns when every active node is running or the root finished.
+   * @param agent The agent passed to the leaves.
+   * @param instance State of the agent on the executor, instanceSize() words zero initialized before the first tick.
+   * @return Status of the root node.
+   * @note When the root finishes, the next tick starts it again.
+   */
+  Status tick(TAgent& agent, Span<std::uint32_t> instance) const {
+    if (mTree->size() == 0) {
+      return Status::Failure;
+    }
+
+    Run run{*this, agent, instance.data(), Status::Running};
+    return run.tick();
+  }
+
+  /**
+   * Number of words of the per agent instance.
+   * @return Size of the instance given to tick().
+   */
+  std::size_t instanceSize() const {
+    return mInstanceSize;
+  }
+
+  /**
+   * Number of active nodes of an agent, the nodes ticked on its next tick.
+   * @param instance The instance of the agent.
+   * @return Number of running leaves and repeats waiting for their next repetition.
+   */
+  std::size_t activeCount(Span<const std::uint32_t> instance) const {
+    return instance[mActiveCountWord];
+  }
+
+  /**
+   * Number of armed observers of an agent, the conditions evaluated on its next tick.
+   * @param instance The instance of the agent.
+   * @return Number of armed observers.
+   */
+  std::size_t observerCount(Span<const std::uint32_t> instance) const {
+    return instance[mObserverCountWord];
+  }
+
+  /**
+   * Reset an instance to its initial state, aborting any running node.
+   * @param instance The instance being reset.
+   */
+  static void resetInstance(Span<std::uint32_t> instance) {
+    std::fill(instance.begin(), instance.end(), 0u);
+  }
+
+ private:
+  template<typename T>
+  using Vector = detail::ModuleVector<T, InstrumentedModule::BehaviorTree>;
+
+  typedef typename Tree_type::Node Node;
+
+  /// Marks queue entries of repeats waiting for their next repetition.
+  static constexpr std::uint32_t kRepeatEntry = std::uint32_t{1} << 31;
+  /// Marks parallels that already finished on their node word.
+  static constexpr std::uint32_t kParallelDone = std::uint32_t{1} << 31;
+  static constexpr std::uint32_t kParallelFailureShift = 15;
+  static constexpr std::uint32_t kParallelCountMask = (std::uint32_t{1} << kParallelFailureShift) - 1;
+
+  // Words of actions
+  static constexpr std::uint32_t kActionIdle = 0;
+  static constexpr std::uint32_t kActionRunning = 1;
+  static constexpr std::uint32_t kActionStarted = 2; ///< Running, started and ticked on the current tick.
+
+  // Words of conditions
+  static constexpr std::uint32_t kNotEvaluated = 0;
+  static constexpr std::uint32_t kEvaluatedFalse = 1;
+  static constexpr std::uint32_t kEvaluatedTrue = 2;
+
+  /**
+   * A tick of an agent. Every node has a word on the instance: the running child of sequences and selectors, the
+   * counters of parallels and repeats, whether actions are running and the last result of conditions.
+   */
+  struct Run {
+    const EventDrivenExecutor& executor;
+    TAgent& agent;
+    std::uint32_t* instance;
+    Status rootStatus;
+
+    Status tick() {
+      std::uint32_t& rootRunning = instance[executor.mRootWord];
+      if (rootRunning == 0) {
+        rootRunning = 1;
+        start(0);
+      } else {
+        checkObservers();
+        if (rootStatus == Status::Running) {
+          tickActive();
+        }
+      }
+      settleStarted();
+
+      return rootStatus;
+    }
+
+    const Node& node(std::uint32_t index) const { return executor.mTree->nodes()[index]; }
+
+    std::uint32_t& word(std::uint32_t index) { return instance[index]; }
+
+    void start(std::uint32_t index) {
+      const Node& current = node(index);
+
+      switch (current.type) {
+        case NodeType::Action: {
+          const Status status = current.action(agent);
+          if (status == Status::Running) {
+            word(index) = kActionStarted;
+            pushActive(index);
+          } else {
+            finish(index, status);
+          }
+          break;
+        }
+
+        case NodeType::Condition: {
+          const bool result = current.condition(agent);
+          word(index) = result ? kEvaluatedTrue : kEvaluatedFalse;
+          finish(index, result ? Status::Success : Status::Failure);
+          break;
+        }
+
+        case NodeType::Sequence:
+        case NodeType::Selector: {
+          if (index + 1 == current.end) {
+            finish(index, (current.type == NodeType::Sequence) ? Status::Success : Status::Failure);
+            break;
+          }
+
+          // Conditions not reached on this run must not be armed as lower priority observers
+          for (std::uint32_t child = index + 1; child < current.end; child = node(child).end) {
+            if (node(child).type == NodeType::Condition) {
+              word(child) = kNotEvaluated;
+            }
+          }
+          word(index) = index + 1;
+          start(index + 1);
+          break;
+        }
+
+        case NodeType::Parallel: {
+          word(index) = 0;
+          if (executor.mChildCounts[index] == 0 || current.param == 0) {
+            word(index) = kParallelDone;
+            finish(index, Status::Success);
+            break;
+          }
+
+          for (std::uint32_t child = index + 1; child < current.end && !(word(index) & kParallelDone);
+               child = node(child).end) {
+            start(child);
+          }
+          break;
+        }
+
+        case NodeType::Inverter:
+        case NodeType::Repeat: {
+          word(index) = 0;
+          if (index + 1 == current.end) {
+            finish(index, Status::Failure);
+          } else {
+            start(index + 1);
+          }
+          break;
+        }
+      }
+    }
+
+    void finish(std::uint32_t index, Status status) {
+      removeObserversIf([index](std::uint32_t /*condition*/, std::uint32_t scope) { return scope == index; });
+
+      const std::uint32_t parent = node(index).parent;
+      if (parent == Tree_type::kNoParent) {
+        rootStatus = status;
+        instance[executor.mRootWord] = 0;
+        instance[executor.mActiveCountWord] = 0;
+        instance[executor.mObserverCountWord] = 0;
+      } else {
+        resume(parent, index, status);
+      }
+    }
+
+    void resume(std::uint32_t index, std::uint32_t child, Status status) {
+      const Node& current = node(index);
+
+      switch (current.type) {
+        case NodeType::Sequence:
+        case NodeType::Selector: {
+          const bool isSequence = (current.type == NodeType::Sequence);
+          const Status stopStatus = isSequence ? Status::Failure : Status::Success;
+          if (status == stopStatus) {
+            finish(index, stopStatus);
+            break;
+          }
+
+          armObservers(index, child);
+
+          const std::uint32_t next = node(child).end;
+          if (next == current.end) {
+            finish(index, isSequence ? Status::Success : Status::Failure);
+          } else {
+            word(index) = next;
+            start(next);
+          }
+          break;
+        }
+
+        case NodeType::Parallel: {
+          std::uint32_t& counters = word(index);
+          counters += (status == Status::Success) ? 1 : (std::uint32_t{1} << kParallelFailureShift);
+
+          const std::uint32_t successes = counters & kParallelCountMask;
+          const std::uint32_t failures = (counters >> kParallelFailureShift) & kParallelCountMask;
+          const std::uint32_t children = executor.mChildCounts[index];
+          const std::uint32_t threshold = std::min(current.param, children);
+
+          if (successes >= threshold || children - failures < threshold) {
+            // Children still running are aborted
+            counters |= kParallelDone;
+            abortDescendants(index);
+            finish(index, (successes >= threshold) ? Status::Success : Status::Failure);
+          }
+          break;
+        }
+
+        case NodeType::Inverter:
+          finish(index, (status == Status::Success) ? Status::Failure : Status::Success);
+          break;
+
+        case NodeType::Repeat:
+          if (status == Status::Failure) {
+            finish(index, Status::Failure);
+          } else if (current.param != 0 && ++word(index) == current.param) {
+            finish(index, Status::Success);
+          } else {
+            // One repetition per tick, the child starts again on the next tick
+            pushActive(index | kRepeatEntry);
+          }
+          break;
+
+        case NodeType::Action:
+        case NodeType::Condition:
+          break;
+      }
+    }
+
+    /// Arm the observers passed by \a composite when it continues after \a child.
+    void armObservers(std::uint32_t composite, std::uint32_t child) {
+      const Node& passed = node(child);
+
+      if (passed.type == NodeType::Condition) {
+        const auto abort = static_cast<Abort>(passed.param);
+        if (abort == Abort::Self || abort == Abort::Both) {
+          addObserver(child, composite);
+        }
+      } else if (node(composite).type == NodeType::Selector &&
+                 (passed.type == NodeType::Sequence || passed.type == NodeType::Selector)) {
+        // The selector moves to a lower priority child, conditions of the failed child now guard it
+        for (std::uint32_t condition = child + 1; condition < passed.end; condition = node(condition).end) {
+          const auto abort = static_cast<Abort>(node(condition).param);
+          if (node(condition).type == NodeType::Condition && word(condition) != kNotEvaluated &&
+              (abort == Abort::LowerPriority || abort == Abort::Both)) {
+            addObserver(condition, composite);
+          }
+        }
+      }
+    }
+
+    void checkObservers() {
+      std::uint32_t* observers = instance + executor.mObserverBegin;
+
+      for (std::uint32_t i = 0; i < instance[executor.mObserverCountWord] && rootStatus == Status::Running;) {
+        const std::uint32_t condition = observers[2 * i];
+        const std::uint32_t scope = observers[2 * i + 1];
+
+        const bool result = node(condition).condition(agent);
+        if (result == (word(condition) == kEvaluatedTrue)) {
+          ++i;
+          continue;
+        }
+
+        const std::uint32_t parent = node(condition).parent;
+        abortDescendants(scope);
+        if (scope == parent) {
+          // Self: restart the parent from the condition, observers of earlier conditions stay armed
+          removeObserversIf([scope, condition](std::uint32_t observed, std::uint32_t observerScope) {
+            return observerScope == scope && observed >= condition;
+          });
+          word(condition) = result ? kEvaluatedTrue : kEvaluatedFalse;
+          word(scope) = condition;
+          finish(condition, result ? Status::Success : Status::Failure);
+        } else {
+          // Lower priority: restart the selector from the parent of the condition
+          removeObserversIf([scope](std::uint32_t /*observed*/, std::uint32_t observerScope) {
+            return observerScope == scope;
+          });
+          word(scope) = parent;
+          start(parent);
+        }
+
+        // The observers changed, check them again from the start
+        i = 0;
+      }
+    }
+
+    void tickActive() {
+      std::uint32_t* active = instance + executor.mActiveBegin;
+      std::uint32_t* snapshot = instance + executor.mSnapshotBegin;
+      const std::uint32_t count = instance[executor.mActiveCountWord];
+      std::copy(active, active + count, snapshot);
+
+      // Actions started on this tick were already ticked by start(), also when an observer or a node ticked before
+      // aborted and restarted them while on the snapshot
+      for (std::uint32_t i = 0; i < count && rootStatus == Status::Running; ++i) {
+        const std::uint32_t entry = snapshot[i];
+
+        if (entry & kRepeatEntry) {
+          if (removeActive(entry)) {
+            start((entry & ~kRepeatEntry) + 1);
+          }
+          continue;
+        }
+
+        if (word(entry) != kActionRunning) {
+          continue; // Aborted by a node ticked before, or started on this tick
+        }
+
+        const Status status = node(entry).action(agent);
+        if (status != Status::Running) {
+          word(entry) = kActionIdle;
+          removeActive(entry);
+          finish(entry, status);
+        }
+      }
+    }
+
+    /// Mark the actions started on this tick as running, to be ticked on the next one.
+    void settleStarted() {
+      const std::uint32_t* active = instance + executor.mActiveBegin;
+      const std::uint32_t count = instance[executor.mActiveCountWord];
+      for (std::uint32_t i = 0; i < count; ++i) {
+        if (!(active[i] & kRepeatEntry)) {
+          word(active[i]) = kActionRunning;
+        }
+      }
+    }
+
+    void pushActive(std::uint32_t entry) {
+      std::uint32_t& count = instance[executor.mActiveCountWord];
+      instance[executor.mActiveBegin + count++] = entry;
+    }
+
+    bool removeActive(std::uint32_t entry) {
+      std::uint32_t* active = instance + executor.mActiveBegin;
+      std::uint32_t& count = instance[executor.mActiveCountWord];
+      auto* found = std::find(active, active + count, entry);
+      if (found == active + count) {
+        return false;
+      }
+
+      std::copy(found + 1, active + count, found);
+      --count;
+      return true;
+    }
+
+    /// Abort every running node below \a index and disarm the observers guarding them.
+    void abortDescendants(std::uint32_t index) {
+      const std::uint32_t end = node(index).end;
+      const auto isDescendant = [index, end](std::uint32_t other) { return other > index && other < end; };
+
+      std::uint32_t* active = instance + executor.mActiveBegin;
+      std::uint32_t& count = instance[executor.mActiveCountWord];
+      std::uint32_t kept = 0;
+      for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint32_t entry = active[i];
+        const std::uint32_t entryNode = entry & ~kRepeatEntry;
+        if (isDescendant(entryNode)) {
+          if (!(entry & kRepeatEntry)) {
+            word(entryNode) = kActionIdle;
+          }
+        } else {
+          active[kept++] = entry;
+        }
+      }
+      count = kept;
+
+      removeObserversIf([&isDescendant](std::uint32_t /*observed*/, std::uint32_t scope) {
+        return isDescendant(scope);
+      });
+    }
+
+    void addObserver(std::uint32_t condition, std::uint32_t scope) {
+      std::uint32_t& count = instance[executor.mObserverCountWord];
+      if (count < executor.mObserverCapacity) {
+        instance[executor.mObserverBegin + 2 * count] = condition;
+        instance[executor.mObserverBegin + 2 * count + 1] = scope;
+        ++count;
+      }
+    }
+
+    template<typename TPredicate>
+    void removeObserversIf(const TPredicate& predicate) {
+      std::uint32_t* observers = instance + executor.mObserverBegin;
+      std::uint32_t& count = instance[executor.mObserverCountWord];
+      std::uint32_t kept = 0;
+      for (std::uint32_t i = 0; i < count; ++i) {
+        if (!predicate(observers[2 * i], observers[2 * i + 1])) {
+          observers[2 * kept] = observers[2 * i];
+          observers[2 * kept + 1] = observers[2 * i + 1];
+          ++kept;
+        }
+      }
+      count = kept;
+    }
+  };
+
+  const Tree_type* mTree;
+  Vector<std::uint32_t> mChildCounts; ///< Number of children of each node.
+  std::uint32_t mQueueCapacity = 0; ///< Maximum number of active nodes: actions and repeats.
+  std::uint32_t mObserverCapacity = 0; ///< Maximum number of armed observers: conditions with aborts.
+
+  // Layout of the instance, after the word of every node
+  std::uint32_t mRootWord = 0; ///< 1 while the root is running.
+  std::uint32_t mActiveCountWord = 0;
+  std::uint32_t mActiveBegin = 0; ///< Queue of active nodes.
+  std::uint32_t mSnapshotBegin = 0; ///< Copy of the queue taken at the start of a tick.
+  std::uint32_t mObserverCountWord = 0;
+  std::uint32_t mObserverBegin = 0; ///< Armed observers as pairs of condition and guarded node.
+  std::size_t mInstanceSize = 0;
+};
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace aikit::bt {
+
+/**
+ * Result of ticking a node of a behavior tree.
+ */
+enum class Status : std::uint8_t {
+  Success, ///< The node finished and achieved its goal.
+  Failure, ///< The node finished without achieving its goal.
+  Running ///< The node did not finish, it continues on the next tick.
+};
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace aikit::fsm {
+
+/**
+ * Compact reference to an event of a FSM.
+ * Events are dense indices used, together with the current state, to look up transitions in the transition table of
+ * a machine. Events are never removed, so a handle stays valid for the lifetime of the machine that returned it.
+ * @sa fsm::FSM::addEvent()
+ * @sa fsm::FSM::dispatch()
+ */
+struct EventHandle {
+  static constexpr std::uint32_t kInvalidIndex = ~std::uint32_t{0};
+
+  std::uint32_t index = kInvalidIndex; ///< Index of the event on the machine.
+
+  /**
+   * Check if the handle was set to an event.
+   * @return True if the handle was returned by a machine.
+   */
+  bool isSet() const { return index != kInvalidIndex; }
+
+  friend bool operator==(const EventHandle& lhs, const EventHandle& rhs) {
+    return lhs.index == rhs.index;
+  }
+
+  friend bool operator!=(const EventHandle& lhs, const EventHandle& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+}
@@ -1,12 +1,29 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <string>
 #include <vector>
 
+#include "../Instrumentation.hpp"
+#include "../MPSCQueue.hpp"
+#ifdef CppAIKit_TRACING
+#include "../Trace.hpp"
+#endif
+#include "EventHandle.hpp"
+#include "Profiler.hpp"
+#include "ResourceAllocator.hpp"
+#include "Snapshot.hpp"
 #include "State.hpp"
+#include "StateHandle.hpp"
+#include "Storage.hpp"
 
 namespace aikit::fsm {
 
@@ -14,13 +31,114 @@ namespace aikit::fsm {
  * Implementation for a Finite State Machine.
  * @tparam TId Type for the id of a state. Defaults to std::string.
  * @tparam TState Base type for the states managed by the machine. Defaults to fsm::State<int>.
+ * @tparam TStorage Storage policy used to index states by id. Defaults to fsm::storage::Map.
+ * @tparam TProfiler Profiling policy, called on every transition and update. Defaults to fsm::NoProfiler, which is
+ * compiled out.
+ * @note Independently of \a TStorage, each state is allocated together with its id and never moved, so pointers
+ * returned by currentStateId(), stateIds(), currentState() and alike stay valid until the state is removed.
+ * @note Every method taking an id has an overload taking a fsm::StateHandle, which skips the id lookup.
+ * @note The memory of the machine (states, slots and index) is taken from the std::pmr::memory_resource given on
+ * construction. Ids only stay on it if \a TId is allocator aware, e.g. std::pmr::string: with the default std::string,
+ * ids too long for its small buffer are allocated on the global heap. The index does not copy ids. Combined with
+ * reserve() and a std::pmr::monotonic_buffer_resource, a machine with such ids can be built on a single contiguous
+ * block of memory.
+ * @note Besides the imperative transitionTo(), transitions can be declared on a transition table as
+ * (state, event) -> (target, guard, action) and triggered with dispatch(). The table is dense, indexed by state and
+ * event, so a dispatch is a single lookup.
+ * @note Other threads can send events to the machine through an optional inbox, see enableInbox().
+ * @note Besides the previous state, an optional bounded history of past transitions can be kept, see enableHistory().
+ * @note The current and previous states (and optionally the data of every state) can be saved to a compact binary
+ * snapshot and restored later, see writeSnapshot().
+ * @note When CppAIKit_INSTRUMENTATION is defined, the allocations of each machine are counted, see allocationStats().
+ * @note When CppAIKit_TRACING is defined, every change of current state is recorded with aikit::trace, see traceId().
  * @sa fsm::State
+ * @sa fsm::StateHandle
+ * @sa fsm::EventHandle
+ * @sa fsm::storage::Map
+ * @sa fsm::storage::FlatMap
+ * @sa fsm::storage::HashMap
+ * @sa fsm::Profiler
  */
-template<typename TId = std::string, typename TState = State<int>>
-class FSM {
+template<typename TId = std::string, typename TState = State<int>, typename TStorage = storage::Map,
+         typename TProfiler = NoProfiler>
+class FSM : private detail::ProfilerHolder<TProfiler> {
  public:
   typedef TId Id_type;
+  typedef TProfiler Profiler_type;
   typedef typename TState::UpdateData_type UpdateData_type;
+  typedef std::function<bool()> Guard_type;
+  typedef std::function<void()> Action_type;
+
+  /**
+   * A change of current state recorded on the history of the FSM.
+   * @sa enableHistory()
+   */
+  struct HistoryEntry {
+    StateHandle from; ///< State current before the change, unset if there was none.
+    StateHandle to; ///< State current after the change, unset if the machine was left without current state.
+    EventHandle event; ///< Event that triggered the transition, unset if it was not dispatched.
+    std::uint64_t tick; ///< Value of tick() when the change happened.
+  };
+
+  /**
+   * Create a FSM allocating from the default memory resource.
+   */
+  FSM() : FSM(std::pmr::get_default_resource()) {}
+
+  /**
+   * Create a FSM allocating from \a resource.
+   * @param resource Memory resource used for all allocations of the machine, must outlive the machine.
+   */
+  explicit FSM(std::pmr::memory_resource* resource)
+#ifdef CppAIKit_INSTRUMENTATION
+      : mCounter(std::make_unique<CountingResource>(resource, InstrumentedModule::FSM)), mResource(mCounter.get()),
+#else
+      : mResource(resource),
+#endif
+        mSlots(mResource), mFreeSlots(mResource), mIndex(mResource), mTransitionTable(mResource),
+        mTransitionCallbacks(mResource), mFreeTransitionCallbacks(mResource), mPendingTransitions(mResource),
+        mCommittingTransitions(mResource), mHistory(mResource) {}
+
+  FSM(FSM&&) = default;
+
+  /**
+   * Replace the machine by \a other.
+   * The machine takes the states and memory of \a other together with its memory resource, nothing is copied.
+   */
+  FSM& operator=(FSM&& other) {
+    if (this == &other) {
+      return *this;
+    }
+
+#ifdef CppAIKit_INSTRUMENTATION
+    // The current counter must outlive the members returning the memory it counted, it is released last
+    const std::unique_ptr<CountingResource> counter = std::move(mCounter);
+    mCounter = std::move(other.mCounter);
+#endif
+    this->heldProfiler() = std::move(other.heldProfiler());
+    mResource = other.mResource;
+    mSlots = std::move(other.mSlots);
+    mFreeSlots = std::move(other.mFreeSlots);
+    mIndex = std::move(other.mIndex);
+    mPreviousState = other.mPreviousState;
+    mCurrentState = other.mCurrentState;
+    mEventCount = other.mEventCount;
+    mTransitionTable = std::move(other.mTransitionTable);
+    mTransitionCallbacks = std::move(other.mTransitionCallbacks);
+    mFreeTransitionCallbacks = std::move(other.mFreeTransitionCallbacks);
+    mPendingTransitions = std::move(other.mPendingTransitions);
+    mCommittingTransitions = std::move(other.mCommittingTransitions);
+    mInbox = std::move(other.mInbox);
+    mHistory = std::move(other.mHistory);
+    mHistoryNext = other.mHistoryNext;
+    mHistorySize = other.mHistorySize;
+    mTick = other.mTick;
+    mUpdating = other.mUpdating;
+#ifdef CppAIKit_TRACING
+    mTraceId = other.mTraceId;
+#endif
+    return *this;
+  }
 
   /**
    * Adds a new state to the FSM.
@@ -28,15 +146,28 @@ class FSM {
    * removeState() or the machine is destroyed.
    * @param id Identification of the state being added, this is used to reference the state in all other methods.
    * @param state The state being added. It must inherit from the class fsm::State.
-   * @note If any state with equivalent \a id already exists, does nothing.
+   * @return Handle to the added state, valid until the state is removed.
+   * @note If any state with equivalent \a id already exists, does nothing and returns an unset handle.
    */
   template<typename TNewState>
-  void addState(TId id, TNewState&& state) {
+  StateHandle addState(TId id, TNewState&& state) {
     using TNewStateNoRef = std::remove_reference_t<TNewState>;
     static_assert(std::is_base_of_v<TState, TNewStateNoRef>,
                   "addState() is only callable with state that is derived from TState");
 
-    mStates.try_emplace(std::move(id), std::make_unique<TNewStateNoRef>(std::forward<TNewState>(state)));
+    if (mIndex.find(id) != nullptr) {
+      return {};
+    }
+
+    const auto slot = acquireSlot();
+    typedef Node<TNewStateNoRef> TNode;
+    void* memory = mResource->allocate(sizeof(TNode), alignof(TNode));
+    auto* node = new (memory) TNode(mResource, std::move(id), std::forward<TNewState>(state));
+    mSlots[slot].state = &node->state;
+    mSlots[slot].node.reset(node);
+    mIndex.insert(node->id, slot);
+
+    return {slot, mSlots[slot].generation};
   }
 
   /**
@@ -49,31 +180,34 @@ class FSM {
    * @note If \a id refers to FSM current state, will transition to previous (if any) before removing it.
    * @note After a transition to previous because \a id refers to current, the previous will be equal to
    * current (previous state will not be cleared or changed).
+   * @note Handles to the removed state are invalidated.
    * @attention If \a id refers to FSM previous state, will clear it before removing and no transition will happen.
    * @attention If \a id refers to a state that is both current and previous, fsm::State::onExit() will be
    * called for the state before removing it. Both current and previous will be cleared.
    */
   bool removeState(const TId& id) {
-    // TODO Reimplement, find first then determine actions if it is current or previous or both
-    if (hasCurrentState() && (*currentStateId() == id)) {
-      if (hasPreviousState()) {
-        if (mCurrentState.id == mPreviousState.id) { // No need to compare values again, just check if point to same
-          mCurrentState.state->onExit();
-          mCurrentState.clear();
-          mPreviousState.clear();
-        } else {
-          transitionToPreviousState();
-          mPreviousState = mCurrentState;
-        }
-      } else {
-        mCurrentState.state->onExit();
-        mCurrentState.clear();
-      }
-    } else if (hasPreviousState() && (*previousStateId() == id)) {
-      mPreviousState.clear();
+    const auto* found = mIndex.find(id);
+    if (found == nullptr) {
+      return false;
     }
 
-    return mStates.erase(id) > 0;
+    removeSlot(*found);
+    return true;
+  }
+
+  /**
+   * Remove a state from the FSM.
+   * @param handle Handle of the state being removed.
+   * @return Returns true only when \a handle refers to a state on the FSM and it is removed.
+   * @sa removeState(const TId&)
+   */
+  bool removeState(StateHandle handle) {
+    if (!hasState(handle)) {
+      return false;
+    }
+
+    removeSlot(handle.index);
+    return true;
   }
 
   /**
@@ -87,26 +221,39 @@ class FSM {
    * @note The order of operations during transition is: Call fsm::State::onExit() for current
    * state (if any), set previous state with the current state (if any), set current state with the \a id
    * state, call fsm::State::onEnter() for the new current state.
+   * @note When called from inside fsm::State::update() of the current state, the transition is deferred with
+   * requestTransition() and only happens after the state finishes updating.
    * @sa fsm::State::onExit()
    * @sa fsm::State::onEnter()
    */
   bool transitionTo(const TId& id) {
-    auto found = mStates.find(id);
-    const bool foundStateId = (found != mStates.end());
+    const auto* found = mIndex.find(id);
+    const bool foundStateId = (found != nullptr);
 
     if (foundStateId) {
-      if (hasCurrentState()) {
-        mCurrentState.state->onExit();
-        mPreviousState = mCurrentState;
-      }
-
-      mCurrentState = {&found->first, found->second.get()};
-      mCurrentState.state->onEnter();
+      transitionOrDefer(*found);
     }
 
     return foundStateId;
   }
 
+  /**
+   * Transition to a state.
+   * @param handle Handle of the state that will be transitioned to.
+   * @return True if \a handle refers to a state on the FSM.
+   * @note If \a handle is not valid, the call is ignored.
+   * @sa transitionTo(const TId&)
+   */
+  bool transitionTo(StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      transitionOrDefer(handle.index);
+    }
+
+    return validHandle;
+  }
+
   /**
    * Transition to FSM previous state.
    * @return True if there was a previous state to transition to.
@@ -116,20 +263,375 @@ class FSM {
   bool transitionToPreviousState() {
     const bool hasPrevious = hasPreviousState();
     if (hasPrevious) {
-      transitionTo(*mPreviousState.id);
+      transitionOrDefer(mPreviousState.handle.index);
     }
 
     return hasPrevious;
   }
 
+  /**
+   * Request a transition to a state, to be made on the next call to commitTransitions().
+   * This is the safe way for a state to transition the machine from inside its own fsm::State::update().
+   * @param id Identification of the state that will be transitioned to.
+   * @return True if \a id was found on the FSM.
+   * @note If \a id was not found, the call is ignored.
+   * @sa commitTransitions()
+   */
+  bool requestTransition(const TId& id) {
+    return requestTransition(stateHandle(id));
+  }
+
+  /**
+   * Request a transition to a state, to be made on the next call to commitTransitions().
+   * @param handle Handle of the state that will be transitioned to.
+   * @return True if \a handle refers to a state on the FSM.
+   * @note If \a handle is not valid, the call is ignored.
+   * @sa requestTransition(const TId&)
+   */
+  bool requestTransition(StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      mPendingTransitions.push_back({handle, {}});
+    }
+
+    return validHandle;
+  }
+
+  /**
+   * Check if there are transitions waiting for commitTransitions().
+   * @return True if there is at least one pending transition.
+   */
+  bool hasPendingTransitions() const {
+    return !mPendingTransitions.empty();
+  }
+
+  /**
+   * Make all pending transitions, in the order they were requested.
+   * Each one is a regular transition, as made by transitionTo().
+   * @note Requests to states removed after being requested are ignored.
+   * @note Transitions requested while committing (e.g. from fsm::State::onEnter()) stay pending for the next commit.
+   * @note Events dispatched during fsm::State::update() are looked up on the transition table only when committed,
+   * from the state that is current at that point.
+   * @sa requestTransition()
+   * @sa dispatch()
+   */
+  void commitTransitions() {
+    this->heldProfiler().commitUpdates();
+    mCommittingTransitions.swap(mPendingTransitions);
+
+    for (const auto& pending : mCommittingTransitions) {
+      if (pending.event.isSet()) {
+        dispatchEvent(pending.event.index);
+      } else if (hasState(pending.target)) {
+        transitionToSlot(pending.target.index);
+      }
+    }
+
+    mCommittingTransitions.clear();
+  }
+
+  /**
+   * Add a new event to the FSM.
+   * Events are used to declare transitions with addTransition() and to trigger them with dispatch().
+   * @return Handle to the added event, valid for the lifetime of the machine.
+   * @note Adding an event grows every row of the transition table, preferably add all events before transitions.
+   */
+  EventHandle addEvent() {
+    const std::uint32_t eventCount = mEventCount + 1;
+    detail::ResourceVector<TransitionEntry> table(mSlots.size() * eventCount, mResource);
+
+    for (std::size_t slot = 0; slot < mSlots.size(); ++slot) {
+      for (std::uint32_t event = 0; event < mEventCount; ++event) {
+        table[slot * eventCount + event] = mTransitionTable[slot * mEventCount + event];
+      }
+    }
+
+    mTransitionTable.swap(table);
+    mEventCount = eventCount;
+    return {eventCount - 1};
+  }
+
+  /**
+   * Checks if \a event refers to an event in the FSM.
+   * @param event The handle of an event.
+   * @return True if \a event was returned by addEvent() of this machine.
+   */
+  bool hasEvent(EventHandle event) const {
+    return event.index < mEventCount;
+  }
+
+  /**
+   * Number of events in the FSM.
+   * @return The number of events in the FSM.
+   */
+  std::size_t eventCount() const {
+    return mEventCount;
+  }
+
+  /**
+   * Declare the transition taken when \a event is dispatched while \a from is the current state.
+   * @param from Handle of the state the transition leaves.
+   * @param event Handle of the event triggering the transition.
+   * @param to Handle of the state the transition enters. Can be equal to \a from for a self transition.
+   * @param guard Optional condition checked on dispatch, the transition is only taken when it returns true.
+   * @param action Optional function called during the transition, between fsm::State::onExit() of \a from and
+   * fsm::State::onEnter() of \a to.
+   * @return True if both states and the event are on the FSM.
+   * @note Replaces any transition previously declared for the same \a from and \a event.
+   * @note Transitions leaving a state are removed together with it. Transitions entering a removed state are ignored.
+   * @attention Guards and actions are stored as std::function, which may allocate outside the memory resource of
+   * the FSM for large captures.
+   */
+  bool addTransition(StateHandle from, EventHandle event, StateHandle to, Guard_type guard = {},
+                     Action_type action = {}) {
+    if (!hasState(from) || !hasEvent(event) || !hasState(to)) {
+      return false;
+    }
+
+    auto& entry = transitionEntry(from.index, event.index);
+    entry.target = to;
+
+    if (guard || action) {
+      if (entry.callbacks == kNoCallbacks) {
+        entry.callbacks = acquireTransitionCallbacks();
+      }
+      mTransitionCallbacks[entry.callbacks] = {std::move(guard), std::move(action)};
+    } else {
+      releaseTransitionCallbacks(entry);
+    }
+
+    return true;
+  }
+
+  /**
+   * Declare the transition taken when \a event is dispatched while \a from is the current state.
+   * @param from Identification of the state the transition leaves.
+   * @param event Handle of the event triggering the transition.
+   * @param to Identification of the state the transition enters.
+   * @param guard Optional condition checked on dispatch, the transition is only taken when it returns true.
+   * @param action Optional function called during the transition.
+   * @return True if both states and the event are on the FSM.
+   * @sa addTransition(StateHandle, EventHandle, StateHandle, Guard_type, Action_type)
+   */
+  bool addTransition(const TId& from, EventHandle event, const TId& to, Guard_type guard = {},
+                     Action_type action = {}) {
+    return addTransition(stateHandle(from), event, stateHandle(to), std::move(guard), std::move(action));
+  }
+
+  /**
+   * Remove the transition declared for \a from and \a event.
+   * @param from Handle of the state the transition leaves.
+   * @param event Handle of the event triggering the transition.
+   * @return True if a transition was declared and removed.
+   */
+  bool removeTransition(StateHandle from, EventHandle event) {
+    if (!hasState(from) || !hasEvent(event)) {
+      return false;
+    }
+
+    auto& entry = transitionEntry(from.index, event.index);
+    const bool declared = entry.target.isSet();
+    releaseTransitionCallbacks(entry);
+    entry = {};
+
+    return declared;
+  }
+
+  /**
+   * The state entered when \a event is dispatched while \a from is the current state.
+   * @param from Handle of the state the transition leaves.
+   * @param event Handle of the event triggering the transition.
+   * @return Handle of the target state, unset if there is no transition or its target was removed.
+   * @note Guards are not checked.
+   */
+  StateHandle transitionTarget(StateHandle from, EventHandle event) const {
+    if (!hasState(from) || !hasEvent(event)) {
+      return {};
+    }
+
+    const auto& target = mTransitionTable[from.index * mEventCount + event.index].target;
+    return hasState(target) ? target : StateHandle{};
+  }
+
+  /**
+   * Dispatch an event to the FSM, taking the transition declared for the current state and \a event (if any).
+   * The order of operations is: check the guard (if any), call fsm::State::onExit() for the current state, set
+   * previous state with the current state, call the action (if any), set current state with the target state, call
+   * fsm::State::onEnter() for the new current state.
+   * @param event Handle of the event being dispatched.
+   * @return True if a transition was taken.
+   * @note When called from inside fsm::State::update() of the current state, the event is queued and only looked up
+   * by commitTransitions(), in which case the return is true if \a event is valid.
+   * @attention Transitions must not be added or removed from inside guards and actions.
+   * @sa addTransition()
+   */
+  bool dispatch(EventHandle event) {
+    if (!hasEvent(event)) {
+      return false;
+    }
+
+    if (mUpdating) {
+      mPendingTransitions.push_back({{}, event});
+      return true;
+    }
+
+    return dispatchEvent(event.index);
+  }
+
+  /**
+   * Attach an inbox to the FSM, allowing any thread to send events with postEvent().
+   * The inbox is a bounded lock free queue allocated once from the memory resource of the FSM, posting and draining
+   * events never allocate.
+   * @param capacity Maximum number of events waiting on the inbox, rounded up to a power of two.
+   * @note Replaces the current inbox (if any), dropping the events waiting on it.
+   * @attention Must not be called while other threads may be posting events.
+   * @sa postEvent()
+   * @sa dispatchInbox()
+   */
+  void enableInbox(std::size_t capacity) {
+    void* memory = mResource->allocate(sizeof(Inbox), alignof(Inbox));
+    mInbox.reset(new (memory) Inbox(capacity, mResource));
+  }
+
+  /**
+   * Check if the FSM has an inbox.
+   * @return True if enableInbox() was called.
+   */
+  bool hasInbox() const {
+    return mInbox != nullptr;
+  }
+
+  /**
+   * Send an event to the FSM from any thread.
+   * The event is dispatched by the thread updating the machine, on the next call to update() or dispatchInbox().
+   * @param event Handle of the event being sent.
+   * @return False if there is no inbox, the inbox is full or \a event is not valid, in which case the event is lost.
+   * @note Thread safe, can be called concurrently from many threads and while the machine is updated.
+   * @attention Events must not be added while other threads may be posting events.
+   */
+  bool postEvent(EventHandle event) {
+    return hasInbox() && hasEvent(event) && mInbox->tryPush(event);
+  }
+
+  /**
+   * Dispatch the events waiting on the inbox, in the order they were posted.
+   * Called automatically at the start of update().
+   * @return Number of events taken from the inbox, including the ones that did not trigger a transition.
+   * @note At most the capacity of the inbox is dispatched per call, so producers cannot keep the machine busy.
+   * @sa dispatch()
+   */
+  std::size_t dispatchInbox() {
+    if (!hasInbox()) {
+      return 0;
+    }
+
+    std::size_t dispatched = 0;
+    EventHandle event;
+    while (dispatched < mInbox->capacity() && mInbox->tryPop(event)) {
+      dispatch(event);
+      ++dispatched;
+    }
+
+    return dispatched;
+  }
+
+  /**
+   * Keep a history of the last \a capacity changes of current state.
+   * The history is a ring buffer allocated once from the memory resource of the FSM, recording a change never
+   * allocates and overwrites the oldest entry when the history is full.
+   * @param capacity Maximum number of entries on the history, zero disables the history.
+   * @note Every change of current state is recorded: transitions, dispatched events and setCurrentState().
+   * @note Clears the current history (if any).
+   * @sa historyEntry()
+   * @sa transitionBack()
+   */
+  void enableHistory(std::size_t capacity) {
+    mHistory.assign(capacity, HistoryEntry{});
+    mHistory.shrink_to_fit();
+    mHistoryNext = 0;
+    mHistorySize = 0;
+  }
+
+  /**
+   * Number of entries on the history.
+   * @return Number of changes recorded, up to the capacity given to enableHistory().
+   */
+  std::size_t historySize() const {
+    return mHistorySize;
+  }
+
+  /**
+   * An entry of the history.
+   * @param n Age of the entry, 0 is the most recent change.
+   * @return The entry \a n changes ago.
+   * @attention Can be nullptr if \a n is not less than historySize().
+   */
+  const HistoryEntry* historyEntry(std::size_t n) const {
+    if (n >= mHistorySize) {
+      return nullptr;
+    }
+
+    return &mHistory[(mHistoryNext + mHistory.size() - 1 - n) % mHistory.size()];
+  }
+
+  /**
+   * Transition back to the state that was current \a n changes ago.
+   * transitionBack(1) goes to the state before the last change, like transitionToPreviousState().
+   * @param n Number of changes to go back, from 1 to historySize().
+   * @return True if the history has the state and it was not removed from the FSM.
+   * @note The transition is itself recorded on the history, going back does not remove entries.
+   * @sa transitionTo()
+   */
+  bool transitionBack(std::size_t n = 1) {
+    const auto* entry = (n > 0) ? historyEntry(n - 1) : nullptr;
+    const bool foundState = (entry != nullptr) && hasState(entry->from);
+
+    if (foundState) {
+      transitionOrDefer(entry->from.index);
+    }
+
+    return foundState;
+  }
+
+  /**
+   * Number of times the FSM was updated, used to timestamp the entries of the history.
+   * @return Number of calls to update() or updateCurrentState().
+   */
+  std::uint64_t tick() const {
+    return mTick;
+  }
+
   /**
    * Update FSM and it's current state.
+   * Events waiting on the inbox (if any) are dispatched before the update.
+   * Transitions requested during the update are committed right after the current state finishes updating.
    * @param updateData The data that will be passed during the call fsm::State::update() on the current state.
    * @note If there is no current state, the call is ignored.
    * @sa fsm::State::update()
+   * @sa dispatchInbox()
+   * @sa updateCurrentState()
+   * @sa commitTransitions()
    */
   void update(UpdateData_type updateData) {
+    dispatchInbox();
+    updateCurrentState(updateData);
+    commitTransitions();
+  }
+
+  /**
+   * Update the current state without dispatching the inbox nor committing transitions.
+   * Every transition made during the update is deferred until commitTransitions() is called. This allows updating
+   * many machines in parallel and committing their transitions later in a single serial pass.
+   * @param updateData The data that will be passed during the call fsm::State::update() on the current state.
+   * @note If there is no current state, the call is ignored.
+   * @note If fsm::State::update() throws, every transition waiting for commitTransitions() is dropped.
+   * @sa update()
+   */
+  void updateCurrentState(UpdateData_type updateData) {
+    ++mTick;
     if (hasCurrentState()) {
+      const UpdateScope scope(*this, mCurrentState.handle.index);
       mCurrentState.state->update(updateData);
     }
   }
@@ -147,20 +649,33 @@ class FSM {
    * @attention fsm::State::onEnter() will not be called for the state being set as current.
    */
   bool setCurrentState(const TId& id) {
-    auto found = mStates.find(id);
-    const bool foundStateId = (found != mStates.end());
+    const auto* found = mIndex.find(id);
+    const bool foundStateId = (found != nullptr);
 
     if (foundStateId) {
-      if (mCurrentState.isSet()) {
-        mPreviousState = mCurrentState;
-      }
-
-      mCurrentState = {&found->first, found->second.get()};
+      setCurrentSlot(*found);
     }
 
     return foundStateId;
   }
 
+  /**
+   * Set the current state of the FSM.
+   * @param handle Handle of the state that will be set as current.
+   * @return True if \a handle refers to a state on the FSM.
+   * @note If \a handle is not valid, the call is ignored.
+   * @sa setCurrentState(const TId&)
+   */
+  bool setCurrentState(StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      setCurrentSlot(handle.index);
+    }
+
+    return validHandle;
+  }
+
   /**
    * Check if the FSM has a current state set.
    * @return True if there is a current state.
@@ -178,6 +693,14 @@ class FSM {
     return mCurrentState.id;
   }
 
+  /**
+   * The handle of the current state of the FSM.
+   * @return Handle of the current state, unset if no state is set.
+   */
+  StateHandle currentStateHandle() const {
+    return mCurrentState.handle;
+  }
+
   /**
    * The current state of the FSM.
    * @return Current state of the FSM.
@@ -213,6 +736,14 @@ class FSM {
     return mPreviousState.id;
   }
 
+  /**
+   * The handle of the previous state of the FSM.
+   * @return Handle of the previous state, unset if no previous state is set.
+   */
+  StateHandle previousStateHandle() const {
+    return mPreviousState.handle;
+  }
+
   /**
    * The previous state of the FSM.
    * @return Current state of the FSM.
@@ -238,10 +769,12 @@ class FSM {
    */
   std::vector<const TId*> stateIds() const {
     std::vector<const TId*> ids;
-    ids.reserve(mStates.size());
+    ids.reserve(size());
 
-    for (const auto& stateMap : mStates) {
-      ids.emplace_back(&stateMap.first);
+    for (const auto& slot : mSlots) {
+      if (slot.isUsed()) {
+        ids.emplace_back(&slot.node->id);
+      }
     }
 
     return ids;
@@ -254,10 +787,12 @@ class FSM {
    */
   std::vector<TState*> states() const {
     std::vector<TState*> retStates;
-    retStates.reserve(mStates.size());
+    retStates.reserve(size());
 
-    for (const auto& stateMap : mStates) {
-      retStates.emplace_back(stateMap.second.get());
+    for (const auto& slot : mSlots) {
+      if (slot.isUsed()) {
+        retStates.emplace_back(slot.state);
+      }
     }
 
     return retStates;
@@ -269,7 +804,32 @@ class FSM {
    * @return True if the FSM has a state with \a id.
    */
   bool hasState(const TId& id) const {
-    return mStates.count(id) > 0;
+    return mIndex.find(id) != nullptr;
+  }
+
+  /**
+   * Checks if \a handle refers to a state in the FSM.
+   * @param handle The handle of a state.
+   * @return True if the state referred by \a handle was not removed from the FSM.
+   */
+  bool hasState(StateHandle handle) const {
+    return handle.index < mSlots.size() && mSlots[handle.index].generation == handle.generation &&
+           mSlots[handle.index].isUsed();
+  }
+
+  /**
+   * Resolve the handle of the state with the associated \a id.
+   * Resolving the handle once and using it afterwards avoids an id lookup on every call.
+   * @param id The identification of a state.
+   * @return Handle of the state, unset if there is no state with \a id.
+   */
+  StateHandle stateHandle(const TId& id) const {
+    const auto* found = mIndex.find(id);
+    if (found != nullptr) {
+      return {*found, mSlots[*found].generation};
+    } else {
+      return {};
+    }
   }
 
   /**
@@ -279,9 +839,51 @@ class FSM {
    * @warning Will return nullptr if there is no state with \a id.
    */
   const TState* getState(const TId& id) const {
-    const auto found = mStates.find(id);
-    if (found != mStates.end()) {
-      return found->second.get();
+    const auto* found = mIndex.find(id);
+    if (found != nullptr) {
+      return mSlots[*found].state;
+    } else {
+      return nullptr;
+    }
+  }
+
+  /**
+   * Get the state referred by \a handle.
+   * @param handle The handle of a state.
+   * @return The state referred by \a handle.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  const TState* getState(StateHandle handle) const {
+    if (hasState(handle)) {
+      return mSlots[handle.index].state;
+    } else {
+      return nullptr;
+    }
+  }
+
+  /**
+   * Get the state referred by \a handle.
+   * @param handle The handle of a state.
+   * @return The state referred by \a handle.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  TState* getState(StateHandle handle) {
+    if (hasState(handle)) {
+      return mSlots[handle.index].state;
+    } else {
+      return nullptr;
+    }
+  }
+
+  /**
+   * The identification of the state referred by \a handle.
+   * @param handle The handle of a state.
+   * @return Id of the state.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  const TId* stateId(StateHandle handle) const {
+    if (hasState(handle)) {
+      return &mSlots[handle.index].node->id;
     } else {
       return nullptr;
     }
@@ -292,25 +894,519 @@ class FSM {
    * @return The number of states in the FSM.
    */
   std::size_t size() const {
-    return mStates.size();
+    return mIndex.size();
+  }
+
+  /**
+   * Reserve space for \a count states, avoiding reallocations of the internal tables while adding them.
+   * @param count Total number of states expected on the FSM.
+   * @param pendingTransitions Number of transitions expected to be pending at the same time.
+   * @note The transition table is reserved for the events already added.
+   * @note Only the tables are reserved, each state is still allocated by addState() from the memory resource.
+   */
+  void reserve(std::size_t count, std::size_t pendingTransitions = 1) {
+    mSlots.reserve(count);
+    mTransitionTable.reserve(count * mEventCount);
+    mFreeSlots.reserve(count);
+    mIndex.reserve(count);
+    mPendingTransitions.reserve(pendingTransitions);
+    mCommittingTransitions.reserve(pendingTransitions);
   }
 
+  /**
+   * The memory resource used by the FSM.
+   * @return Memory resource given on construction.
+   */
+  std::pmr::memory_resource* resource() const {
+#ifdef CppAIKit_INSTRUMENTATION
+    return mCounter->upstream();
+#else
+    return mResource;
+#endif
+  }
+
+  /**
+   * Bytes written by writeSnapshot() for the machine as it is now.
+   */
+  std::size_t snapshotSize() const {
+    std::size_t size = kSnapshotHeaderSize;
+    if constexpr (StateSerializer<TState>::kEnabled) {
+      size += sizeof(std::uint32_t);
+      for (const auto& slot : mSlots) {
+        if (slot.isUsed()) {
+          size += 2 * sizeof(std::uint32_t) + StateSerializer<TState>::size(*slot.state);
+        }
+      }
+    }
+    return size;
+  }
+
+  /**
+   * Write a binary snapshot of the machine: the slots of the current and previous states and, if
+   * fsm::StateSerializer is specialized for \a TState, the payload of every state.
+   * Snapshots hold slot indices, not pointers, ids nor generations: 8 bytes per machine without payloads, little
+   * endian. Generations are left out so a snapshot can be restored on a machine rebuilt from scratch even if the saved
+   * machine had removed and added states.
+   * @param output Receives the snapshot, must have room for snapshotSize() bytes.
+   * @return Bytes written, equal to snapshotSize().
+   * @note Transition tables, pending transitions, inbox and history are not part of the snapshot.
+   * @sa readSnapshot()
+   * @sa fsm::saveSnapshots()
+   */
+  std::size_t writeSnapshot(unsigned char* output) const {
+    detail::writeUint32(output, currentSlot());
+    detail::writeUint32(output + 4, mPreviousState.isSet() ? mPreviousState.handle.index : StateHandle::kInvalidIndex);
+    std::size_t position = kSnapshotHeaderSize;
+
+    if constexpr (StateSerializer<TState>::kEnabled) {
+      const std::size_t countPosition = position;
+      std::uint32_t count = 0;
+      position += sizeof(std::uint32_t);
+      for (std::uint32_t index = 0; index < mSlots.size(); ++index) {
+        if (mSlots[index].isUsed()) {
+          const std::size_t size = StateSerializer<TState>::size(*mSlots[index].state);
+          detail::writeUint32(output + position, index);
+          detail::writeUint32(output + position + 4, static_cast<std::uint32_t>(size));
+          StateSerializer<TState>::write(*mSlots[index].state, output + position + 8);
+          position += 2 * sizeof(std::uint32_t) + size;
+          ++count;
+        }
+      }
+      detail::writeUint32(output + countPosition, count);
+    }
+
+    return position;
+  }
+
+  /**
+   * Restore the machine from a snapshot written by writeSnapshot().
+   * The current and previous states are set from the slots, like setCurrentState() does: fsm::State::onExit() and
+   * fsm::State::onEnter() are not called, pending transitions are dropped and the change of current state is recorded
+   * on the history, the trace and the profiler.
+   * @param input The snapshot.
+   * @param size Bytes available on \a input.
+   * @return Bytes read, 0 if the snapshot is truncated or refers to states not on the machine, in which case the
+   * current and previous states are not changed.
+   * @note The machine must have the states it had when saved on the same slots, e.g. rebuilt by adding the same states
+   * in the same order. Only the slots are checked: handles taken before the restore may refer to other states.
+   * @attention Payloads are read state by state, if fsm::StateSerializer::read() fails for a state the payloads read
+   * before it stay restored.
+   * @sa fsm::loadSnapshots()
+   */
+  std::size_t readSnapshot(const unsigned char* input, std::size_t size) {
+    if (size < kSnapshotHeaderSize) {
+      return 0;
+    }
+
+    const std::uint32_t current = detail::readUint32(input);
+    const std::uint32_t previous = detail::readUint32(input + 4);
+    if (!isSnapshotSlot(current) || !isSnapshotSlot(previous)) {
+      return 0;
+    }
+    std::size_t position = kSnapshotHeaderSize;
+
+    if constexpr (StateSerializer<TState>::kEnabled) {
+      if (size - position < sizeof(std::uint32_t)) {
+        return 0;
+      }
+      const std::uint32_t count = detail::readUint32(input + position);
+      position += sizeof(std::uint32_t);
+
+      for (std::uint32_t i = 0; i < count; ++i) {
+        if (size - position < 2 * sizeof(std::uint32_t)) {
+          return 0;
+        }
+        const std::uint32_t index = detail::readUint32(input + position);
+        const std::size_t payloadSize = detail::readUint32(input + position + 4);
+        position += 2 * sizeof(std::uint32_t);
+        if (size - position < payloadSize || index >= mSlots.size() || !mSlots[index].isUsed() ||
+            !StateSerializer<TState>::read(*mSlots[index].state, input + position, payloadSize)) {
+          return 0;
+        }
+        position += payloadSize;
+      }
+    }
+
+    if (current != StateHandle::kInvalidIndex) {
+      setCurrentSlot(current);
+    } else if (hasCurrentState()) {
+      clearCurrentSlot();
+    }
+    mPreviousState = (previous != StateHandle::kInvalidIndex) ? stateRef(previous) : StateRef{};
+    mPendingTransitions.clear();
+    return position;
+  }
+
+  /**
+   * The profiling policy of the machine.
+   * @return The policy given as \a TProfiler, e.g. to attach a fsm::ProfileStats to a fsm::Profiler.
+   */
+  TProfiler& profiler() {
+    return this->heldProfiler();
+  }
+
+  /// @copydoc profiler()
+  const TProfiler& profiler() const {
+    return this->heldProfiler();
+  }
+
+#ifdef CppAIKit_TRACING
+  /**
+   * Id of the machine on the records of aikit::trace, only available when CppAIKit_TRACING is defined.
+   * @return An id unique in the program, unless changed with setTraceId().
+   */
+  std::uint32_t traceId() const {
+    return mTraceId;
+  }
+
+  /**
+   * Change the id of the machine on the records of aikit::trace, e.g. to the id of its agent.
+   * @param id The new id.
+   */
+  void setTraceId(std::uint32_t id) {
+    mTraceId = id;
+  }
+#endif
+
+#ifdef CppAIKit_INSTRUMENTATION
+  /**
+   * The allocations of the machine, only available when CppAIKit_INSTRUMENTATION is defined.
+   * Every allocation of the machine is counted: states, tables, pending transitions, inbox and history.
+   * @return Counters since construction or the last call to resetAllocationStats().
+   * @note The counters are also added to the totals of aikit::InstrumentedModule::FSM.
+   * @note Guards and actions of the transition table may allocate outside of the memory resource, those allocations
+   * are not counted.
+   */
+  const AllocationStats& allocationStats() const {
+    return mCounter->stats();
+  }
+
+  /**
+   * Reset the counters of allocationStats(), e.g. after warming up the machine.
+   */
+  void resetAllocationStats() {
+    mCounter->resetStats();
+  }
+#endif
+
  private:
   struct StateRef {
+    StateHandle handle{}; ///< Handle of the state.
     const TId* id = nullptr; ///< State id of a FSM.
     TState* state = nullptr; ///< State of a FSM.
 
     bool isSet() const { return state != nullptr; }
 
     void clear() {
+      handle = {};
       id = nullptr;
       state = nullptr;
     }
   };
 
-  std::map<TId, std::unique_ptr<TState>> mStates; ///< Mapping of states and associated ids.
+  struct NodeBase {
+    NodeBase(std::pmr::memory_resource* nodeResource, TId&& nodeId)
+        : resource(nodeResource), id(makeId(nodeResource, std::move(nodeId))) {}
+    virtual ~NodeBase() = default;
+
+    /// Destroy the node and return its memory to the resource it was allocated from.
+    virtual void destroy() = 0;
+
+    static TId makeId(std::pmr::memory_resource* nodeResource, TId&& nodeId) {
+      // Allocator aware ids (e.g. std::pmr::string) also take their memory from the resource
+      if constexpr (std::uses_allocator_v<TId, std::pmr::polymorphic_allocator<std::byte>>) {
+        return TId(std::move(nodeId), std::pmr::polymorphic_allocator<std::byte>(nodeResource));
+      } else {
+        return TId(std::move(nodeId));
+      }
+    }
+
+    std::pmr::memory_resource* resource; ///< Resource the node was allocated from.
+    const TId id; ///< Id of the state, never moved while the state is on the FSM.
+  };
+
+  /// A state allocated together with its id.
+  template<typename TNodeState>
+  struct Node final : NodeBase {
+    template<typename TNodeStateRef>
+    Node(std::pmr::memory_resource* nodeResource, TId&& nodeId, TNodeStateRef&& nodeState)
+        : NodeBase(nodeResource, std::move(nodeId)), state(std::forward<TNodeStateRef>(nodeState)) {}
+
+    void destroy() override {
+      std::pmr::memory_resource* nodeResource = this->resource;
+      this->~Node();
+      nodeResource->deallocate(this, sizeof(Node), alignof(Node));
+    }
+
+    TNodeState state;
+  };
+
+  struct NodeDeleter {
+    void operator()(NodeBase* node) const { node->destroy(); }
+  };
+
+  static constexpr std::uint32_t kNoCallbacks = ~std::uint32_t{0};
+
+  /// Current and previous slots at the start of every snapshot.
+  static constexpr std::size_t kSnapshotHeaderSize = 2 * sizeof(std::uint32_t);
+
+  /// A cell of the transition table.
+  struct TransitionEntry {
+    StateHandle target{}; ///< State entered by the transition, unset if there is no transition.
+    std::uint32_t callbacks = kNoCallbacks; ///< Index on mTransitionCallbacks, kept apart to keep the table dense.
+  };
+
+  struct TransitionCallbacks {
+    Guard_type guard;
+    Action_type action;
+  };
+
+  /// A transition waiting for commitTransitions(), either to a state or through the transition table.
+  struct PendingTransition {
+    StateHandle target; ///< State transitioned to, used when event is unset.
+    EventHandle event; ///< Event dispatched.
+  };
+
+  /**
+   * Samples the update of the current state with the profiler and marks the machine as updating for the lifetime of
+   * the scope. If the update throws, the sample is still ended and the transitions requested so far are dropped.
+   */
+  class UpdateScope {
+   public:
+    UpdateScope(FSM& fsm, std::uint32_t slot)
+        : mFsm(fsm), mSlot(slot), mExceptions(std::uncaught_exceptions()), mUpdating(fsm.mUpdating) {
+      mFsm.heldProfiler().beginUpdate(mSlot);
+    }
+
+    ~UpdateScope() {
+      mFsm.heldProfiler().endUpdate(mSlot);
+      if (std::uncaught_exceptions() > mExceptions) {
+        mFsm.mPendingTransitions.clear();
+      }
+    }
+
+    UpdateScope(const UpdateScope&) = delete;
+    UpdateScope& operator=(const UpdateScope&) = delete;
+
+   private:
+    FSM& mFsm;
+    const std::uint32_t mSlot; ///< Slot of the state updated.
+    const int mExceptions; ///< Exceptions in flight when the scope was entered.
+    const detail::UpdatingScope mUpdating; ///< Marks the machine as updating until the scope ends.
+  };
+
+  typedef MPSCQueue<EventHandle> Inbox;
+
+  struct InboxDeleter {
+    void operator()(Inbox* inbox) const {
+      std::pmr::memory_resource* inboxResource = inbox->resource();
+      inbox->~Inbox();
+      inboxResource->deallocate(inbox, sizeof(Inbox), alignof(Inbox));
+    }
+  };
+
+  struct Slot {
+    std::unique_ptr<NodeBase, NodeDeleter> node; ///< Owner of the state, nullptr when the slot is free.
+    TState* state = nullptr; ///< Cached pointer to the state owned by node.
+    std::uint32_t generation = 0; ///< Incremented every time the slot is released.
+
+    bool isUsed() const { return node != nullptr; }
+  };
+
+  std::uint32_t acquireSlot() {
+    if (!mFreeSlots.empty()) {
+      const auto slot = mFreeSlots.back();
+      mFreeSlots.pop_back();
+      return slot;
+    }
+
+    mSlots.emplace_back();
+    mTransitionTable.resize(mSlots.size() * mEventCount);
+    return static_cast<std::uint32_t>(mSlots.size() - 1);
+  }
+
+  void releaseSlot(std::uint32_t slot) {
+    mSlots[slot].node.reset();
+    mSlots[slot].state = nullptr;
+    ++mSlots[slot].generation;
+    mFreeSlots.emplace_back(slot);
+
+    for (std::uint32_t event = 0; event < mEventCount; ++event) {
+      auto& entry = transitionEntry(slot, event);
+      releaseTransitionCallbacks(entry);
+      entry = {};
+    }
+  }
+
+  TransitionEntry& transitionEntry(std::uint32_t slot, std::uint32_t event) {
+    return mTransitionTable[slot * mEventCount + event];
+  }
+
+  std::uint32_t acquireTransitionCallbacks() {
+    if (!mFreeTransitionCallbacks.empty()) {
+      const auto callbacks = mFreeTransitionCallbacks.back();
+      mFreeTransitionCallbacks.pop_back();
+      return callbacks;
+    }
+
+    mTransitionCallbacks.emplace_back();
+    return static_cast<std::uint32_t>(mTransitionCallbacks.size() - 1);
+  }
+
+  void releaseTransitionCallbacks(TransitionEntry& entry) {
+    if (entry.callbacks != kNoCallbacks) {
+      mTransitionCallbacks[entry.callbacks] = {};
+      mFreeTransitionCallbacks.emplace_back(entry.callbacks);
+      entry.callbacks = kNoCallbacks;
+    }
+  }
+
+  StateRef stateRef(std::uint32_t slot) const {
+    return {{slot, mSlots[slot].generation}, &mSlots[slot].node->id, mSlots[slot].state};
+  }
+
+  void transitionToSlot(std::uint32_t slot, EventHandle event = {}, std::uint32_t callbacks = kNoCallbacks) {
+    recordHistory(slot, event);
+    traceTransition(slot, event);
+    this->heldProfiler().onTransition(currentSlot(), slot);
+
+    if (hasCurrentState()) {
+      mCurrentState.state->onExit();
+      mPreviousState = mCurrentState;
+    }
+
+    if (callbacks != kNoCallbacks && mTransitionCallbacks[callbacks].action) {
+      mTransitionCallbacks[callbacks].action();
+    }
+
+    mCurrentState = stateRef(slot);
+    mCurrentState.state->onEnter();
+  }
+
+  bool dispatchEvent(std::uint32_t event) {
+    if (!hasCurrentState()) {
+      return false;
+    }
+
+    const auto entry = transitionEntry(mCurrentState.handle.index, event);
+    if (!hasState(entry.target)) {
+      return false;
+    }
+
+    if (entry.callbacks != kNoCallbacks && mTransitionCallbacks[entry.callbacks].guard &&
+        !mTransitionCallbacks[entry.callbacks].guard()) {
+      return false;
+    }
+
+    transitionToSlot(entry.target.index, {event}, entry.callbacks);
+    return true;
+  }
+
+  void transitionOrDefer(std::uint32_t slot) {
+    if (mUpdating) {
+      mPendingTransitions.push_back({{slot, mSlots[slot].generation}, {}});
+    } else {
+      transitionToSlot(slot);
+    }
+  }
+
+  void setCurrentSlot(std::uint32_t slot) {
+    recordHistory(slot, {});
+    traceTransition(slot, {});
+    this->heldProfiler().onTransition(currentSlot(), slot);
+
+    if (mCurrentState.isSet()) {
+      mPreviousState = mCurrentState;
+    }
+
+    mCurrentState = stateRef(slot);
+  }
+
+  /// Leave the machine without current state, recorded like setCurrentSlot().
+  void clearCurrentSlot() {
+    recordHistory(StateHandle::kInvalidIndex, {});
+    traceTransition(StateHandle::kInvalidIndex, {});
+    this->heldProfiler().onTransition(currentSlot(), StateHandle::kInvalidIndex);
+    mCurrentState.clear();
+  }
+
+  void recordHistory(std::uint32_t slot, EventHandle event) {
+    if (mHistory.empty()) {
+      return;
+    }
+
+    const StateHandle to = (slot != StateHandle::kInvalidIndex) ? StateHandle{slot, mSlots[slot].generation}
+                                                                 : StateHandle{};
+    mHistory[mHistoryNext] = {mCurrentState.handle, to, event, mTick};
+    mHistoryNext = (mHistoryNext + 1 == mHistory.size()) ? 0 : mHistoryNext + 1;
+    mHistorySize = std::min(mHistorySize + 1, mHistory.size());
+  }
+
+  std::uint32_t currentSlot() const {
+    return mCurrentState.isSet() ? mCurrentState.handle.index : StateHandle::kInvalidIndex;
+  }
+
+  /// True if \a slot, read from a snapshot, is unset or holds a state.
+  bool isSnapshotSlot(std::uint32_t slot) const {
+    return slot == StateHandle::kInvalidIndex || (slot < mSlots.size() && mSlots[slot].isUsed());
+  }
+
+  void traceTransition([[maybe_unused]] std::uint32_t slot, [[maybe_unused]] EventHandle event) const {
+#ifdef CppAIKit_TRACING
+    trace::recordTransition(mTraceId, currentSlot(), slot, event.isSet() ? event.index : trace::kNone);
+#endif
+  }
+
+  void removeSlot(std::uint32_t slot) {
+    const bool isCurrent = hasCurrentState() && (mCurrentState.handle.index == slot);
+    const bool isPrevious = hasPreviousState() && (mPreviousState.handle.index == slot);
+
+    if (isCurrent) {
+      if (hasPreviousState()) {
+        if (isPrevious) {
+          mCurrentState.state->onExit();
+          clearCurrentSlot();
+          mPreviousState.clear();
+        } else {
+          transitionToSlot(mPreviousState.handle.index);
+          mPreviousState = mCurrentState;
+        }
+      } else {
+        mCurrentState.state->onExit();
+        clearCurrentSlot();
+      }
+    } else if (isPrevious) {
+      mPreviousState.clear();
+    }
+
+    mIndex.erase(mSlots[slot].node->id);
+    releaseSlot(slot);
+  }
+
+#ifdef CppAIKit_INSTRUMENTATION
+  std::unique_ptr<CountingResource> mCounter; ///< Wraps the resource given on construction, outlives every member.
+#endif
+  std::pmr::memory_resource* mResource; ///< Resource of all allocations of the machine.
+  detail::ResourceVector<Slot> mSlots; ///< States of the FSM, indexed by mIndex and by handles.
+  detail::ResourceVector<std::uint32_t> mFreeSlots; ///< Slots released by removeState() available for reuse.
+  typename TStorage::template Index<TId> mIndex; ///< Mapping of ids to slots.
   StateRef mPreviousState{};
   StateRef mCurrentState{};
+  std::uint32_t mEventCount = 0; ///< Number of events, also the length of each row of the transition table.
+  detail::ResourceVector<TransitionEntry> mTransitionTable; ///< Transitions indexed by [slot * mEventCount + event].
+  detail::ResourceVector<TransitionCallbacks> mTransitionCallbacks; ///< Guards and actions of the transition table.
+  detail::ResourceVector<std::uint32_t> mFreeTransitionCallbacks; ///< Callbacks released available for reuse.
+  detail::ResourceVector<PendingTransition> mPendingTransitions; ///< Transitions requested and not committed yet.
+  detail::ResourceVector<PendingTransition> mCommittingTransitions; ///< Transitions being committed, reused by commits.
+  std::unique_ptr<Inbox, InboxDeleter> mInbox; ///< Events sent by other threads, nullptr until enableInbox().
+  detail::ResourceVector<HistoryEntry> mHistory; ///< Ring buffer of changes of current state, empty if disabled.
+  std::size_t mHistoryNext = 0; ///< Position of mHistory written by the next change.
+  std::size_t mHistorySize = 0; ///< Number of entries of mHistory in use.
+  std::uint64_t mTick = 0; ///< Number of updates, timestamp of the history.
+  bool mUpdating = false; ///< True while the current state is being updated.
+#ifdef CppAIKit_TRACING
+  std::uint32_t mTraceId = trace::newMachineId(); ///< Id of the machine on the trace records.
+#endif
 };
 
 }
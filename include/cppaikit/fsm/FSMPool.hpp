@@ -0,0 +1,397 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "State.hpp"
+#include "StateHandle.hpp"
+
+namespace aikit::fsm {
+
+/**
+ * Container of many machines (agents) sharing the same set of states.
+ * States are defined once with addState(), each agent receives its own copy of every state. Copies of the same state
+ * are stored contiguously, one array per state, and the current state of every agent is kept in a single array.
+ * updateAll() groups agents by current state and updates each state as a batch, replacing a virtual call per agent by
+ * a single call to fsm::State::updateBatch() per state.
+ * @tparam TId Type for the id of a state. Defaults to std::string.
+ * @tparam TState Base type for the states managed by the pool. Defaults to fsm::State<int>.
+ * @note States can not be removed from a pool and agents can not be removed.
+ * @attention Pointers to states are invalidated by addAgent(), use reserveAgents() to avoid it.
+ * @sa fsm::FSM
+ */
+template<typename TId = std::string, typename TState = State<int>>
+class FSMPool {
+ public:
+  typedef TId Id_type;
+  typedef typename TState::UpdateData_type UpdateData_type;
+  typedef std::uint32_t AgentId;
+
+  /**
+   * Adds a new state to the pool.
+   * Every agent, existing or added later, receives a copy of \a state.
+   * @param id Identification of the state being added.
+   * @param state The state being added. It must inherit from \a TState and be copy constructible.
+   * @return Handle to the added state.
+   * @note If any state with equivalent \a id already exists, does nothing and returns an unset handle.
+   */
+  template<typename TNewState>
+  StateHandle addState(TId id, TNewState&& state) {
+    using TNewStateNoRef = std::remove_cv_t<std::remove_reference_t<TNewState>>;
+    static_assert(std::is_base_of_v<TState, TNewStateNoRef>,
+                  "addState() is only callable with state that is derived from TState");
+
+    const auto index = static_cast<std::uint32_t>(mColumns.size());
+    if (!mIds.try_emplace(std::move(id), index).second) {
+      return {};
+    }
+
+    auto column =
+        aikit::detail::makeModulePtr<ColumnBase, kModule, Column<TNewStateNoRef>>(std::forward<TNewState>(state));
+    column->resize(agentCount());
+    mColumns.emplace_back(std::move(column));
+    mGroupingValid = false;
+
+    return {index, 0};
+  }
+
+  /**
+   * Adds a new agent to the pool, with its own copy of every state and no current state.
+   * @return Id of the new agent, agents are numbered sequentially from 0.
+   */
+  AgentId addAgent() {
+    const auto agent = static_cast<AgentId>(agentCount());
+    for (auto& column : mColumns) {
+      column->resize(agent + std::size_t{1});
+    }
+
+    mCurrentStates.emplace_back(kNoState);
+    mPreviousStates.emplace_back(kNoState);
+    mGroupingValid = false;
+    return agent;
+  }
+
+  /**
+   * Reserve space for \a count agents, avoiding reallocations while adding them.
+   * @param count Total number of agents expected on the pool.
+   */
+  void reserveAgents(std::size_t count) {
+    for (auto& column : mColumns) {
+      column->reserve(count);
+    }
+
+    mCurrentStates.reserve(count);
+    mPreviousStates.reserve(count);
+    mBatchAgents.reserve(count);
+  }
+
+  /**
+   * Number of agents in the pool.
+   */
+  std::size_t agentCount() const {
+    return mCurrentStates.size();
+  }
+
+  /**
+   * Number of states in the pool.
+   */
+  std::size_t size() const {
+    return mColumns.size();
+  }
+
+  /**
+   * Checks if the pool has a state with a given \a id.
+   */
+  bool hasState(const TId& id) const {
+    return mIds.count(id) > 0;
+  }
+
+  /**
+   * Checks if \a handle refers to a state in the pool.
+   */
+  bool hasState(StateHandle handle) const {
+    return handle.index < mColumns.size() && handle.generation == 0;
+  }
+
+  /**
+   * Resolve the handle of the state with the associated \a id.
+   * @return Handle of the state, unset if there is no state with \a id.
+   */
+  StateHandle stateHandle(const TId& id) const {
+    const auto found = mIds.find(id);
+    if (found != mIds.end()) {
+      return {found->second, 0};
+    } else {
+      return {};
+    }
+  }
+
+  /**
+   * Transition \a agent to a state, following the same rules of fsm::FSM::transitionTo().
+   * @param agent Agent being transitioned.
+   * @param handle Handle of the state that will be transitioned to.
+   * @return True if \a handle refers to a state on the pool.
+   */
+  bool transitionTo(AgentId agent, StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      transitionToIndex(agent, handle.index);
+    }
+
+    return validHandle;
+  }
+
+  /**
+   * Transition \a agent to a state, following the same rules of fsm::FSM::transitionTo().
+   * @param agent Agent being transitioned.
+   * @param id Identification of the state that will be transitioned to.
+   * @return True if \a id was found on the pool.
+   */
+  bool transitionTo(AgentId agent, const TId& id) {
+    return transitionTo(agent, stateHandle(id));
+  }
+
+  /**
+   * Transition \a agent to its previous state.
+   * @return True if there was a previous state to transition to.
+   */
+  bool transitionToPreviousState(AgentId agent) {
+    const bool hasPrevious = hasPreviousState(agent);
+    if (hasPrevious) {
+      transitionToIndex(agent, mPreviousStates[agent]);
+    }
+
+    return hasPrevious;
+  }
+
+  /**
+   * Set the current state of \a agent, following the same rules of fsm::FSM::setCurrentState().
+   * @return True if \a handle refers to a state on the pool.
+   */
+  bool setCurrentState(AgentId agent, StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      if (hasCurrentState(agent)) {
+        mPreviousStates[agent] = mCurrentStates[agent];
+      }
+
+      mCurrentStates[agent] = handle.index;
+      ++mStateChanges;
+    }
+
+    return validHandle;
+  }
+
+  /**
+   * Set the current state of \a agent, following the same rules of fsm::FSM::setCurrentState().
+   * @return True if \a id was found on the pool.
+   */
+  bool setCurrentState(AgentId agent, const TId& id) {
+    return setCurrentState(agent, stateHandle(id));
+  }
+
+  /**
+   * Check if \a agent has a current state set.
+   */
+  bool hasCurrentState(AgentId agent) const {
+    return mCurrentStates[agent] != kNoState;
+  }
+
+  /**
+   * The handle of the current state of \a agent, unset if no state is set.
+   */
+  StateHandle currentStateHandle(AgentId agent) const {
+    return handleOf(mCurrentStates[agent]);
+  }
+
+  /**
+   * Check if \a agent has a state previously set.
+   */
+  bool hasPreviousState(AgentId agent) const {
+    return mPreviousStates[agent] != kNoState;
+  }
+
+  /**
+   * The handle of the previous state of \a agent, unset if no previous state is set.
+   */
+  StateHandle previousStateHandle(AgentId agent) const {
+    return handleOf(mPreviousStates[agent]);
+  }
+
+  /**
+   * The current state of \a agent.
+   * @attention Can be nullptr if no state is set.
+   */
+  TState* currentState(AgentId agent) {
+    return hasCurrentState(agent) ? &mColumns[mCurrentStates[agent]]->at(agent) : nullptr;
+  }
+
+  /**
+   * The copy of the state referred by \a handle owned by \a agent.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  TState* getState(AgentId agent, StateHandle handle) {
+    return hasState(handle) ? &mColumns[handle.index]->at(agent) : nullptr;
+  }
+
+  /**
+   * The copy of the state referred by \a handle owned by \a agent.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  const TState* getState(AgentId agent, StateHandle handle) const {
+    return hasState(handle) ? &mColumns[handle.index]->at(agent) : nullptr;
+  }
+
+  /**
+   * Update the current state of a single agent.
+   * @note If \a agent has no current state, the call is ignored.
+   */
+  void update(AgentId agent, UpdateData_type updateData) {
+    if (hasCurrentState(agent)) {
+      mColumns[mCurrentStates[agent]]->at(agent).update(updateData);
+    }
+  }
+
+  /**
+   * Update the current state of all agents.
+   * Agents are grouped by current state, in increasing order of agent id, and fsm::State::updateBatch() is called once
+   * for each state with agents.
+   * @param updateData The data that will be passed to update() of every current state.
+   * @note Agents without current state are ignored.
+   * @note Transitions made during the call are allowed, an agent that leaves a state before the batch of that state
+   * is updated will not be updated again on the same call.
+   */
+  void updateAll(UpdateData_type updateData) {
+    // Grouping is kept between calls while no agent changes state
+    if (!mGroupingValid || mGroupedAtChange != mStateChanges) {
+      groupAgentsByState();
+    }
+    const auto groupedAtChange = mStateChanges;
+
+    for (std::size_t state = 0; state < mColumns.size(); ++state) {
+      AgentId* begin = mBatchAgents.data() + mBatchOffsets[state];
+      AgentId* end = mBatchAgents.data() + mBatchOffsets[state + 1];
+
+      if (mStateChanges != groupedAtChange) {
+        mGroupingValid = false;
+        // Drop agents that left the state while updating previous batches
+        const auto stateIndex = static_cast<std::uint32_t>(state);
+        end = std::remove_if(begin, end, [&](AgentId agent) { return mCurrentStates[agent] != stateIndex; });
+      }
+
+      if (begin != end) {
+        mColumns[state]->updateBatch(begin, static_cast<std::size_t>(end - begin), updateData);
+      }
+    }
+  }
+
+ private:
+  static constexpr std::uint32_t kNoState = StateHandle::kInvalidIndex;
+  static constexpr InstrumentedModule kModule = InstrumentedModule::FSMPool;
+
+  template<typename T>
+  using Vector = aikit::detail::ModuleVector<T, kModule>;
+
+  struct ColumnBase {
+    virtual ~ColumnBase() = default;
+
+    virtual void resize(std::size_t count) = 0;
+    virtual void reserve(std::size_t count) = 0;
+    virtual TState& at(AgentId agent) = 0;
+    virtual const TState& at(AgentId agent) const = 0;
+    virtual void updateBatch(const AgentId* agents, std::size_t count, UpdateData_type updateData) = 0;
+  };
+
+  /// Copies of a state for every agent, indexed by agent id.
+  template<typename TColumnState>
+  struct Column final : ColumnBase {
+    template<typename TPrototype>
+    explicit Column(TPrototype&& columnPrototype) : prototype(std::forward<TPrototype>(columnPrototype)) {}
+
+    void resize(std::size_t count) override { states.resize(count, prototype); }
+
+    void reserve(std::size_t count) override { states.reserve(count); }
+
+    TState& at(AgentId agent) override { return states[agent]; }
+
+    const TState& at(AgentId agent) const override { return states[agent]; }
+
+    void updateBatch(const AgentId* agents, std::size_t count, UpdateData_type updateData) override {
+      // Resolves to the batched update of the state type, if it has one, or to fsm::State::updateBatch()
+      TColumnState::updateBatch(StateBatch<TColumnState>{{states.data(), states.size()}, {agents, count}}, updateData);
+    }
+
+    TColumnState prototype; ///< State copied to new agents.
+    Vector<TColumnState> states;
+  };
+
+  StateHandle handleOf(std::uint32_t state) const {
+    if (state != kNoState) {
+      return {state, 0};
+    } else {
+      return {};
+    }
+  }
+
+  void transitionToIndex(AgentId agent, std::uint32_t state) {
+    if (hasCurrentState(agent)) {
+      mColumns[mCurrentStates[agent]]->at(agent).onExit();
+      mPreviousStates[agent] = mCurrentStates[agent];
+    }
+
+    mCurrentStates[agent] = state;
+    ++mStateChanges;
+    mColumns[state]->at(agent).onEnter();
+  }
+
+  /// Counting sort of the agents by current state into mBatchAgents, ranges delimited by mBatchOffsets.
+  void groupAgentsByState() {
+    mBatchOffsets.assign(mColumns.size() + 1, 0);
+    for (const auto state : mCurrentStates) {
+      if (state != kNoState) {
+        ++mBatchOffsets[state + 1];
+      }
+    }
+
+    for (std::size_t state = 1; state < mBatchOffsets.size(); ++state) {
+      mBatchOffsets[state] += mBatchOffsets[state - 1];
+    }
+
+    mBatchCursors.assign(mBatchOffsets.begin(), mBatchOffsets.end() - 1);
+    mBatchAgents.resize(mBatchOffsets.back());
+    for (std::size_t agent = 0; agent < mCurrentStates.size(); ++agent) {
+      const auto state = mCurrentStates[agent];
+      if (state != kNoState) {
+        mBatchAgents[mBatchCursors[state]++] = static_cast<AgentId>(agent);
+      }
+    }
+
+    mGroupedAtChange = mStateChanges;
+    mGroupingValid = true;
+  }
+
+  typedef std::pair<const TId, std::uint32_t> IdEntry;
+
+  /// Mapping of ids to states.
+  std::map<TId, std::uint32_t, std::less<TId>, aikit::detail::ModuleAllocator<IdEntry, kModule>> mIds;
+  Vector<aikit::detail::ModulePtr<ColumnBase, kModule>> mColumns; ///< Copies of every state, indexed by state handle.
+  Vector<std::uint32_t> mCurrentStates; ///< Current state of every agent, indexed by agent id.
+  Vector<std::uint32_t> mPreviousStates; ///< Previous state of every agent, indexed by agent id.
+  Vector<AgentId> mBatchAgents; ///< Agents grouped by current state, reused between updates.
+  Vector<std::size_t> mBatchOffsets; ///< Start of the agents of each state in mBatchAgents.
+  Vector<std::size_t> mBatchCursors; ///< Insertion point of each state while grouping agents.
+  std::uint64_t mStateChanges = 0; ///< Number of changes of current state, detects outdated grouping.
+  std::uint64_t mGroupedAtChange = 0; ///< Value of mStateChanges when agents were last grouped.
+  bool mGroupingValid = false; ///< False when states or agents were added or a batch was filtered.
+};
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "../Span.hpp"
+#include "../WorkStealingPool.hpp"
+
+namespace aikit::fsm {
+
+namespace detail {
+
+template<typename T, typename = void>
+struct HasDeferredTransitions : std::false_type {};
+
+template<typename T>
+struct HasDeferredTransitions<T, std::void_t<decltype(std::declval<T&>().commitTransitions())>> : std::true_type {};
+
+template<typename T, typename = void>
+struct HasInbox : std::false_type {};
+
+template<typename T>
+struct HasInbox<T, std::void_t<decltype(std::declval<T&>().dispatchInbox())>> : std::true_type {};
+
+}
+
+/**
+ * Updates many independent machines in parallel.
+ * Machines are split in chunks of consecutive machines that are run by a aikit::WorkStealingPool. Every call to
+ * update() is a full tick: it returns only after all machines were updated.
+ * For machines with deferred transitions (as fsm::FSM), states are updated in parallel with
+ * fsm::FSM::updateCurrentState() and, after all threads join, transitions are committed in a single serial pass in
+ * the order of the machines. Inboxes (if any) are also dispatched serially, in a pass before the parallel update.
+ * All fsm::State::onExit() and fsm::State::onEnter() calls happen on the calling thread, in the same order,
+ * independently of the number of threads.
+ * @tparam TFSM Type of the machines, usually a fsm::FSM. It must have an update() method taking UpdateData_type, or
+ * updateCurrentState() and commitTransitions() methods.
+ * @attention Machines are updated concurrently, states must not access other machines or shared data without
+ * synchronization. Each machine is updated by a single thread, in the same way fsm::FSM::update() would.
+ * @sa fsm::FSM::update()
+ */
+template<typename TFSM>
+class FSMScheduler {
+ public:
+  typedef typename TFSM::UpdateData_type UpdateData_type;
+
+  /**
+   * Create the scheduler and its threads.
+   * @param threadCount Number of threads updating machines, including the calling thread. Zero uses one thread per
+   * hardware thread.
+   * @param chunkSize Number of consecutive machines updated by a thread before looking for more work.
+   */
+  explicit FSMScheduler(std::size_t threadCount = 0, std::size_t chunkSize = 64)
+      : mPool(threadCount), mChunkSize(chunkSize) {}
+
+  /**
+   * Update all \a machines, returning when all of them were updated.
+   * @param machines Machines being updated.
+   * @param updateData The data passed to the update() of every machine.
+   * @note If an update throws, the first exception is rethrown once all threads stopped and no transition of the tick
+   * is committed. Machines not updated yet are skipped.
+   */
+  void update(Span<TFSM> machines, UpdateData_type updateData) {
+    updateMachines(machines.size(), [&](std::size_t i) -> TFSM& { return machines[i]; }, updateData);
+  }
+
+  /**
+   * Update all \a machines, returning when all of them were updated.
+   * @param machines Pointers to the machines being updated.
+   * @param updateData The data passed to the update() of every machine.
+   */
+  void update(Span<TFSM* const> machines, UpdateData_type updateData) {
+    updateMachines(machines.size(), [&](std::size_t i) -> TFSM& { return *machines[i]; }, updateData);
+  }
+
+  /**
+   * Number of threads updating machines, including the calling thread.
+   */
+  std::size_t threadCount() const {
+    return mPool.threadCount();
+  }
+
+  /**
+   * Number of consecutive machines updated by a thread before looking for more work.
+   */
+  std::size_t chunkSize() const {
+    return mChunkSize;
+  }
+
+  /**
+   * Change the number of consecutive machines updated by a thread before looking for more work.
+   * Small chunks balance uneven machines better, large chunks reduce scheduling overhead.
+   */
+  void setChunkSize(std::size_t chunkSize) {
+    mChunkSize = chunkSize;
+  }
+
+ private:
+  template<typename TGetMachine>
+  void updateMachines(std::size_t count, const TGetMachine& machineAt, UpdateData_type updateData) {
+    if constexpr (detail::HasDeferredTransitions<TFSM>::value) {
+      if constexpr (detail::HasInbox<TFSM>::value) {
+        for (std::size_t i = 0; i < count; ++i) {
+          machineAt(i).dispatchInbox();
+        }
+      }
+
+      mPool.parallelFor(count, mChunkSize, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          machineAt(i).updateCurrentState(updateData);
+        }
+      });
+
+      for (std::size_t i = 0; i < count; ++i) {
+        machineAt(i).commitTransitions();
+      }
+    } else {
+      mPool.parallelFor(count, mChunkSize, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          machineAt(i).update(updateData);
+        }
+      });
+    }
+  }
+
+  WorkStealingPool mPool;
+  std::size_t mChunkSize;
+};
+
+}
@@ -0,0 +1,545 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "State.hpp"
+#include "StateHandle.hpp"
+#include "Storage.hpp"
+
+namespace aikit::fsm {
+
+/**
+ * Implementation for a Hierarchical Finite State Machine.
+ * States can be nested inside other states. The machine is always on a leaf state, which together with all its
+ * ancestors forms the active states. A transition exits the active states up to the least common ancestor of the
+ * current and target states, then enters the states down to the target and, if the target has children, through the
+ * initial children down to a leaf.
+ * Exit and enter sequences of every (leaf, target) pair are precomputed by build() into flat arrays, so a transition
+ * is a linear walk over a contiguous range, without tree searches or allocations.
+ * @tparam TId Type for the id of a state. Defaults to std::string.
+ * @tparam TState Base type for the states managed by the machine. Defaults to fsm::State<int>.
+ * @tparam TStorage Storage policy used to index states by id. Defaults to fsm::storage::Map.
+ * @note Transitions are external: a transition to the current state or to one of its ancestors exits and enters the
+ * target again.
+ * @note States can not be removed, so handles are valid for the lifetime of the machine.
+ * @note The precomputed paths take memory proportional to the number of leaves times the number of states times the
+ * depth of the hierarchy.
+ * @sa fsm::State
+ * @sa fsm::FSM
+ */
+template<typename TId = std::string, typename TState = State<int>, typename TStorage = storage::Map>
+class HFSM {
+ public:
+  typedef TId Id_type;
+  typedef typename TState::UpdateData_type UpdateData_type;
+
+  /**
+   * Adds a new state to the HFSM.
+   * The first child added to a state is its initial state, entered when a transition targets the parent.
+   * @param id Identification of the state being added, this is used to reference the state in all other methods.
+   * @param state The state being added. It must inherit from the class fsm::State.
+   * @param parent Handle of the parent of the state, unset for a top level state.
+   * @return Handle to the added state.
+   * @note If any state with equivalent \a id already exists or \a parent is set but not valid, does nothing and
+   * returns an unset handle.
+   * @note Adding a state discards the precomputed paths, they are computed again by build().
+   * @sa setInitialState()
+   */
+  template<typename TNewState>
+  StateHandle addState(TId id, TNewState&& state, StateHandle parent = {}) {
+    using TNewStateNoRef = std::remove_reference_t<TNewState>;
+    static_assert(std::is_base_of_v<TState, TNewStateNoRef>,
+                  "addState() is only callable with state that is derived from TState");
+
+    if (mIndex.find(id) != nullptr || (parent.isSet() && !hasState(parent))) {
+      return {};
+    }
+
+    const auto index = static_cast<std::uint32_t>(mNodes.size());
+    Node node;
+    node.id = aikit::detail::makeModulePtr<const TId, kModule>(std::move(id));
+    mIndex.insert(*node.id, index);
+    node.state = aikit::detail::makeModulePtr<TState, kModule, TNewStateNoRef>(std::forward<TNewState>(state));
+    node.parent = parent.index;
+    if (parent.isSet()) {
+      node.depth = mNodes[parent.index].depth + 1;
+      if (mNodes[parent.index].initialChild == kNoState) {
+        mNodes[parent.index].initialChild = index;
+      }
+    }
+    mNodes.emplace_back(std::move(node));
+
+    mBuilt = false;
+    return {index, 0};
+  }
+
+  /**
+   * Adds a new state to the HFSM, nested inside the state with the associated \a parent id.
+   * @param id Identification of the state being added.
+   * @param state The state being added. It must inherit from the class fsm::State.
+   * @param parent Identification of the parent of the state.
+   * @return Handle to the added state, unset if \a id already exists or \a parent was not found.
+   * @sa addState(TId, TNewState&&, StateHandle)
+   */
+  template<typename TNewState>
+  StateHandle addState(TId id, TNewState&& state, const TId& parent) {
+    const auto parentHandle = stateHandle(parent);
+    if (!parentHandle.isSet()) {
+      return {};
+    }
+
+    return addState(std::move(id), std::forward<TNewState>(state), parentHandle);
+  }
+
+  /**
+   * Change the state entered when a transition targets \a parent.
+   * @param parent Handle of the parent state.
+   * @param child Handle of a direct child of \a parent.
+   * @return True if \a child is a direct child of \a parent.
+   * @note Discards the precomputed paths, they are computed again by build().
+   */
+  bool setInitialState(StateHandle parent, StateHandle child) {
+    if (!hasState(parent) || !hasState(child) || mNodes[child.index].parent != parent.index) {
+      return false;
+    }
+
+    mNodes[parent.index].initialChild = child.index;
+    mBuilt = false;
+    return true;
+  }
+
+  /**
+   * Precompute the exit and enter sequences of every transition.
+   * Should be called once after all states are added, so no transition pays for it.
+   * @note Transitions on a machine that was not built, or had states added after the last build, call build() first.
+   */
+  void build() {
+    const auto count = static_cast<std::uint32_t>(mNodes.size());
+
+    // Active chain of every state, from its top level ancestor down to itself
+    mChains.clear();
+    for (std::uint32_t index = 0; index < count; ++index) {
+      auto& node = mNodes[index];
+      node.chainOffset = static_cast<std::uint32_t>(mChains.size());
+      mChains.resize(mChains.size() + node.depth + 1);
+      for (std::uint32_t ancestor = index, depth = node.depth + 1; depth > 0; ancestor = mNodes[ancestor].parent) {
+        mChains[node.chainOffset + --depth] = ancestor;
+      }
+    }
+
+    // Only leaves can be current, so only they need a row of paths. The current state may have got children after it
+    // was set, it also gets a row until the next transition.
+    std::uint32_t leafCount = 0;
+    for (std::uint32_t index = 0; index < count; ++index) {
+      auto& node = mNodes[index];
+      node.leafRow = (node.initialChild == kNoState || index == mCurrentState) ? leafCount++ : kNoState;
+    }
+
+    mPaths.assign(std::size_t{leafCount} * count, Path{});
+    mPathStates.clear();
+    for (std::uint32_t source = 0; source < count; ++source) {
+      if (mNodes[source].leafRow == kNoState) {
+        continue;
+      }
+
+      for (std::uint32_t target = 0; target < count; ++target) {
+        buildPath(source, target);
+      }
+    }
+
+    mBuilt = true;
+  }
+
+  /**
+   * Transition to a state.
+   * fsm::State::onExit() is called for the active states from the current leaf up to the least common ancestor with
+   * \a handle, then fsm::State::onEnter() from below the common ancestor down to \a handle and through initial
+   * children down to a leaf, which is set as current.
+   * Previous state will be set with the leaf that was current.
+   * @param handle Handle of the state that will be transitioned to.
+   * @return True if \a handle refers to a state on the HFSM.
+   * @note If \a handle is not valid, the call is ignored.
+   * @note If there is no current state, only fsm::State::onEnter() is called, from the top level down.
+   * @note When called from inside fsm::State::update() of an active state, the transition is deferred and only
+   * happens after all active states finish updating.
+   * @sa fsm::State::onExit()
+   * @sa fsm::State::onEnter()
+   */
+  bool transitionTo(StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      transitionOrDefer(handle.index);
+    }
+
+    return validHandle;
+  }
+
+  /**
+   * Transition to a state.
+   * @param id Identification of the state that will be transitioned to.
+   * @return True if \a id was found on the HFSM.
+   * @sa transitionTo(StateHandle)
+   */
+  bool transitionTo(const TId& id) {
+    return transitionTo(stateHandle(id));
+  }
+
+  /**
+   * Transition to HFSM previous state.
+   * @return True if there was a previous state to transition to.
+   * @note If there is no previous state, the call is ignored.
+   * @sa transitionTo()
+   */
+  bool transitionToPreviousState() {
+    const bool hasPrevious = hasPreviousState();
+    if (hasPrevious) {
+      transitionOrDefer(mPreviousState);
+    }
+
+    return hasPrevious;
+  }
+
+  /**
+   * Set the current state of the HFSM.
+   * If \a handle has children, the current state is the leaf reached through initial children.
+   * @param handle Handle of the state that will be set as current.
+   * @return True if \a handle refers to a state on the HFSM.
+   * @note Previous state will be set with the state currently set (if any).
+   * @attention fsm::State::onExit() and fsm::State::onEnter() are not called.
+   */
+  bool setCurrentState(StateHandle handle) {
+    const bool validHandle = hasState(handle);
+
+    if (validHandle) {
+      if (hasCurrentState()) {
+        mPreviousState = mCurrentState;
+      }
+      mCurrentState = initialLeafOf(handle.index);
+    }
+
+    return validHandle;
+  }
+
+  /**
+   * Set the current state of the HFSM.
+   * @param id Identification of the state that will be set as current.
+   * @return True if \a id was found on the HFSM.
+   * @sa setCurrentState(StateHandle)
+   */
+  bool setCurrentState(const TId& id) {
+    return setCurrentState(stateHandle(id));
+  }
+
+  /**
+   * Update all active states, from the top level state down to the current leaf.
+   * Transitions made during the update are made right after all active states finish updating.
+   * @param updateData The data that will be passed during the call fsm::State::update() on the active states.
+   * @note If there is no current state, the call is ignored.
+   * @note If an active state transitions, the states below it are still updated on this call.
+   * @note If an active state throws, the transitions made during the update are dropped.
+   */
+  void update(UpdateData_type updateData) {
+    if (!hasCurrentState()) {
+      return;
+    }
+
+    ensureBuilt();
+
+    try {
+      const detail::UpdatingScope updating(mUpdating);
+      const auto& leaf = mNodes[mCurrentState];
+      for (std::uint32_t depth = 0; depth <= leaf.depth; ++depth) {
+        mNodes[mChains[leaf.chainOffset + depth]].state->update(updateData);
+      }
+    } catch (...) {
+      mPendingTransitions.clear();
+      throw;
+    }
+
+    for (std::size_t i = 0; i < mPendingTransitions.size(); ++i) {
+      transitionToIndex(mPendingTransitions[i]);
+    }
+    mPendingTransitions.clear();
+  }
+
+  /**
+   * Check if the HFSM has a current state set.
+   * @return True if there is a current state.
+   */
+  bool hasCurrentState() const {
+    return mCurrentState != kNoState;
+  }
+
+  /**
+   * The handle of the current leaf state of the HFSM.
+   * @return Handle of the current state, unset if no state is set.
+   */
+  StateHandle currentStateHandle() const {
+    return hasCurrentState() ? StateHandle{mCurrentState, 0} : StateHandle{};
+  }
+
+  /**
+   * The identification of the current leaf state of the HFSM.
+   * @return Id of the current state.
+   * @attention Can be nullptr if no state is set.
+   */
+  const TId* currentStateId() const {
+    return hasCurrentState() ? mNodes[mCurrentState].id.get() : nullptr;
+  }
+
+  /**
+   * The current leaf state of the HFSM.
+   * @return Current state of the HFSM.
+   * @attention Can be nullptr if no state is set.
+   */
+  TState* currentState() const {
+    return hasCurrentState() ? mNodes[mCurrentState].state.get() : nullptr;
+  }
+
+  /**
+   * Check if the HFSM has a state previously set.
+   * @return True if there is a previous state.
+   */
+  bool hasPreviousState() const {
+    return mPreviousState != kNoState;
+  }
+
+  /**
+   * The handle of the previous leaf state of the HFSM.
+   * @return Handle of the previous state, unset if no previous state is set.
+   */
+  StateHandle previousStateHandle() const {
+    return hasPreviousState() ? StateHandle{mPreviousState, 0} : StateHandle{};
+  }
+
+  /**
+   * Check if a state is active, that is, if it is the current leaf or one of its ancestors.
+   * @param handle The handle of a state.
+   * @return True if \a handle is active.
+   */
+  bool isInState(StateHandle handle) const {
+    if (!hasState(handle) || !hasCurrentState()) {
+      return false;
+    }
+
+    for (auto index = mCurrentState; index != kNoState; index = mNodes[index].parent) {
+      if (index == handle.index) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Check if a state is active.
+   * @param id The identification of a state.
+   * @return True if the state with \a id is active.
+   * @sa isInState(StateHandle)
+   */
+  bool isInState(const TId& id) const {
+    return isInState(stateHandle(id));
+  }
+
+  /**
+   * The parent of a state.
+   * @param handle The handle of a state.
+   * @return Handle of the parent, unset for top level states or if \a handle is not valid.
+   */
+  StateHandle parentOf(StateHandle handle) const {
+    if (!hasState(handle) || mNodes[handle.index].parent == kNoState) {
+      return {};
+    }
+
+    return {mNodes[handle.index].parent, 0};
+  }
+
+  /**
+   * Checks if the HFSM has a state with a given \a id.
+   * @param id The identification of a state.
+   * @return True if the HFSM has a state with \a id.
+   */
+  bool hasState(const TId& id) const {
+    return mIndex.find(id) != nullptr;
+  }
+
+  /**
+   * Checks if \a handle refers to a state in the HFSM.
+   * @param handle The handle of a state.
+   * @return True if \a handle was returned by this machine.
+   */
+  bool hasState(StateHandle handle) const {
+    return handle.index < mNodes.size() && handle.generation == 0;
+  }
+
+  /**
+   * Resolve the handle of the state with the associated \a id.
+   * @param id The identification of a state.
+   * @return Handle of the state, unset if there is no state with \a id.
+   */
+  StateHandle stateHandle(const TId& id) const {
+    const auto* found = mIndex.find(id);
+    return (found != nullptr) ? StateHandle{*found, 0} : StateHandle{};
+  }
+
+  /**
+   * Get the state referred by \a handle.
+   * @param handle The handle of a state.
+   * @return The state referred by \a handle.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  const TState* getState(StateHandle handle) const {
+    return hasState(handle) ? mNodes[handle.index].state.get() : nullptr;
+  }
+
+  /**
+   * Get the state with the associated \a id.
+   * @param id The identification of a state.
+   * @return A state with the given \a id.
+   * @warning Will return nullptr if there is no state with \a id.
+   */
+  const TState* getState(const TId& id) const {
+    return getState(stateHandle(id));
+  }
+
+  /**
+   * Number of states in the HFSM.
+   * @return The number of states in the HFSM.
+   */
+  std::size_t size() const {
+    return mNodes.size();
+  }
+
+ private:
+  static constexpr std::uint32_t kNoState = StateHandle::kInvalidIndex;
+  static constexpr InstrumentedModule kModule = InstrumentedModule::HFSM;
+
+  template<typename T>
+  using Vector = aikit::detail::ModuleVector<T, kModule>;
+
+  template<typename T>
+  using Ptr = aikit::detail::ModulePtr<T, kModule>;
+
+  struct Node {
+    Ptr<const TId> id; ///< Id of the state, allocated apart so pointers to it stay valid.
+    Ptr<TState> state;
+    std::uint32_t parent = kNoState;
+    std::uint32_t initialChild = kNoState; ///< Child entered when the state is targeted, kNoState for leaves.
+    std::uint32_t depth = 0; ///< Number of ancestors.
+    std::uint32_t chainOffset = 0; ///< Offset of the active chain of the state on mChains.
+    std::uint32_t leafRow = kNoState; ///< Row of the state on mPaths, kNoState if it is not a leaf.
+  };
+
+  /// Range of mPathStates with the states exited followed by the states entered by a transition.
+  struct Path {
+    std::uint32_t offset = 0;
+    std::uint32_t exitCount = 0;
+    std::uint32_t enterCount = 0;
+  };
+
+  std::uint32_t initialLeafOf(std::uint32_t index) const {
+    while (mNodes[index].initialChild != kNoState) {
+      index = mNodes[index].initialChild;
+    }
+    return index;
+  }
+
+  void buildPath(std::uint32_t source, std::uint32_t target) {
+    const auto& sourceNode = mNodes[source];
+    const auto& targetNode = mNodes[target];
+    const std::uint32_t* sourceChain = &mChains[sourceNode.chainOffset];
+    const std::uint32_t* targetChain = &mChains[targetNode.chainOffset];
+
+    // Depth of the first state that is not a common ancestor
+    std::uint32_t divergence = 0;
+    while (divergence <= sourceNode.depth && divergence <= targetNode.depth &&
+           sourceChain[divergence] == targetChain[divergence]) {
+      ++divergence;
+    }
+    // External transition, the target itself is exited and entered again when it is active
+    if (divergence > targetNode.depth) {
+      divergence = targetNode.depth;
+    }
+
+    auto& path = mPaths[std::size_t{sourceNode.leafRow} * mNodes.size() + target];
+    path.offset = static_cast<std::uint32_t>(mPathStates.size());
+
+    for (std::uint32_t depth = sourceNode.depth + 1; depth > divergence; --depth) {
+      mPathStates.emplace_back(sourceChain[depth - 1]);
+    }
+    path.exitCount = static_cast<std::uint32_t>(mPathStates.size()) - path.offset;
+
+    for (std::uint32_t depth = divergence; depth <= targetNode.depth; ++depth) {
+      mPathStates.emplace_back(targetChain[depth]);
+    }
+    for (auto child = targetNode.initialChild; child != kNoState; child = mNodes[child].initialChild) {
+      mPathStates.emplace_back(child);
+    }
+    path.enterCount = static_cast<std::uint32_t>(mPathStates.size()) - path.offset - path.exitCount;
+  }
+
+  void ensureBuilt() {
+    if (!mBuilt) {
+      build();
+    }
+  }
+
+  void transitionToIndex(std::uint32_t target) {
+    ensureBuilt();
+
+    if (!hasCurrentState()) {
+      const auto& targetNode = mNodes[target];
+      for (std::uint32_t depth = 0; depth <= targetNode.depth; ++depth) {
+        mNodes[mChains[targetNode.chainOffset + depth]].state->onEnter();
+      }
+      for (auto child = targetNode.initialChild; child != kNoState; child = mNodes[child].initialChild) {
+        mNodes[child].state->onEnter();
+      }
+      mCurrentState = initialLeafOf(target);
+      return;
+    }
+
+    const auto& path = mPaths[std::size_t{mNodes[mCurrentState].leafRow} * mNodes.size() + target];
+    const std::uint32_t* states = mPathStates.data() + path.offset;
+
+    for (std::uint32_t i = 0; i < path.exitCount; ++i) {
+      mNodes[states[i]].state->onExit();
+    }
+
+    mPreviousState = mCurrentState;
+    states += path.exitCount;
+    for (std::uint32_t i = 0; i < path.enterCount; ++i) {
+      mNodes[states[i]].state->onEnter();
+    }
+    mCurrentState = states[path.enterCount - 1];
+  }
+
+  void transitionOrDefer(std::uint32_t target) {
+    if (mUpdating) {
+      mPendingTransitions.emplace_back(target);
+    } else {
+      transitionToIndex(target);
+    }
+  }
+
+  Vector<Node> mNodes; ///< States of the HFSM, indexed by handles.
+  /// Mapping of ids to states.
+  typename TStorage::template Index<TId> mIndex{aikit::detail::moduleResource(kModule)};
+  Vector<std::uint32_t> mChains; ///< Active chain of every state, from the top level down.
+  Vector<Path> mPaths; ///< Path of every transition, indexed by [leaf row * state count + target].
+  Vector<std::uint32_t> mPathStates; ///< States exited and entered by all paths.
+  Vector<std::uint32_t> mPendingTransitions; ///< Transitions made while updating, in order.
+  std::uint32_t mCurrentState = kNoState; ///< Current leaf.
+  std::uint32_t mPreviousState = kNoState; ///< Leaf current before the last transition.
+  bool mBuilt = false;
+  bool mUpdating = false; ///< True while the active states are being updated.
+};
+
+}
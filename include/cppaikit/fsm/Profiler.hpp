@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "StateHandle.hpp"
+
+namespace aikit::fsm {
+
+/**
+ * Profiling policy that profiles nothing, the default of fsm::FSM.
+ * Every hook is empty and the policy has no members, so it takes no space on the machine and no time on the calls.
+ * @note A profiling policy is a default constructible class with the hooks below. States are given by the index of
+ * their handle, StateHandle::kInvalidIndex for none.
+ * @sa fsm::Profiler
+ */
+struct NoProfiler {
+  /**
+   * Called when the current state of the machine changes, before fsm::State::onExit() of \a from.
+   * @param from State that was current, StateHandle::kInvalidIndex if there was none.
+   * @param to State that becomes current, StateHandle::kInvalidIndex if the machine is left without one.
+   */
+  void onTransition(std::uint32_t /*from*/, std::uint32_t /*to*/) {}
+
+  /**
+   * Called right before fsm::State::update() of the current state.
+   */
+  void beginUpdate(std::uint32_t /*state*/) {}
+
+  /**
+   * Called right after fsm::State::update() of the current state.
+   * @note Under fsm::FSMScheduler the update hooks run on the threads of the pool, many machines at a time.
+   */
+  void endUpdate(std::uint32_t /*state*/) {}
+
+  /**
+   * Called by fsm::FSM::commitTransitions(), on the thread committing, before any transition is committed.
+   * Under fsm::FSMScheduler it runs serially after the parallel updates, the place to publish what the update hooks
+   * gathered.
+   */
+  void commitUpdates() {}
+};
+
+/**
+ * Counters of fsm::Profiler, aggregated across all machines profiled into it.
+ * States are identified by the index of their handle, so machines built the same way (same states added in the same
+ * order) aggregate state by state.
+ * @note Not thread safe. fsm::Profiler only records into it from the transition and commit hooks, which run on the
+ * thread committing transitions, so machines updated in parallel by fsm::FSMScheduler can share it. Machines committed
+ * on different threads need their own stats, merge() them afterwards.
+ */
+class ProfileStats {
+ public:
+  /// Buckets of the dwell time histograms, bucket i counts dwell times in [2^i, 2^(i+1)) nanoseconds.
+  static constexpr std::size_t kDwellBuckets = 48;
+
+  /**
+   * Counters of a state.
+   */
+  struct StateStats {
+    std::uint64_t enterCount = 0; ///< Times the state became current.
+    std::uint64_t exitCount = 0; ///< Times the state stopped being current.
+    std::uint64_t updateCount = 0; ///< Calls to fsm::State::update().
+    std::uint64_t updateNanoseconds = 0; ///< Time spent in fsm::State::update().
+    std::uint64_t dwellNanoseconds = 0; ///< Time spent as current state, counted on exit.
+    std::array<std::uint64_t, kDwellBuckets> dwellHistogram{}; ///< Exits by time spent as current state.
+  };
+
+  /**
+   * The counters of a state.
+   * @param state Index of the handle of the state.
+   * @return The counters, all zero if the state was never profiled.
+   */
+  const StateStats& state(std::uint32_t state) const {
+    static const StateStats empty;
+    return (state < mStates.size()) ? mStates[state] : empty;
+  }
+
+  /**
+   * Number of states with counters, one past the highest index profiled.
+   */
+  std::size_t stateCount() const {
+    return mStates.size();
+  }
+
+  /**
+   * Number of transitions between two states.
+   * @param from Index of the handle of the state left.
+   * @param to Index of the handle of the state entered.
+   */
+  std::uint64_t transitionCount(std::uint32_t from, std::uint32_t to) const {
+    const auto found = mTransitions.find(transitionKey(from, to));
+    return (found != mTransitions.end()) ? found->second : 0;
+  }
+
+  /**
+   * Add the counters of \a other, e.g. of machines profiled on another thread.
+   */
+  void merge(const ProfileStats& other) {
+    for (std::uint32_t index = 0; index < other.mStates.size(); ++index) {
+      StateStats& stats = at(index);
+      const StateStats& added = other.mStates[index];
+      stats.enterCount += added.enterCount;
+      stats.exitCount += added.exitCount;
+      stats.updateCount += added.updateCount;
+      stats.updateNanoseconds += added.updateNanoseconds;
+      stats.dwellNanoseconds += added.dwellNanoseconds;
+      for (std::size_t bucket = 0; bucket < kDwellBuckets; ++bucket) {
+        stats.dwellHistogram[bucket] += added.dwellHistogram[bucket];
+      }
+    }
+
+    for (const auto& transition : other.mTransitions) {
+      mTransitions[transition.first] += transition.second;
+    }
+  }
+
+  /**
+   * Reset all counters.
+   */
+  void clear() {
+    mStates.clear();
+    mTransitions.clear();
+  }
+
+  /**
+   * Write a human readable report: the counters of every state, most expensive updates first, then the transitions.
+   * @param output Stream receiving the report.
+   * @param stateName Name of a state by the index of its handle, the index itself if empty.
+   */
+  void writeReport(std::ostream& output, const std::function<std::string(std::uint32_t)>& stateName = {}) const {
+    const auto name = [&](std::uint32_t state) { return stateName ? stateName(state) : std::to_string(state); };
+
+    std::vector<std::uint32_t> order;
+    for (std::uint32_t index = 0; index < mStates.size(); ++index) {
+      if (mStates[index].enterCount > 0 || mStates[index].updateCount > 0) {
+        order.push_back(index);
+      }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+      return mStates[lhs].updateNanoseconds > mStates[rhs].updateNanoseconds;
+    });
+
+    output << std::left << std::setw(24) << "state" << std::right << std::setw(10) << "enters" << std::setw(10)
+           << "exits" << std::setw(12) << "updates" << std::setw(14) << "update ms" << std::setw(12) << "ns/update"
+           << std::setw(14) << "dwell ms/exit" << '\n';
+    for (const auto index : order) {
+      const StateStats& stats = mStates[index];
+      output << std::left << std::setw(24) << name(index) << std::right << std::setw(10) << stats.enterCount
+             << std::setw(10) << stats.exitCount << std::setw(12) << stats.updateCount << std::fixed
+             << std::setprecision(3) << std::setw(14) << static_cast<double>(stats.updateNanoseconds) * 1e-6
+             << std::setprecision(1) << std::setw(12) << average(stats.updateNanoseconds, stats.updateCount)
+             << std::setprecision(3) << std::setw(14) << average(stats.dwellNanoseconds, stats.exitCount) * 1e-6
+             << '\n';
+    }
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> transitions(mTransitions.begin(), mTransitions.end());
+    std::sort(transitions.begin(), transitions.end());
+    output << "transitions\n";
+    for (const auto& transition : transitions) {
+      output << "  " << name(static_cast<std::uint32_t>(transition.first >> 32)) << " -> "
+             << name(static_cast<std::uint32_t>(transition.first)) << ": " << transition.second << '\n';
+    }
+  }
+
+  /**
+   * Count the entry of a state.
+   */
+  void recordEnter(std::uint32_t state) {
+    ++at(state).enterCount;
+  }
+
+  /**
+   * Count the exit of a state.
+   * @param state Index of the handle of the state.
+   * @param dwellNanoseconds Time the state was current.
+   */
+  void recordExit(std::uint32_t state, std::uint64_t dwellNanoseconds) {
+    StateStats& stats = at(state);
+    ++stats.exitCount;
+    stats.dwellNanoseconds += dwellNanoseconds;
+    ++stats.dwellHistogram[dwellBucket(dwellNanoseconds)];
+  }
+
+  /**
+   * Count an update of a state.
+   * @param state Index of the handle of the state.
+   * @param nanoseconds Time spent on the update.
+   */
+  void recordUpdate(std::uint32_t state, std::uint64_t nanoseconds) {
+    recordUpdates(state, 1, nanoseconds);
+  }
+
+  /**
+   * Count many updates of a state at once.
+   * @param state Index of the handle of the state.
+   * @param count Number of updates.
+   * @param nanoseconds Time spent on all of them.
+   */
+  void recordUpdates(std::uint32_t state, std::uint64_t count, std::uint64_t nanoseconds) {
+    StateStats& stats = at(state);
+    stats.updateCount += count;
+    stats.updateNanoseconds += nanoseconds;
+  }
+
+  /**
+   * Count a transition between two states.
+   */
+  void recordTransition(std::uint32_t from, std::uint32_t to) {
+    ++mTransitions[transitionKey(from, to)];
+  }
+
+ private:
+  StateStats& at(std::uint32_t state) {
+    if (state >= mStates.size()) {
+      mStates.resize(state + std::size_t{1});
+    }
+    return mStates[state];
+  }
+
+  static std::size_t dwellBucket(std::uint64_t nanoseconds) {
+    std::size_t bucket = 0;
+    while (nanoseconds > 1 && bucket + 1 < kDwellBuckets) {
+      nanoseconds >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  static std::uint64_t transitionKey(std::uint32_t from, std::uint32_t to) {
+    return (std::uint64_t{from} << 32) | to;
+  }
+
+  static double average(std::uint64_t total, std::uint64_t count) {
+    return (count > 0) ? static_cast<double>(total) / static_cast<double>(count) : 0.0;
+  }
+
+  std::vector<StateStats> mStates; ///< Counters by index of state handle.
+  std::unordered_map<std::uint64_t, std::uint64_t> mTransitions; ///< Counts by (from << 32 | to).
+};
+
+/**
+ * Profiling policy that times updates and dwell times with std::chrono::steady_clock and counts transitions.
+ * Each machine has its own policy, remembering when its current state was entered, and records into the
+ * fsm::ProfileStats attached to it, which can be shared by many machines. Update times are kept on the policy until
+ * fsm::FSM::commitTransitions() (called by fsm::FSM::update()), so states can be updated in parallel.
+ * @code
+ * aikit::fsm::ProfileStats stats;
+ * aikit::fsm::FSM<std::string, aikit::fsm::State<>, aikit::fsm::storage::Map, aikit::fsm::Profiler> fsm;
+ * fsm.profiler().attach(&stats);
+ * @endcode
+ * @note Nothing is recorded until attach() is called.
+ * @sa fsm::NoProfiler
+ */
+class Profiler {
+ public:
+  /**
+   * Record into \a stats from now on.
+   * @param stats Counters to record into, nullptr to stop recording. Must outlive the profiler or be detached.
+   */
+  void attach(ProfileStats* stats) {
+    commitUpdates();
+    mStats = stats;
+  }
+
+  /**
+   * The counters being recorded into, nullptr if none.
+   */
+  ProfileStats* stats() const {
+    return mStats;
+  }
+
+  /// @copydoc NoProfiler::onTransition()
+  void onTransition(std::uint32_t from, std::uint32_t to) {
+    if (mStats == nullptr) {
+      return;
+    }
+
+    commitUpdates();
+    const std::uint64_t time = now();
+    if (from != StateHandle::kInvalidIndex) {
+      mStats->recordExit(from, (mEnteredAt > 0) ? time - mEnteredAt : 0);
+      if (to != StateHandle::kInvalidIndex) {
+        mStats->recordTransition(from, to);
+      }
+    }
+    if (to != StateHandle::kInvalidIndex) {
+      mStats->recordEnter(to);
+    }
+    mEnteredAt = time;
+  }
+
+  /// @copydoc NoProfiler::beginUpdate()
+  void beginUpdate(std::uint32_t /*state*/) {
+    mUpdateStartedAt = (mStats != nullptr) ? now() : 0;
+  }
+
+  /// @copydoc NoProfiler::endUpdate()
+  void endUpdate(std::uint32_t state) {
+    if (mStats != nullptr && mUpdateStartedAt > 0) {
+      mPendingState = state;
+      ++mPendingUpdates;
+      mPendingNanoseconds += now() - mUpdateStartedAt;
+    }
+  }
+
+  /// @copydoc NoProfiler::commitUpdates()
+  void commitUpdates() {
+    if (mStats != nullptr && mPendingUpdates > 0) {
+      mStats->recordUpdates(mPendingState, mPendingUpdates, mPendingNanoseconds);
+    }
+    mPendingUpdates = 0;
+    mPendingNanoseconds = 0;
+  }
+
+ private:
+  static std::uint64_t now() {
+    const auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+  }
+
+  ProfileStats* mStats = nullptr;
+  std::uint64_t mEnteredAt = 0; ///< Time the current state was entered, 0 if unknown.
+  std::uint64_t mUpdateStartedAt = 0; ///< Time the update in progress started, 0 if not recording.
+  std::uint32_t mPendingState = StateHandle::kInvalidIndex; ///< State of the updates not committed yet.
+  std::uint64_t mPendingUpdates = 0; ///< Updates not committed yet, all of the current state.
+  std::uint64_t mPendingNanoseconds = 0; ///< Time spent on the updates not committed yet.
+};
+
+namespace detail {
+
+/**
+ * Holder of the profiling policy of fsm::FSM, a base so empty policies take no space.
+ */
+template<typename TProfiler>
+class ProfilerHolder : private TProfiler {
+ protected:
+  TProfiler& heldProfiler() { return *this; }
+  const TProfiler& heldProfiler() const { return *this; }
+};
+
+}
+
+}
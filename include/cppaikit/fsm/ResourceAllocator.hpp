@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace aikit::fsm::detail {
+
+/**
+ * Allocator taking its memory from a std::pmr::memory_resource, like std::pmr::polymorphic_allocator, except that it
+ * moves along with the memory of its container.
+ * Move assigning a container of std::pmr::polymorphic_allocator keeps the resource of the target and moves every
+ * element to it. With this allocator the target takes the memory of the source together with its resource, so a
+ * machine moved into another one keeps allocating from the resource it was created with.
+ * @note Unlike std::pmr::polymorphic_allocator, the resource is not given to the elements of the container.
+ */
+template<typename T>
+class ResourceAllocator {
+ public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  ResourceAllocator() noexcept : mResource(std::pmr::get_default_resource()) {}
+
+  /**
+   * Create an allocator taking its memory from \a resource, which must outlive every container using it.
+   */
+  ResourceAllocator(std::pmr::memory_resource* resource) noexcept : mResource(resource) {}
+
+  template<typename U>
+  ResourceAllocator(const ResourceAllocator<U>& other) noexcept : mResource(other.resource()) {}
+
+  T* allocate(std::size_t count) {
+    return static_cast<T*>(mResource->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* memory, std::size_t count) {
+    mResource->deallocate(memory, count * sizeof(T), alignof(T));
+  }
+
+  /**
+   * The resource the memory is taken from.
+   */
+  std::pmr::memory_resource* resource() const {
+    return mResource;
+  }
+
+  template<typename U>
+  bool operator==(const ResourceAllocator<U>& other) const {
+    return mResource == other.resource() || mResource->is_equal(*other.resource());
+  }
+
+  template<typename U>
+  bool operator!=(const ResourceAllocator<U>& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  std::pmr::memory_resource* mResource;
+};
+
+/// Vector taking its memory from a resource moved along with it.
+template<typename T>
+using ResourceVector = std::vector<T, ResourceAllocator<T>>;
+
+/// Map taking its memory from a resource moved along with it.
+template<typename TKey, typename TValue, typename TCompare = std::less<TKey>>
+using ResourceMap = std::map<TKey, TValue, TCompare, ResourceAllocator<std::pair<const TKey, TValue>>>;
+
+}
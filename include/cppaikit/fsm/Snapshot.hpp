@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Span.hpp"
+
+namespace aikit::fsm {
+
+/**
+ * Serialization trait for the payloads of states on fsm::FSM snapshots.
+ * By default states have no payload and snapshots only hold the slots of the current and previous states. Specialize
+ * it for the base state type of a machine (its \a TState) to also save the data of every state, e.g. cooldowns or
+ * counters:
+ * @code
+ * template<>
+ * struct aikit::fsm::StateSerializer<GuardState> {
+ *   static constexpr bool kEnabled = true;
+ *   static std::size_t size(const GuardState& state) { return state.payloadSize(); }  // virtual on GuardState
+ *   static void write(const GuardState& state, unsigned char* output) { state.save(output); }
+ *   static bool read(GuardState& state, const unsigned char* input, std::size_t size) {
+ *     return state.load(input, size);
+ *   }
+ * };
+ * @endcode
+ * @tparam TState Base type for the states of the machine.
+ * @note write() receives exactly size() bytes, read() the bytes written by write().
+ * @sa fsm::FSM::writeSnapshot()
+ */
+template<typename TState>
+struct StateSerializer {
+  static constexpr bool kEnabled = false;
+
+  static std::size_t size(const TState& /*state*/) { return 0; }
+  static void write(const TState& /*state*/, unsigned char* /*output*/) {}
+  static bool read(TState& /*state*/, const unsigned char* /*input*/, std::size_t /*size*/) { return true; }
+};
+
+namespace detail {
+
+inline void writeUint32(unsigned char* output, std::uint32_t value) {
+  output[0] = static_cast<unsigned char>(value);
+  output[1] = static_cast<unsigned char>(value >> 8);
+  output[2] = static_cast<unsigned char>(value >> 16);
+  output[3] = static_cast<unsigned char>(value >> 24);
+}
+
+inline std::uint32_t readUint32(const unsigned char* input) {
+  return std::uint32_t{input[0]} | (std::uint32_t{input[1]} << 8) | (std::uint32_t{input[2]} << 16) |
+         (std::uint32_t{input[3]} << 24);
+}
+
+/// "AIKS", the first bytes of the buffers written by saveSnapshots().
+constexpr std::uint32_t kSnapshotMagic = 0x534b4941;
+constexpr std::uint32_t kSnapshotVersion = 2;
+constexpr std::size_t kSnapshotsHeaderSize = 12;
+
+}
+
+/**
+ * Write the snapshots of many machines to a single contiguous buffer.
+ * The buffer starts with a header (magic, format version, machine count) followed by the size and the snapshot of
+ * each machine, as written by fsm::FSM::writeSnapshot(). All integers are little endian, so buffers can be moved
+ * between machines of any byte order.
+ * @code
+ * std::vector<unsigned char> buffer;
+ * aikit::fsm::saveSnapshots<aikit::fsm::FSM<>>(machines, buffer);
+ * @endcode
+ * @param machines Machines being saved.
+ * @param buffer Receives the snapshots, resized to fit them exactly.
+ * @return Bytes written.
+ * @sa loadSnapshots()
+ */
+template<typename TMachine>
+std::size_t saveSnapshots(Span<const TMachine> machines, std::vector<unsigned char>& buffer) {
+  std::size_t size = detail::kSnapshotsHeaderSize;
+  for (const auto& machine : machines) {
+    size += sizeof(std::uint32_t) + machine.snapshotSize();
+  }
+  buffer.resize(size);
+
+  unsigned char* output = buffer.data();
+  detail::writeUint32(output, detail::kSnapshotMagic);
+  detail::writeUint32(output + 4, detail::kSnapshotVersion);
+  detail::writeUint32(output + 8, static_cast<std::uint32_t>(machines.size()));
+  output += detail::kSnapshotsHeaderSize;
+
+  for (const auto& machine : machines) {
+    const std::size_t written = machine.writeSnapshot(output + sizeof(std::uint32_t));
+    detail::writeUint32(output, static_cast<std::uint32_t>(written));
+    output += sizeof(std::uint32_t) + written;
+  }
+
+  return size;
+}
+
+/**
+ * Restore many machines from a buffer written by saveSnapshots().
+ * The machines must have been rebuilt with the same states on the same slots as when saved, see
+ * fsm::FSM::readSnapshot().
+ * @param machines Machines being restored, in the order they were saved.
+ * @param input The buffer.
+ * @param size Bytes on the buffer.
+ * @return Number of machines restored. Machines are restored in order until one fails, 0 if the buffer was not written
+ * by saveSnapshots() or holds a different number of machines.
+ */
+template<typename TMachine>
+std::size_t loadSnapshots(Span<TMachine> machines, const unsigned char* input, std::size_t size) {
+  if (size < detail::kSnapshotsHeaderSize || detail::readUint32(input) != detail::kSnapshotMagic ||
+      detail::readUint32(input + 4) != detail::kSnapshotVersion || detail::readUint32(input + 8) != machines.size()) {
+    return 0;
+  }
+
+  std::size_t position = detail::kSnapshotsHeaderSize;
+  for (std::size_t i = 0; i < machines.size(); ++i) {
+    if (size - position < sizeof(std::uint32_t)) {
+      return i;
+    }
+
+    const std::size_t snapshotSize = detail::readUint32(input + position);
+    position += sizeof(std::uint32_t);
+    if (size - position < snapshotSize || machines[i].readSnapshot(input + position, snapshotSize) != snapshotSize) {
+      return i;
+    }
+    position += snapshotSize;
+  }
+
+  return machines.size();
+}
+
+}
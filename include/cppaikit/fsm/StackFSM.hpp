@@ -0,0 +1,398 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "../Span.hpp"
+#include "FSM.hpp"
+
+namespace aikit::fsm {
+
+/**
+ * Implementation for a Stacked Finite State Machine (pushdown automaton).
+ * States are pushed on top of each other, only the state on top of the stack is current and updated. Popping the top
+ * state resumes the state below it, which makes interruptions (e.g. stun, cutscene, reload) independent of what was
+ * interrupted.
+ * The stack is a fixed capacity array stored inline in the machine, so push(), pop() and replace() never allocate.
+ * @tparam TId Type for the id of a state. Defaults to std::string.
+ * @tparam TState Base type for the states managed by the machine. Defaults to fsm::State<int>.
+ * @tparam Capacity Maximum number of states on the stack. Defaults to 8.
+ * @tparam TStorage Storage policy used to index states by id. Defaults to fsm::storage::Map.
+ * @note A state covered by a push gets fsm::State::onExit() and gets fsm::State::onEnter() again when it is resumed.
+ * @note The same state can be on the stack more than once.
+ * @sa fsm::FSM
+ */
+template<typename TId = std::string, typename TState = State<int>, std::size_t Capacity = 8,
+         typename TStorage = storage::Map>
+class StackFSM {
+  static_assert(Capacity > 0, "StackFSM needs room for at least one state");
+
+ public:
+  typedef TId Id_type;
+  typedef typename TState::UpdateData_type UpdateData_type;
+
+  static constexpr std::size_t kCapacity = Capacity;
+
+  /**
+   * Create a StackFSM allocating states from the default memory resource.
+   */
+  StackFSM() = default;
+
+  /**
+   * Create a StackFSM allocating states from \a resource.
+   * @param resource Memory resource used for all allocations of the machine, must outlive the machine.
+   */
+  explicit StackFSM(std::pmr::memory_resource* resource) : mStates(resource) {}
+
+  /**
+   * Adds a new state to the StackFSM.
+   * @param id Identification of the state being added, this is used to reference the state in all other methods.
+   * @param state The state being added. It must inherit from the class fsm::State.
+   * @return Handle to the added state, valid until the state is removed.
+   * @note If any state with equivalent \a id already exists, does nothing and returns an unset handle.
+   * @sa fsm::FSM::addState()
+   */
+  template<typename TNewState>
+  StateHandle addState(TId id, TNewState&& state) {
+    return mStates.addState(std::move(id), std::forward<TNewState>(state));
+  }
+
+  /**
+   * Remove a state from the StackFSM.
+   * @param handle Handle of the state being removed.
+   * @return True if the state was found and removed.
+   * @attention States on the stack can not be removed, the call is ignored.
+   */
+  bool removeState(StateHandle handle) {
+    return !isOnStack(handle) && mStates.removeState(handle);
+  }
+
+  /**
+   * Remove a state from the StackFSM.
+   * @param id Identification of the state being removed.
+   * @return True if the state was found and removed.
+   * @sa removeState(StateHandle)
+   */
+  bool removeState(const TId& id) {
+    return removeState(mStates.stateHandle(id));
+  }
+
+  /**
+   * Push a state on top of the stack, making it the current state.
+   * fsm::State::onExit() is called for the current state (if any) and fsm::State::onEnter() for the pushed state.
+   * @param handle Handle of the state being pushed.
+   * @return True if \a handle refers to a state on the StackFSM and the stack was not full.
+   * @note When called from inside fsm::State::update(), the push is deferred until the state finishes updating and
+   * the return only tells if the push could be queued.
+   */
+  bool push(StateHandle handle) {
+    if (!mStates.hasState(handle)) {
+      return false;
+    }
+
+    return mUpdating ? defer(Operation::Push, handle) : pushNow(handle);
+  }
+
+  /**
+   * Push a state on top of the stack, making it the current state.
+   * @param id Identification of the state being pushed.
+   * @return True if \a id was found on the StackFSM and the stack was not full.
+   * @sa push(StateHandle)
+   */
+  bool push(const TId& id) {
+    return push(mStates.stateHandle(id));
+  }
+
+  /**
+   * Pop the state on top of the stack, resuming the state below it (if any).
+   * fsm::State::onExit() is called for the popped state and fsm::State::onEnter() for the resumed state.
+   * @return True if the stack was not empty.
+   * @note When called from inside fsm::State::update(), the pop is deferred until the state finishes updating.
+   */
+  bool pop() {
+    if (mUpdating) {
+      return defer(Operation::Pop, {});
+    }
+
+    if (mSize == 0) {
+      return false;
+    }
+
+    mStates.getState(mStack[mSize - 1])->onExit();
+    --mSize;
+    if (mSize > 0) {
+      mStates.getState(mStack[mSize - 1])->onEnter();
+    }
+
+    return true;
+  }
+
+  /**
+   * Replace the state on top of the stack, keeping the states below it.
+   * fsm::State::onExit() is called for the replaced state and fsm::State::onEnter() for the new state.
+   * @param handle Handle of the new state.
+   * @return True if \a handle refers to a state on the StackFSM.
+   * @note If the stack is empty, \a handle is pushed.
+   * @note When called from inside fsm::State::update(), the replace is deferred until the state finishes updating.
+   */
+  bool replace(StateHandle handle) {
+    if (!mStates.hasState(handle)) {
+      return false;
+    }
+
+    if (mUpdating) {
+      return defer(Operation::Replace, handle);
+    }
+
+    if (mSize == 0) {
+      return pushNow(handle);
+    }
+
+    mStates.getState(mStack[mSize - 1])->onExit();
+    mStack[mSize - 1] = handle;
+    mStates.getState(handle)->onEnter();
+    return true;
+  }
+
+  /**
+   * Replace the state on top of the stack.
+   * @param id Identification of the new state.
+   * @return True if \a id was found on the StackFSM.
+   * @sa replace(StateHandle)
+   */
+  bool replace(const TId& id) {
+    return replace(mStates.stateHandle(id));
+  }
+
+  /**
+   * Remove all states from the stack.
+   * fsm::State::onExit() is called only for the current state, the states below it already exited when covered.
+   * @note When called from inside fsm::State::update(), the clear is deferred until the state finishes updating.
+   */
+  void clear() {
+    if (mUpdating) {
+      defer(Operation::Clear, {});
+      return;
+    }
+
+    if (mSize > 0) {
+      mStates.getState(mStack[mSize - 1])->onExit();
+      mSize = 0;
+    }
+  }
+
+  /**
+   * Update the current state, the one on top of the stack.
+   * Stack operations made during the update are applied, in order, after the state finishes updating.
+   * @param updateData The data that will be passed during the call fsm::State::update() on the current state.
+   * @note If the stack is empty, the call is ignored.
+   * @note If the state throws, the operations made during the update are dropped.
+   */
+  void update(UpdateData_type updateData) {
+    if (mSize == 0) {
+      return;
+    }
+
+    try {
+      const detail::UpdatingScope updating(mUpdating);
+      mStates.getState(mStack[mSize - 1])->update(updateData);
+    } catch (...) {
+      mPendingCount = 0;
+      throw;
+    }
+
+    for (std::size_t i = 0; i < mPendingCount; ++i) {
+      const auto& pending = mPending[i];
+      switch (pending.operation) {
+        case Operation::Push: push(pending.handle); break;
+        case Operation::Pop: pop(); break;
+        case Operation::Replace: replace(pending.handle); break;
+        case Operation::Clear: clear(); break;
+      }
+    }
+    mPendingCount = 0;
+  }
+
+  /**
+   * Check if the StackFSM has a current state, that is, if the stack is not empty.
+   * @return True if there is a current state.
+   */
+  bool hasCurrentState() const {
+    return mSize > 0;
+  }
+
+  /**
+   * The handle of the current state of the StackFSM.
+   * @return Handle of the state on top of the stack, unset if the stack is empty.
+   */
+  StateHandle currentStateHandle() const {
+    return (mSize > 0) ? mStack[mSize - 1] : StateHandle{};
+  }
+
+  /**
+   * The identification of the current state of the StackFSM.
+   * @return Id of the state on top of the stack.
+   * @attention Can be nullptr if the stack is empty.
+   */
+  const TId* currentStateId() const {
+    return mStates.stateId(currentStateHandle());
+  }
+
+  /**
+   * The current state of the StackFSM.
+   * @return State on top of the stack.
+   * @attention Can be nullptr if the stack is empty.
+   */
+  TState* currentState() {
+    return mStates.getState(currentStateHandle());
+  }
+
+  /**
+   * The current state of the StackFSM.
+   * @return State on top of the stack.
+   * @attention Can be nullptr if the stack is empty.
+   */
+  const TState* currentState() const {
+    return mStates.getState(currentStateHandle());
+  }
+
+  /**
+   * The states on the stack.
+   * @return Handles of the states on the stack, from the bottom to the top.
+   */
+  Span<const StateHandle> stack() const {
+    return {mStack.data(), mSize};
+  }
+
+  /**
+   * Number of states on the stack.
+   */
+  std::size_t stackSize() const {
+    return mSize;
+  }
+
+  /**
+   * Checks if the StackFSM has a state with a given \a id.
+   * @param id The identification of a state.
+   * @return True if the StackFSM has a state with \a id.
+   */
+  bool hasState(const TId& id) const {
+    return mStates.hasState(id);
+  }
+
+  /**
+   * Checks if \a handle refers to a state in the StackFSM.
+   * @param handle The handle of a state.
+   * @return True if the state referred by \a handle was not removed.
+   */
+  bool hasState(StateHandle handle) const {
+    return mStates.hasState(handle);
+  }
+
+  /**
+   * Resolve the handle of the state with the associated \a id.
+   * @param id The identification of a state.
+   * @return Handle of the state, unset if there is no state with \a id.
+   */
+  StateHandle stateHandle(const TId& id) const {
+    return mStates.stateHandle(id);
+  }
+
+  /**
+   * Get the state referred by \a handle.
+   * @param handle The handle of a state.
+   * @return The state referred by \a handle.
+   * @warning Will return nullptr if \a handle is not valid.
+   */
+  const TState* getState(StateHandle handle) const {
+    return mStates.getState(handle);
+  }
+
+  /**
+   * Get the state with the associated \a id.
+   * @param id The identification of a state.
+   * @return A state with the given \a id.
+   * @warning Will return nullptr if there is no state with \a id.
+   */
+  const TState* getState(const TId& id) const {
+    return mStates.getState(id);
+  }
+
+  /**
+   * Number of states in the StackFSM, on the stack or not.
+   * @return The number of states in the StackFSM.
+   */
+  std::size_t size() const {
+    return mStates.size();
+  }
+
+#ifdef CppAIKit_INSTRUMENTATION
+  /**
+   * The allocations of the machine, only available when CppAIKit_INSTRUMENTATION is defined.
+   * @return Counters of the fsm::FSM owning the states, also added to the totals of aikit::InstrumentedModule::FSM.
+   * @sa fsm::FSM::allocationStats()
+   */
+  const AllocationStats& allocationStats() const {
+    return mStates.allocationStats();
+  }
+
+  /**
+   * Reset the counters of allocationStats(), e.g. after warming up the machine.
+   */
+  void resetAllocationStats() {
+    mStates.resetAllocationStats();
+  }
+#endif
+
+ private:
+  enum class Operation : std::uint8_t { Push, Pop, Replace, Clear };
+
+  struct PendingOperation {
+    Operation operation;
+    StateHandle handle;
+  };
+
+  bool pushNow(StateHandle handle) {
+    if (mSize == Capacity) {
+      return false;
+    }
+
+    if (mSize > 0) {
+      mStates.getState(mStack[mSize - 1])->onExit();
+    }
+    mStack[mSize++] = handle;
+    mStates.getState(handle)->onEnter();
+    return true;
+  }
+
+  bool defer(Operation operation, StateHandle handle) {
+    if (mPendingCount == Capacity) {
+      return false;
+    }
+
+    mPending[mPendingCount++] = {operation, handle};
+    return true;
+  }
+
+  bool isOnStack(StateHandle handle) const {
+    for (std::size_t i = 0; i < mSize; ++i) {
+      if (mStack[i] == handle) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  FSM<TId, TState, TStorage> mStates; ///< Owner of the states, its own current state is never set.
+  std::array<StateHandle, Capacity> mStack{}; ///< States on the stack, from the bottom to the top.
+  std::size_t mSize = 0; ///< Number of states on the stack.
+  std::array<PendingOperation, Capacity> mPending{}; ///< Operations made while updating, in order.
+  std::size_t mPendingCount = 0;
+  bool mUpdating = false; ///< True while the current state is being updated.
+};
+
+}
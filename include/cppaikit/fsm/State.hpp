@@ -1,7 +1,22 @@
 #pragma once
 
+#include <cstdint>
+
+#include "../Span.hpp"
+
 namespace aikit::fsm {
 
+/**
+ * A batch of agents on the same state.
+ * @tparam TState Type of the state.
+ * @sa fsm::State::updateBatch()
+ */
+template<typename TState>
+struct StateBatch {
+  Span<TState> states; ///< Copies of the state of all agents, indexed by agent id.
+  Span<const std::uint32_t> agents; ///< Ids of the agents currently on the state, in increasing order.
+};
+
 /**
  * The base class for the state of a Finite State Machine.
  * All state to be used on a FSM should inherit from this class.
@@ -31,6 +46,46 @@ class State {
    * @sa fsm::FSM::update()
    */
   virtual void update(TUpdateData updateData) = 0;
+
+  /**
+   * Update all agents on a state at once.
+   * Called by fsm::FSMPool::updateAll() once per state on every update, with all agents currently on the state. The
+   * default implementation calls update() for each agent, without virtual dispatch.
+   * A state can provide its own batched update (e.g. a SIMD kernel) by declaring a static method with this name taking
+   * a fsm::StateBatch of its own type, which hides this one.
+   * @tparam TDerived Type of the state being updated.
+   * @param batch Copies of the state for all agents and the agents to update.
+   * @param updateData The data to be used during the update.
+   * @note When all agents are on the state, \a batch.agents is the sequence 0, 1, ..., \a batch.states.size() - 1.
+   * @sa fsm::FSMPool::updateAll()
+   */
+  template<typename TDerived>
+  static void updateBatch(StateBatch<TDerived> batch, TUpdateData updateData) {
+    for (const auto agent : batch.agents) {
+      batch.states[agent].TDerived::update(updateData);
+    }
+  }
 };
 
+namespace detail {
+
+/**
+ * Marks a machine as updating its states for the lifetime of the scope, also when an update throws.
+ * The flag is restored to its value before the scope, so nested scopes leave the machine updating.
+ */
+class UpdatingScope {
+ public:
+  explicit UpdatingScope(bool& updating) : mUpdating(updating), mWasUpdating(updating) { mUpdating = true; }
+  ~UpdatingScope() { mUpdating = mWasUpdating; }
+
+  UpdatingScope(const UpdatingScope&) = delete;
+  UpdatingScope& operator=(const UpdatingScope&) = delete;
+
+ private:
+  bool& mUpdating;
+  const bool mWasUpdating; ///< Value of the flag when the scope was entered.
+};
+
+}
+
 }
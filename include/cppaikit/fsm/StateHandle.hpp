@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+namespace aikit::fsm {
+
+/**
+ * Compact reference to a state of a FSM.
+ * A handle is a dense index into the states of a machine plus the generation of the slot it refers to. Once a state is
+ * removed the generation of its slot changes, so handles to removed states are detected even if the slot is reused.
+ * @sa fsm::FSM::addState()
+ * @sa fsm::FSM::stateHandle()
+ */
+struct StateHandle {
+  static constexpr std::uint32_t kInvalidIndex = ~std::uint32_t{0};
+
+  std::uint32_t index = kInvalidIndex; ///< Index of the state slot on the machine.
+  std::uint32_t generation = 0; ///< Generation of the slot when the handle was created.
+
+  /**
+   * Check if the handle was set to a state.
+   * @return True if the handle was returned by a machine.
+   * @attention A set handle can still refer to a removed state, use fsm::FSM::hasState() to validate it.
+   */
+  bool isSet() const { return index != kInvalidIndex; }
+
+  friend bool operator==(const StateHandle& lhs, const StateHandle& rhs) {
+    return lhs.index == rhs.index && lhs.generation == rhs.generation;
+  }
+
+  friend bool operator!=(const StateHandle& lhs, const StateHandle& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+}
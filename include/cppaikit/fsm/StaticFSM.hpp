@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace aikit::fsm {
+
+namespace detail {
+
+template<typename T, typename = void>
+struct HasOnEnter : std::false_type {};
+
+template<typename T>
+struct HasOnEnter<T, std::void_t<decltype(std::declval<T&>().onEnter())>> : std::true_type {};
+
+template<typename T, typename = void>
+struct HasOnExit : std::false_type {};
+
+template<typename T>
+struct HasOnExit<T, std::void_t<decltype(std::declval<T&>().onExit())>> : std::true_type {};
+
+template<typename T, typename... TStates>
+struct IndexOf;
+
+template<typename T, typename... TStates>
+struct IndexOf<T, T, TStates...> : std::integral_constant<std::size_t, 0> {};
+
+template<typename T, typename TOther, typename... TStates>
+struct IndexOf<T, TOther, TStates...> : std::integral_constant<std::size_t, 1 + IndexOf<T, TStates...>::value> {};
+
+template<typename T>
+struct IndexOf<T> : std::integral_constant<std::size_t, 0> {};
+
+template<typename... TStates>
+struct AreUnique : std::true_type {};
+
+template<typename T, typename... TStates>
+struct AreUnique<T, TStates...>
+    : std::bool_constant<(!std::is_same_v<T, TStates> && ...) && AreUnique<TStates...>::value> {};
+
+}
+
+/**
+ * Finite State Machine with a set of states fixed at compile time.
+ * All states are stored inline in the machine, no allocation is ever made. Calls to the states are dispatched with
+ * jump tables of non virtual calls, so the compiler is free to inline them.
+ * States do not need to inherit from fsm::State, but they must have an update() method accepting the arguments
+ * given to StaticFSM::update(). The methods onEnter() and onExit() are optional and are called only when present.
+ * @tparam TStates Types of the states of the machine, each type can appear only once.
+ * @sa fsm::FSM
+ */
+template<typename... TStates>
+class StaticFSM {
+  static_assert(sizeof...(TStates) > 0, "StaticFSM requires at least one state");
+  static_assert(detail::AreUnique<TStates...>::value, "Each state type can appear only once on a StaticFSM");
+
+ public:
+  /// Number of states of the machine.
+  static constexpr std::size_t kStateCount = sizeof...(TStates);
+  /// Index used when there is no state set.
+  static constexpr std::size_t kNoState = kStateCount;
+
+  /**
+   * Checks if \a T is one of the states of the machine.
+   */
+  template<typename T>
+  static constexpr bool contains() {
+    return detail::IndexOf<T, TStates...>::value < kStateCount;
+  }
+
+  /**
+   * Index of the state \a T on the machine.
+   */
+  template<typename T>
+  static constexpr std::size_t indexOf() {
+    static_assert(contains<T>(), "T is not a state of this StaticFSM");
+    return detail::IndexOf<T, TStates...>::value;
+  }
+
+  StaticFSM() = default;
+
+  /**
+   * Create the machine with the given initial values for its states.
+   */
+  explicit StaticFSM(TStates... states) : mStates(std::move(states)...) {}
+
+  /**
+   * Transition to the state \a TTarget.
+   * Follows the same order of operations of fsm::FSM::transitionTo().
+   * @tparam TTarget State that will be transitioned to, checked at compile time to be a state of the machine.
+   */
+  template<typename TTarget>
+  void transitionTo() {
+    transitionToIndex(indexOf<TTarget>());
+  }
+
+  /**
+   * Transition to the machine previous state.
+   * @return True if there was a previous state to transition to.
+   * @note If there is no previous state, the call is ignored.
+   */
+  bool transitionToPreviousState() {
+    const bool hasPrevious = hasPreviousState();
+    if (hasPrevious) {
+      transitionToIndex(mPreviousState);
+    }
+
+    return hasPrevious;
+  }
+
+  /**
+   * Set the current state of the machine without calling onExit() and onEnter().
+   * @tparam TTarget State that will be set as current, checked at compile time to be a state of the machine.
+   * @sa fsm::FSM::setCurrentState()
+   */
+  template<typename TTarget>
+  void setCurrentState() {
+    if (hasCurrentState()) {
+      mPreviousState = mCurrentState;
+    }
+
+    mCurrentState = indexOf<TTarget>();
+  }
+
+  /**
+   * Update the current state, forwarding \a args to its update() method.
+   * @note If there is no current state, the call is ignored.
+   */
+  template<typename... TArgs>
+  void update(TArgs&&... args) {
+    if (hasCurrentState()) {
+      Dispatch::update(mCurrentState, mStates, std::forward<TArgs>(args)...);
+    }
+  }
+
+  /**
+   * Check if the machine has a current state set.
+   */
+  bool hasCurrentState() const {
+    return mCurrentState != kNoState;
+  }
+
+  /**
+   * Check if the current state of the machine is \a T.
+   */
+  template<typename T>
+  bool isCurrentState() const {
+    return mCurrentState == indexOf<T>();
+  }
+
+  /**
+   * Index of the current state, as given by indexOf(), or kNoState.
+   */
+  std::size_t currentStateIndex() const {
+    return mCurrentState;
+  }
+
+  /**
+   * Check if the machine has a state previously set.
+   */
+  bool hasPreviousState() const {
+    return mPreviousState != kNoState;
+  }
+
+  /**
+   * Check if the previous state of the machine is \a T.
+   */
+  template<typename T>
+  bool isPreviousState() const {
+    return mPreviousState == indexOf<T>();
+  }
+
+  /**
+   * Index of the previous state, as given by indexOf(), or kNoState.
+   */
+  std::size_t previousStateIndex() const {
+    return mPreviousState;
+  }
+
+  /**
+   * Get the state \a T of the machine.
+   */
+  template<typename T>
+  T& getState() {
+    return std::get<indexOf<T>()>(mStates);
+  }
+
+  /**
+   * Get the state \a T of the machine.
+   */
+  template<typename T>
+  const T& getState() const {
+    return std::get<indexOf<T>()>(mStates);
+  }
+
+ private:
+  typedef std::tuple<TStates...> States;
+
+  template<typename TSequence>
+  struct Dispatcher;
+
+  template<std::size_t... Is>
+  struct Dispatcher<std::index_sequence<Is...>> {
+    template<std::size_t I>
+    static void enterAt(States& states) {
+      using T = std::tuple_element_t<I, States>;
+      if constexpr (detail::HasOnEnter<T>::value) {
+        std::get<I>(states).T::onEnter();
+      }
+    }
+
+    template<std::size_t I>
+    static void exitAt(States& states) {
+      using T = std::tuple_element_t<I, States>;
+      if constexpr (detail::HasOnExit<T>::value) {
+        std::get<I>(states).T::onExit();
+      }
+    }
+
+    template<std::size_t I, typename... TArgs>
+    static void updateAt(States& states, TArgs&&... args) {
+      using T = std::tuple_element_t<I, States>;
+      std::get<I>(states).T::update(std::forward<TArgs>(args)...);
+    }
+
+    static void enter(std::size_t index, States& states) {
+      static constexpr void (*table[])(States&) = {&enterAt<Is>...};
+      table[index](states);
+    }
+
+    static void exit(std::size_t index, States& states) {
+      static constexpr void (*table[])(States&) = {&exitAt<Is>...};
+      table[index](states);
+    }
+
+    template<typename... TArgs>
+    static void update(std::size_t index, States& states, TArgs&&... args) {
+      static constexpr void (*table[])(States&, TArgs&&...) = {&updateAt<Is, TArgs...>...};
+      table[index](states, std::forward<TArgs>(args)...);
+    }
+  };
+
+  typedef Dispatcher<std::index_sequence_for<TStates...>> Dispatch;
+
+  void transitionToIndex(std::size_t index) {
+    if (hasCurrentState()) {
+      Dispatch::exit(mCurrentState, mStates);
+      mPreviousState = mCurrentState;
+    }
+
+    mCurrentState = index;
+    Dispatch::enter(mCurrentState, mStates);
+  }
+
+  States mStates{};
+  std::size_t mPreviousState = kNoState;
+  std::size_t mCurrentState = kNoState;
+};
+
+}
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "ResourceAllocator.hpp"
+
+namespace aikit::fsm::storage {
+
+/**
+ * Index from state ids to slots backed by a std::map.
+ * Every lookup is a tree walk, kept as the default to preserve the original behaviour of the FSM.
+ * Like every index, it does not copy the keys: it keeps the address of the key given to insert(), which is the id
+ * stored with the state, so ids take no memory on the index.
+ * @tparam TKey Type of the key. Must be comparable with operator<.
+ */
+template<typename TKey>
+class MapIndex {
+ public:
+  MapIndex() = default;
+
+  /**
+   * Create the index allocating from \a resource.
+   */
+  explicit MapIndex(std::pmr::memory_resource* resource) : mMap(resource) {}
+
+  /**
+   * Find the slot associated with \a key.
+   * @param key Key being searched.
+   * @return Pointer to the slot associated with \a key or nullptr if not found.
+   */
+  const std::uint32_t* find(const TKey& key) const {
+    const auto found = mMap.find(key);
+    return (found != mMap.end()) ? &found->second : nullptr;
+  }
+
+  /**
+   * Associate \a key with \a slot.
+   * @param key Key being inserted, referenced by the index: it must not be changed nor destroyed until erased.
+   * @param slot Slot associated with \a key.
+   * @return True if the key was inserted, false if it already exists (nothing is changed).
+   */
+  bool insert(const TKey& key, std::uint32_t slot) {
+    return mMap.try_emplace(&key, slot).second;
+  }
+
+  /**
+   * Remove \a key from the index.
+   * @return True if the key was found and removed.
+   */
+  bool erase(const TKey& key) {
+    const auto found = mMap.find(key);
+    if (found == mMap.end()) {
+      return false;
+    }
+
+    mMap.erase(found);
+    return true;
+  }
+
+  /**
+   * Reserve space for \a count keys. Nodes based containers can not reserve, the call is ignored.
+   */
+  void reserve(std::size_t /*count*/) {}
+
+  std::size_t size() const {
+    return mMap.size();
+  }
+
+ private:
+  /// Compares keys through their addresses, transparent so keys can be searched without their address.
+  struct Less {
+    typedef void is_transparent;
+
+    bool operator()(const TKey* left, const TKey* right) const { return *left < *right; }
+    bool operator()(const TKey* left, const TKey& right) const { return *left < right; }
+    bool operator()(const TKey& left, const TKey* right) const { return left < *right; }
+  };
+
+  detail::ResourceMap<const TKey*, std::uint32_t, Less> mMap;
+};
+
+/**
+ * Index from state ids to slots backed by a sorted contiguous array.
+ * Lookups are binary searches over a single block of memory, insertions and removals are linear.
+ * Best suited for machines built once and queried many times.
+ * @tparam TKey Type of the key. Must be comparable with operator<.
+ */
+template<typename TKey>
+class FlatMapIndex {
+ public:
+  FlatMapIndex() = default;
+
+  /// @copydoc MapIndex::MapIndex(std::pmr::memory_resource*)
+  explicit FlatMapIndex(std::pmr::memory_resource* resource) : mEntries(resource) {}
+
+  /// @copydoc MapIndex::find()
+  const std::uint32_t* find(const TKey& key) const {
+    const auto found = lowerBound(key);
+    return (found != mEntries.end() && !(key < *found->first)) ? &found->second : nullptr;
+  }
+
+  /// @copydoc MapIndex::insert()
+  bool insert(const TKey& key, std::uint32_t slot) {
+    const auto found = lowerBound(key);
+    if (found != mEntries.end() && !(key < *found->first)) {
+      return false;
+    }
+
+    mEntries.emplace(found, &key, slot);
+    return true;
+  }
+
+  /// @copydoc MapIndex::erase()
+  bool erase(const TKey& key) {
+    const auto found = lowerBound(key);
+    if (found == mEntries.end() || key < *found->first) {
+      return false;
+    }
+
+    mEntries.erase(found);
+    return true;
+  }
+
+  /**
+   * Reserve space for \a count keys.
+   */
+  void reserve(std::size_t count) {
+    mEntries.reserve(count);
+  }
+
+  std::size_t size() const {
+    return mEntries.size();
+  }
+
+ private:
+  typedef detail::ResourceVector<std::pair<const TKey*, std::uint32_t>> Entries;
+
+  typename Entries::const_iterator lowerBound(const TKey& key) const {
+    return std::lower_bound(mEntries.begin(), mEntries.end(), key,
+                            [](const auto& entry, const TKey& value) { return *entry.first < value; });
+  }
+
+  typename Entries::iterator lowerBound(const TKey& key) {
+    return std::lower_bound(mEntries.begin(), mEntries.end(), key,
+                            [](const auto& entry, const TKey& value) { return *entry.first < value; });
+  }
+
+  Entries mEntries; ///< Entries sorted by key.
+};
+
+/**
+ * Index from state ids to slots backed by an open addressing hash table.
+ * Uses linear probing over a power of two table with a maximum load factor of 1/2 and backward shift deletion, so
+ * there are no tombstones. Probing only touches the hashes array, keys are compared only when hashes match.
+ * @tparam TKey Type of the key. Must be hashable with std::hash and comparable with operator==.
+ */
+template<typename TKey, typename THash = std::hash<TKey>>
+class HashMapIndex {
+ public:
+  HashMapIndex() = default;
+
+  /// @copydoc MapIndex::MapIndex(std::pmr::memory_resource*)
+  explicit HashMapIndex(std::pmr::memory_resource* resource) : mBuckets(resource), mKeys(resource) {}
+
+  /// @copydoc MapIndex::find()
+  const std::uint32_t* find(const TKey& key) const {
+    const std::size_t bucket = findBucket(key);
+    return (bucket != kNotFound) ? &mBuckets[bucket].slot : nullptr;
+  }
+
+  /// @copydoc MapIndex::insert()
+  bool insert(const TKey& key, std::uint32_t slot) {
+    if (find(key) != nullptr) {
+      return false;
+    }
+
+    if ((mSize + 1) * 2 > mBuckets.size()) {
+      rehash(std::max<std::size_t>(kMinCapacity, mBuckets.size() * 2));
+    }
+
+    place(THash{}(key), &key, slot);
+    ++mSize;
+    return true;
+  }
+
+  /// @copydoc MapIndex::erase()
+  bool erase(const TKey& key) {
+    std::size_t hole = findBucket(key);
+    if (hole == kNotFound) {
+      return false;
+    }
+
+    // Backward shift deletion: move following entries of the same probe sequence into the hole
+    for (std::size_t next = (hole + 1) & mask(); mBuckets[next].slot != kEmpty; next = (next + 1) & mask()) {
+      const std::size_t home = mBuckets[next].hash & mask();
+      const bool homeBetween = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next);
+      if (!homeBetween) {
+        mBuckets[hole] = mBuckets[next];
+        mKeys[hole] = mKeys[next];
+        hole = next;
+      }
+    }
+
+    mBuckets[hole] = Bucket{};
+    mKeys[hole] = nullptr;
+    --mSize;
+    return true;
+  }
+
+  /**
+   * Reserve space for \a count keys without exceeding the maximum load factor.
+   */
+  void reserve(std::size_t count) {
+    std::size_t capacity = kMinCapacity;
+    while (capacity < count * 2) {
+      capacity *= 2;
+    }
+
+    if (capacity > mBuckets.size()) {
+      rehash(capacity);
+    }
+  }
+
+  std::size_t size() const {
+    return mSize;
+  }
+
+ private:
+  static constexpr std::uint32_t kEmpty = ~std::uint32_t{0};
+  static constexpr std::size_t kMinCapacity = 8;
+  static constexpr std::size_t kNotFound = ~std::size_t{0};
+
+  struct Bucket {
+    std::size_t hash = 0;
+    std::uint32_t slot = kEmpty; ///< Slot associated with the key, kEmpty marks an unused bucket.
+  };
+
+  std::size_t mask() const {
+    return mBuckets.size() - 1;
+  }
+
+  std::size_t findBucket(const TKey& key) const {
+    if (mSize == 0) {
+      return kNotFound;
+    }
+
+    const std::size_t hash = THash{}(key);
+    for (std::size_t i = hash & mask();; i = (i + 1) & mask()) {
+      const Bucket& bucket = mBuckets[i];
+      if (bucket.slot == kEmpty) {
+        return kNotFound;
+      }
+      if (bucket.hash == hash && *mKeys[i] == key) {
+        return i;
+      }
+    }
+  }
+
+  void place(std::size_t hash, const TKey* key, std::uint32_t slot) {
+    std::size_t i = hash & mask();
+    while (mBuckets[i].slot != kEmpty) {
+      i = (i + 1) & mask();
+    }
+
+    mBuckets[i] = Bucket{hash, slot};
+    mKeys[i] = key;
+  }
+
+  void rehash(std::size_t capacity) {
+    detail::ResourceVector<Bucket> oldBuckets(capacity, mBuckets.get_allocator());
+    detail::ResourceVector<const TKey*> oldKeys(capacity, mKeys.get_allocator());
+    oldBuckets.swap(mBuckets);
+    oldKeys.swap(mKeys);
+
+    for (std::size_t i = 0; i < oldBuckets.size(); ++i) {
+      if (oldBuckets[i].slot != kEmpty) {
+        place(oldBuckets[i].hash, oldKeys[i], oldBuckets[i].slot);
+      }
+    }
+  }
+
+  detail::ResourceVector<Bucket> mBuckets; ///< Hashes and slots, the only data touched while probing.
+  detail::ResourceVector<const TKey*> mKeys; ///< Addresses of the keys, in parallel with mBuckets.
+  std::size_t mSize = 0;
+};
+
+/**
+ * Storage policy that indexes states with a std::map.
+ * @sa MapIndex
+ */
+struct Map {
+  template<typename TKey>
+  using Index = MapIndex<TKey>;
+};
+
+/**
+ * Storage policy that indexes states with a sorted contiguous array.
+ * @sa FlatMapIndex
+ */
+struct FlatMap {
+  template<typename TKey>
+  using Index = FlatMapIndex<TKey>;
+};
+
+/**
+ * Storage policy that indexes states with an open addressing hash table.
+ * @sa HashMapIndex
+ */
+struct HashMap {
+  template<typename TKey>
+  using Index = HashMapIndex<TKey>;
+};
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Blackboard.hpp"
+#include "../Instrumentation.hpp"
+#include "WorldState.hpp"
+
+namespace aikit::goap {
+
+/**
+ * Binds facts of a goap::WorldState to bool keys of a aikit::Blackboard, so the world state a planner starts from is
+ * read from the memory of the agent instead of being kept in sync by hand.
+ * Bindings are made on setup. Reading and writing only go through the bindings, without looking up names.
+ * @tparam Bits Number of facts of the world states.
+ * @sa aikit::Blackboard
+ * @sa goap::Planner
+ */
+template<std::size_t Bits = 64>
+class BlackboardFacts {
+ public:
+  typedef WorldState<Bits> WorldState_type;
+
+  /**
+   * Bind a fact to a key.
+   * @param bit Index of the fact, must be less than Bits.
+   * @param key A key of the schema of the blackboards read and written.
+   * @return The bindings, so calls can be chained.
+   */
+  BlackboardFacts& bind(std::size_t bit, BlackboardKey<bool> key) {
+    mBindings.push_back({key, static_cast<std::uint32_t>(bit)});
+    return *this;
+  }
+
+  /**
+   * The world state seen on a blackboard.
+   * @param blackboard The blackboard read, its parents are looked up for keys without a value.
+   * @return Every bound fact set to the value of its key. Facts whose key has no value on the blackboard nor its
+   * parents are not set.
+   */
+  WorldState_type read(const Blackboard& blackboard) const {
+    WorldState_type state;
+    for (const auto& binding : mBindings) {
+      if (const bool* value = blackboard.find(binding.key)) {
+        state.set(binding.bit, *value);
+      }
+    }
+    return state;
+  }
+
+  /**
+   * Write the facts of a world state to a blackboard, such as the effects of an action that finished.
+   * @param state The facts written, bound facts not set on \a state are left untouched.
+   * @param blackboard The blackboard written, keys whose value does not change keep their version.
+   */
+  void write(const WorldState_type& state, Blackboard& blackboard) const {
+    for (const auto& binding : mBindings) {
+      if (state.isSet(binding.bit)) {
+        const bool value = state.get(binding.bit);
+        if (!blackboard.has(binding.key) || blackboard.get(binding.key) != value) {
+          blackboard.set(binding.key, value);
+        }
+      }
+    }
+  }
+
+  /**
+   * Number of facts bound.
+   */
+  std::size_t size() const {
+    return mBindings.size();
+  }
+
+ private:
+  template<typename T>
+  using Vector = detail::ModuleVector<T, InstrumentedModule::GOAP>;
+
+  struct Binding {
+    BlackboardKey<bool> key;
+    std::uint32_t bit; ///< Index of the fact on the world state.
+  };
+
+  Vector<Binding> mBindings; ///< Bindings in the order they were made.
+};
+
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "../Span.hpp"
+#include "WorldState.hpp"
+
+namespace aikit::goap {
+
+/**
+ * Least recently used cache of GOAP plans, keyed by the start world state, the goal and the version of the action set.
+ * Entries are preallocated on construction and found through a hash table of chained entries, evicting the least
+ * recently used entry when full. Failed searches are cached too, so an impossible goal is not searched again.
+ * Each entry has room for the actions of a plan of up to maxPlanLength() actions on a single array allocated on
+ * construction, so finding and inserting plans never allocates. Longer plans are not cached.
+ * @tparam Bits Number of facts of the world states.
+ * @sa Planner::enableCache()
+ */
+template<std::size_t Bits = 64>
+class PlanCache {
+ public:
+  typedef WorldState<Bits> WorldState_type;
+
+  /**
+   * A plan stored on the cache.
+   */
+  struct CachedPlan {
+    bool found = false; ///< False if the search did not find a plan.
+    Span<const std::uint32_t> actions; ///< Indices of the actions of the plan, in order, stored on the cache.
+  };
+
+  /**
+   * Create a cache.
+   * @param capacity Maximum number of plans kept, zero disables the cache.
+   * @param maxPlanLength Maximum number of actions of the plans kept.
+   */
+  explicit PlanCache(std::size_t capacity = 0, std::size_t maxPlanLength = 16)
+      : mEntries(capacity), mActions(capacity * maxPlanLength), mMaxPlanLength(maxPlanLength) {
+    std::size_t bucketCount = 1;
+    while (bucketCount < capacity) {
+      bucketCount <<= 1;
+    }
+    mBuckets.assign(bucketCount, kNoEntry);
+  }
+
+  /**
+   * Find a plan, marking it as the most recently used.
+   * @param start The world state the plan starts from.
+   * @param goal The goal of the plan.
+   * @param version Version of the action set the plan was made with.
+   * @return The cached plan, nullptr if there is none. Valid until the next call to insert() or clear().
+   */
+  const CachedPlan* find(const WorldState_type& start, const WorldState_type& goal, std::uint64_t version) {
+    const std::uint64_t hash = hashKey(start, goal, version);
+    for (std::uint32_t index = mBuckets[bucketOf(hash)]; index != kNoEntry; index = mEntries[index].bucketNext) {
+      Entry& entry = mEntries[index];
+      if (entry.hash == hash && entry.version == version && entry.start == start && entry.goal == goal) {
+        ++mHits;
+        unlink(index);
+        linkFront(index);
+        entry.plan.actions = {actionsOf(index), entry.length};
+        return &entry.plan;
+      }
+    }
+
+    ++mMisses;
+    return nullptr;
+  }
+
+  /**
+   * Store a plan as the most recently used, evicting the least recently used plan if the cache is full.
+   * @param start The world state the plan starts from.
+   * @param goal The goal of the plan.
+   * @param version Version of the action set the plan was made with.
+   * @param found False if the search did not find a plan.
+   * @param actions Indices of the actions of the plan, in order.
+   * @note Does nothing when the capacity is zero or the plan has more than maxPlanLength() actions. The plan must not
+   * be on the cache already.
+   */
+  void insert(const WorldState_type& start, const WorldState_type& goal, std::uint64_t version, bool found,
+              Span<const std::uint32_t> actions) {
+    if (mEntries.empty() || actions.size() > mMaxPlanLength) {
+      return;
+    }
+
+    std::uint32_t index;
+    if (mSize < mEntries.size()) {
+      index = static_cast<std::uint32_t>(mSize++);
+    } else {
+      index = mTail;
+      unlink(index);
+      removeFromBucket(index);
+    }
+
+    Entry& entry = mEntries[index];
+    entry.start = start;
+    entry.goal = goal;
+    entry.version = version;
+    entry.hash = hashKey(start, goal, version);
+    entry.plan.found = found;
+    entry.length = actions.size();
+    std::copy(actions.begin(), actions.end(), actionsOf(index));
+
+    std::uint32_t& bucket = mBuckets[bucketOf(entry.hash)];
+    entry.bucketNext = bucket;
+    bucket = index;
+    linkFront(index);
+  }
+
+  /**
+   * Remove all plans, keeping the counters.
+   */
+  void clear() {
+    std::fill(mBuckets.begin(), mBuckets.end(), kNoEntry);
+    mHead = mTail = kNoEntry;
+    mSize = 0;
+  }
+
+  /**
+   * Maximum number of plans kept.
+   */
+  std::size_t capacity() const {
+    return mEntries.size();
+  }
+
+  /**
+   * Maximum number of actions of the plans kept.
+   */
+  std::size_t maxPlanLength() const {
+    return mMaxPlanLength;
+  }
+
+  /**
+   * Number of plans on the cache.
+   */
+  std::size_t size() const {
+    return mSize;
+  }
+
+  /**
+   * Number of calls to find() that found a plan.
+   */
+  std::uint64_t hits() const {
+    return mHits;
+  }
+
+  /**
+   * Number of calls to find() that did not find a plan.
+   */
+  std::uint64_t misses() const {
+    return mMisses;
+  }
+
+  /**
+   * Fraction of the calls to find() that found a plan.
+   * @return A value in [0, 1], zero before the first call.
+   */
+  double hitRate() const {
+    const std::uint64_t lookups = mHits + mMisses;
+    return (lookups == 0) ? 0.0 : static_cast<double>(mHits) / static_cast<double>(lookups);
+  }
+
+  /**
+   * Reset the hit and miss counters.
+   */
+  void resetCounters() {
+    mHits = mMisses = 0;
+  }
+
+ private:
+  static constexpr std::uint32_t kNoEntry = ~std::uint32_t{0};
+
+  template<typename T>
+  using Vector = detail::ModuleVector<T, InstrumentedModule::GOAP>;
+
+  struct Entry {
+    WorldState_type start;
+    WorldState_type goal;
+    std::uint64_t version = 0;
+    std::uint64_t hash = 0;
+    CachedPlan plan;
+    std::size_t length = 0; ///< Number of actions of the plan.
+    std::uint32_t previous = kNoEntry; ///< More recently used entry.
+    std::uint32_t next = kNoEntry; ///< Less recently used entry.
+    std::uint32_t bucketNext = kNoEntry; ///< Next entry on the same bucket.
+  };
+
+  static std::uint64_t hashKey(const WorldState_type& start, const WorldState_type& goal, std::uint64_t version) {
+    std::uint64_t hash = start.hash();
+    hash ^= goal.hash() + 0x9e3779b97f4a7c15u + (hash << 6) + (hash >> 2);
+    hash ^= version + 0x9e3779b97f4a7c15u + (hash << 6) + (hash >> 2);
+    return hash;
+  }
+
+  std::size_t bucketOf(std::uint64_t hash) const {
+    return static_cast<std::size_t>(hash) & (mBuckets.size() - 1);
+  }
+
+  std::uint32_t* actionsOf(std::uint32_t index) {
+    return mActions.data() + index * mMaxPlanLength;
+  }
+
+  void unlink(std::uint32_t index) {
+    Entry& entry = mEntries[index];
+    (entry.previous != kNoEntry ? mEntries[entry.previous].next : mHead) = entry.next;
+    (entry.next != kNoEntry ? mEntries[entry.next].previous : mTail) = entry.previous;
+  }
+
+  void linkFront(std::uint32_t index) {
+    Entry& entry = mEntries[index];
+    entry.previous = kNoEntry;
+    entry.next = mHead;
+    (mHead != kNoEntry ? mEntries[mHead].previous : mTail) = index;
+    mHead = index;
+  }
+
+  void removeFromBucket(std::uint32_t index) {
+    std::uint32_t* link = &mBuckets[bucketOf(mEntries[index].hash)];
+    while (*link != index) {
+      link = &mEntries[*link].bucketNext;
+    }
+    *link = mEntries[index].bucketNext;
+  }
+
+  Vector<Entry> mEntries; ///< All entries, the first mSize are in use.
+  Vector<std::uint32_t> mBuckets; ///< First entry of each bucket of the hash table.
+  Vector<std::uint32_t> mActions; ///< Actions of the plans, maxPlanLength() per entry.
+  std::size_t mMaxPlanLength;
+  std::size_t mSize = 0;
+  std::uint32_t mHead = kNoEntry; ///< Most recently used entry.
+  std::uint32_t mTail = kNoEntry; ///< Least recently used entry, the next one evicted.
+  std::uint64_t mHits = 0;
+  std::uint64_t mMisses = 0;
+};
+
+}
@@ -0,0 +1,504 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "PlanCache.hpp"
+#include "WorldState.hpp"
+
+namespace aikit::goap {
+
+/**
+ * Status of a search of goap::Planner.
+ */
+enum class PlanStatus : std::uint8_t {
+  Running, ///< The search needs more steps.
+  Found, ///< A plan was found.
+  NotFound, ///< There is no plan.
+  OutOfNodes ///< The search needed more world states than the node capacity of its Planner::Search.
+};
+
+/**
+ * An action available to the GOAP planner.
+ * @tparam Bits Number of facts of the world states.
+ */
+template<std::size_t Bits = 64>
+struct Action {
+  WorldState<Bits> preconditions; ///< Facts that must hold for the action to be taken.
+  WorldState<Bits> effects; ///< Facts changed by the action.
+  float cost = 1.0f; ///< Cost of taking the action, must not be negative.
+};
+
+/**
+ * Goal Oriented Action Planning planner.
+ * Finds the cheapest sequence of actions taking a world state to one that satisfies a goal, using A* over world
+ * states. Preconditions and effects are goap::WorldState bitsets, so expanding a node is a few bitwise operations per
+ * action.
+ * All memory of a search is allocated up front on a Planner::Search: search nodes come from a pool of fixed capacity,
+ * the open list is a binary heap of node indices and visited world states are found on an open addressing table.
+ * Planning does not allocate, apart from growing the vector receiving the plan.
+ * plan() runs a whole search at once. begin() and step() run a search a bounded number of expansions at a time,
+ * keeping its state on a Planner::Search between calls, so planning for many agents can be spread over many frames.
+ * The actions are shared by all searches, so one planner serves any number of agents.
+ * Agents often plan again from the same world state to the same goal, plan() can reuse those plans from a cache, see
+ * enableCache().
+ * @tparam Bits Number of facts of the world states.
+ * @note The plan is optimal: the heuristic is the number of facts of the goal not met, divided by the largest number of
+ * facts set by an action, times the cheapest action cost, which never overestimates.
+ * @sa goap::WorldState
+ * @sa goap::Action
+ */
+template<std::size_t Bits = 64>
+class Planner {
+ public:
+  typedef WorldState<Bits> WorldState_type;
+  typedef Action<Bits> Action_type;
+
+  static constexpr std::uint32_t kInvalidAction = ~std::uint32_t{0};
+
+  /**
+   * Memory of a goap::Planner search: the pool of search nodes, the open list and the visited world states.
+   * Everything is allocated on construction, so running a search never allocates. A search can be reused for any number
+   * of searches, one at a time, and each agent planning incrementally needs its own.
+   * @sa Planner::begin()
+   */
+  class Search {
+   public:
+    /**
+     * Create the memory of a search.
+     * @param nodeCapacity Maximum number of world states visited by a search. Searches needing more stop with
+     * PlanStatus::OutOfNodes.
+     */
+    explicit Search(std::size_t nodeCapacity = 4096) {
+      mNodes.reserve(nodeCapacity);
+      mOpen.reserve(nodeCapacity);
+
+      std::size_t tableSize = 1;
+      while (tableSize < 2 * nodeCapacity) {
+        tableSize <<= 1;
+      }
+      mTable.assign(tableSize, TableSlot{});
+    }
+
+    // Copies would not keep the reserved memory
+    Search(const Search&) = delete;
+    Search& operator=(const Search&) = delete;
+    Search(Search&&) noexcept = default;
+    Search& operator=(Search&&) noexcept = default;
+
+    /**
+     * Status of the last search.
+     * @return PlanStatus::NotFound if no search was started.
+     */
+    PlanStatus status() const {
+      return mStatus;
+    }
+
+    /**
+     * Maximum number of world states visited by a search.
+     */
+    std::size_t nodeCapacity() const {
+      return mNodes.capacity();
+    }
+
+    /**
+     * Number of world states visited by the last search so far.
+     */
+    std::size_t visitedCount() const {
+      return mNodes.size();
+    }
+
+   private:
+    friend class Planner;
+
+    template<typename T>
+    using Vector = detail::ModuleVector<T, InstrumentedModule::GOAP>;
+
+    /**
+     * A world state visited by the search.
+     */
+    struct Node {
+      WorldState_type state;
+      float cost; ///< Cost of the cheapest known path from the start.
+      float estimate; ///< Cost plus the heuristic.
+      std::uint32_t parent;
+      std::uint32_t action; ///< Action taken from the parent.
+      std::uint32_t heapIndex; ///< Position on the open list, kClosed once expanded.
+    };
+
+    /**
+     * Slot of the table of visited world states, only valid when its stamp matches the current search.
+     */
+    struct TableSlot {
+      std::uint32_t node = kNoNode;
+      std::uint32_t search = 0;
+    };
+
+    void reset(const WorldState_type& goal) {
+      mNodes.clear();
+      mOpen.clear();
+      if (++mStamp == 0) {
+        // Counter wrapped, stale slots could look valid
+        std::fill(mTable.begin(), mTable.end(), TableSlot{});
+        mStamp = 1;
+      }
+      mGoal = goal;
+      mStatus = PlanStatus::Running;
+      mFound = kNoNode;
+    }
+
+    TableSlot& findSlot(const WorldState_type& state) {
+      const std::size_t mask = mTable.size() - 1;
+      for (std::size_t i = static_cast<std::size_t>(state.hash()) & mask;; i = (i + 1) & mask) {
+        TableSlot& slot = mTable[i];
+        if (slot.search != mStamp || mNodes[slot.node].state == state) {
+          return slot;
+        }
+      }
+    }
+
+    void push(const WorldState_type& state, float cost, float estimate, std::uint32_t parent, std::uint32_t action,
+              TableSlot& slot) {
+      const auto index = static_cast<std::uint32_t>(mNodes.size());
+      mNodes.push_back({state, cost, estimate, parent, action, static_cast<std::uint32_t>(mOpen.size())});
+      slot = {index, mStamp};
+      mOpen.push_back(index);
+      siftUp(mNodes[index].heapIndex);
+    }
+
+    std::uint32_t popOpen() {
+      const std::uint32_t top = mOpen.front();
+      mNodes[top].heapIndex = kClosed;
+
+      const std::uint32_t last = mOpen.back();
+      mOpen.pop_back();
+      if (!mOpen.empty()) {
+        mOpen.front() = last;
+        mNodes[last].heapIndex = 0;
+        siftDown(0);
+      }
+      return top;
+    }
+
+    void siftUp(std::uint32_t position) {
+      const std::uint32_t node = mOpen[position];
+      while (position > 0) {
+        const std::uint32_t parent = (position - 1) / 2;
+        if (mNodes[mOpen[parent]].estimate <= mNodes[node].estimate) {
+          break;
+        }
+        mOpen[position] = mOpen[parent];
+        mNodes[mOpen[position]].heapIndex = position;
+        position = parent;
+      }
+      mOpen[position] = node;
+      mNodes[node].heapIndex = position;
+    }
+
+    void siftDown(std::uint32_t position) {
+      const std::uint32_t node = mOpen[position];
+      const auto size = static_cast<std::uint32_t>(mOpen.size());
+      for (;;) {
+        std::uint32_t child = 2 * position + 1;
+        if (child >= size) {
+          break;
+        }
+        if (child + 1 < size && mNodes[mOpen[child + 1]].estimate < mNodes[mOpen[child]].estimate) {
+          ++child;
+        }
+        if (mNodes[node].estimate <= mNodes[mOpen[child]].estimate) {
+          break;
+        }
+        mOpen[position] = mOpen[child];
+        mNodes[mOpen[position]].heapIndex = position;
+        position = child;
+      }
+      mOpen[position] = node;
+      mNodes[node].heapIndex = position;
+    }
+
+    Vector<Node> mNodes; ///< Pool of search nodes, its capacity is never exceeded.
+    Vector<std::uint32_t> mOpen; ///< Binary heap of nodes not expanded yet, by estimate.
+    Vector<TableSlot> mTable; ///< Visited world states, open addressing with linear probing.
+    std::uint32_t mStamp = 0; ///< Counter of searches, marks the slots of the table in use.
+    WorldState_type mGoal;
+    PlanStatus mStatus = PlanStatus::NotFound;
+    std::uint32_t mFound = kNoNode; ///< Node meeting the goal once found.
+  };
+
+  /**
+   * Create a planner without actions.
+   * @param nodeCapacity Maximum number of world states visited by plan(). Searches needing more fail, as they could
+   * otherwise miss the cheapest plan.
+   */
+  explicit Planner(std::size_t nodeCapacity = 4096) : mSearch(nodeCapacity) {}
+
+  /**
+   * Add an action to the planner.
+   * @param action The action being added.
+   * @return Index of the action, used to reference it in the plans and other methods.
+   */
+  std::uint32_t addAction(const Action_type& action) {
+    mActions.push_back({action, true});
+    actionsChanged();
+    return static_cast<std::uint32_t>(mActions.size() - 1);
+  }
+
+  /**
+   * Remove an action from the planner, it is not used by later plans.
+   * @param action Index of the action being removed.
+   * @return True if the action was found and removed.
+   * @note Indices of other actions do not change.
+   */
+  bool removeAction(std::uint32_t action) {
+    if (!hasAction(action)) {
+      return false;
+    }
+
+    mActions[action].active = false;
+    actionsChanged();
+    return true;
+  }
+
+  /**
+   * Check if \a action refers to an action of the planner.
+   * @param action Index of an action.
+   * @return True if the action was added and not removed.
+   */
+  bool hasAction(std::uint32_t action) const {
+    return action < mActions.size() && mActions[action].active;
+  }
+
+  /**
+   * Get an action of the planner.
+   * @param action Index of an action.
+   * @return The action with the index \a action.
+   * @warning Will return nullptr if there is no such action.
+   */
+  const Action_type* getAction(std::uint32_t action) const {
+    return hasAction(action) ? &mActions[action].action : nullptr;
+  }
+
+  /**
+   * Number of actions of the planner.
+   * @return The number of actions added and not removed.
+   */
+  std::size_t actionCount() const {
+    return static_cast<std::size_t>(
+        std::count_if(mActions.begin(), mActions.end(), [](const ActionEntry& entry) { return entry.active; }));
+  }
+
+  /**
+   * Version of the action set, changed every time an action is added or removed.
+   * @return The version plans made now are cached with.
+   */
+  std::uint64_t actionsVersion() const {
+    return mActionsVersion;
+  }
+
+  /**
+   * Keep the plans made by plan() on a least recently used cache, so planning again from the same world state to the
+   * same goal is a lookup. Plans are keyed by start, goal and actionsVersion(), adding or removing actions empties the
+   * cache.
+   * @param capacity Maximum number of plans kept, zero disables the cache.
+   * @param maxPlanLength Maximum number of actions of the plans kept, longer plans are searched every time.
+   * @note Replaces any previous cache, with its counters.
+   * @note Incremental searches do not use the cache.
+   */
+  void enableCache(std::size_t capacity, std::size_t maxPlanLength = 16) {
+    mCache = PlanCache<Bits>(capacity, maxPlanLength);
+  }
+
+  /**
+   * The plan cache, for its hit and miss counters.
+   * @return The cache, with zero capacity if enableCache() was not called.
+   */
+  const PlanCache<Bits>& cache() const {
+    return mCache;
+  }
+
+  /**
+   * Maximum number of world states visited by plan().
+   */
+  std::size_t nodeCapacity() const {
+    return mSearch.nodeCapacity();
+  }
+
+  /**
+   * Find the cheapest sequence of actions taking \a start to a world state that satisfies \a goal.
+   * @param start The current world state.
+   * @param goal Facts that must hold at the end of the plan.
+   * @param plan Receives the indices of the actions to take, in order. Empty if \a start already satisfies \a goal.
+   * @return False if no plan was found within nodeCapacity() world states, \a plan is then empty.
+   * @sa begin() to spread a search over many calls.
+   */
+  bool plan(const WorldState_type& start, const WorldState_type& goal, std::vector<std::uint32_t>& plan) {
+    if (mCache.capacity() > 0) {
+      if (const auto* cached = mCache.find(start, goal, mActionsVersion)) {
+        plan.assign(cached->actions.begin(), cached->actions.end());
+        return cached->found;
+      }
+    }
+
+    begin(mSearch, start, goal);
+    step(mSearch, ~std::size_t{0});
+    const bool found = result(mSearch, plan);
+
+    mCache.insert(start, goal, mActionsVersion, found, plan);
+    return found;
+  }
+
+  /**
+   * Start an incremental search, run by later calls to step().
+   * Any search previously running on \a search is discarded.
+   * @param search Memory of the search, kept between calls.
+   * @param start The current world state.
+   * @param goal Facts that must hold at the end of the plan.
+   * @return Status of the search, PlanStatus::Running unless the search has no memory (PlanStatus::OutOfNodes).
+   */
+  PlanStatus begin(Search& search, const WorldState_type& start, const WorldState_type& goal) const {
+    search.reset(goal);
+    if (search.nodeCapacity() == 0) {
+      search.mStatus = PlanStatus::OutOfNodes;
+    } else {
+      search.push(start, 0.0f, heuristic(start, goal), kNoNode, kInvalidAction, search.findSlot(start));
+    }
+    return search.mStatus;
+  }
+
+  /**
+   * Continue an incremental search, expanding at most \a maxExpansions world states.
+   * The open list and visited world states are kept on \a search, so a search can be time sliced over many frames
+   * and many agents can each have a search running at the same time.
+   * @param search A search started by begin().
+   * @param maxExpansions Maximum number of world states expanded by this call.
+   * @return PlanStatus::Running while the search needs more steps.
+   * @attention Actions must not be added or removed while a search is running.
+   */
+  PlanStatus step(Search& search, std::size_t maxExpansions) const {
+    for (std::size_t expansion = 0; expansion < maxExpansions && search.mStatus == PlanStatus::Running; ++expansion) {
+      expand(search);
+    }
+    return search.mStatus;
+  }
+
+  /**
+   * The plan found by a search.
+   * @param search A search that finished.
+   * @param plan Receives the indices of the actions to take, in order. Empty if the start already met the goal.
+   * @return False if the search did not find a plan (yet), \a plan is then empty.
+   */
+  bool result(const Search& search, std::vector<std::uint32_t>& plan) const {
+    plan.clear();
+    if (search.mStatus != PlanStatus::Found) {
+      return false;
+    }
+
+    for (std::uint32_t node = search.mFound; search.mNodes[node].parent != kNoNode; node = search.mNodes[node].parent) {
+      plan.push_back(search.mNodes[node].action);
+    }
+    std::reverse(plan.begin(), plan.end());
+    return true;
+  }
+
+ private:
+  static constexpr std::uint32_t kNoNode = ~std::uint32_t{0};
+  static constexpr std::uint32_t kClosed = ~std::uint32_t{0};
+
+  template<typename T>
+  using Vector = detail::ModuleVector<T, InstrumentedModule::GOAP>;
+
+  struct ActionEntry {
+    Action_type action;
+    bool active;
+  };
+
+  void expand(Search& search) const {
+    if (search.mOpen.empty()) {
+      search.mStatus = PlanStatus::NotFound;
+      return;
+    }
+
+    const std::uint32_t current = search.popOpen();
+    if (search.mNodes[current].state.satisfies(search.mGoal)) {
+      search.mStatus = PlanStatus::Found;
+      search.mFound = current;
+      return;
+    }
+
+    for (std::uint32_t action = 0; action < mActions.size(); ++action) {
+      const ActionEntry& entry = mActions[action];
+      if (!entry.active || !search.mNodes[current].state.satisfies(entry.action.preconditions)) {
+        continue;
+      }
+
+      WorldState_type next = search.mNodes[current].state;
+      next.apply(entry.action.effects);
+      const float cost = search.mNodes[current].cost + entry.action.cost;
+
+      auto& slot = search.findSlot(next);
+      if (slot.search != search.mStamp) {
+        // Dropping the world state could miss the cheapest plan, the search stops instead
+        if (search.mNodes.size() == search.mNodes.capacity()) {
+          search.mStatus = PlanStatus::OutOfNodes;
+          return;
+        }
+        search.push(next, cost, cost + heuristic(next, search.mGoal), current, action, slot);
+        continue;
+      }
+
+      auto& visited = search.mNodes[slot.node];
+      if (cost >= visited.cost) {
+        continue;
+      }
+
+      // Cheaper path to a known state
+      visited.estimate -= visited.cost - cost;
+      visited.cost = cost;
+      visited.parent = current;
+      visited.action = action;
+      if (visited.heapIndex == kClosed) {
+        visited.heapIndex = static_cast<std::uint32_t>(search.mOpen.size());
+        search.mOpen.push_back(slot.node);
+      }
+      search.siftUp(visited.heapIndex);
+    }
+  }
+
+  float heuristic(const WorldState_type& state, const WorldState_type& goal) const {
+    const std::size_t missing = state.distance(goal);
+    return (missing == 0) ? 0.0f
+                          : static_cast<float>((missing + mMaxEffectCount - 1) / mMaxEffectCount) * mMinCost;
+  }
+
+  void actionsChanged() {
+    ++mActionsVersion;
+    mCache.clear();
+    updateHeuristic();
+  }
+
+  void updateHeuristic() {
+    mMinCost = 0.0f;
+    mMaxEffectCount = 1;
+    bool first = true;
+    for (const auto& entry : mActions) {
+      if (entry.active) {
+        mMinCost = first ? entry.action.cost : std::min(mMinCost, entry.action.cost);
+        mMaxEffectCount = std::max(mMaxEffectCount, entry.action.effects.count());
+        first = false;
+      }
+    }
+  }
+
+  Vector<ActionEntry> mActions; ///< Actions by index, removed actions are kept inactive.
+  float mMinCost = 0.0f; ///< Cost of the cheapest action, for the heuristic.
+  std::size_t mMaxEffectCount = 1; ///< Largest number of facts set by an action, for the heuristic.
+  std::uint64_t mActionsVersion = 0;
+  Search mSearch; ///< Memory of the searches of plan().
+  PlanCache<Bits> mCache; ///< Plans made by plan(), disabled until enableCache().
+};
+
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace aikit::goap {
+
+/**
+ * State of the world as seen by GOAP, a fixed number of boolean facts stored as bits.
+ * Next to the value of each fact, a mask tells if the fact is set or if it "does not matter". The same type describes
+ * full world states, the preconditions and effects of actions and goals, so checking and applying them is a handful of
+ * bitwise operations on a few words.
+ * @tparam Bits Number of facts, each fact is referenced by its index in [0, Bits).
+ * @sa goap::Planner
+ */
+template<std::size_t Bits = 64>
+class WorldState {
+  static_assert(Bits > 0, "WorldState needs at least one fact");
+
+ public:
+  static constexpr std::size_t kBits = Bits;
+  static constexpr std::size_t kWords = (Bits + 63) / 64;
+
+  /**
+   * Create a world state where no fact is set.
+   */
+  WorldState() = default;
+
+  /**
+   * Set the value of a fact.
+   * @param bit Index of the fact, must be less than Bits.
+   * @param value Value of the fact.
+   * @return The world state, so calls can be chained.
+   */
+  WorldState& set(std::size_t bit, bool value = true) {
+    const std::uint64_t flag = std::uint64_t{1} << (bit % 64);
+    mMask[bit / 64] |= flag;
+    mValues[bit / 64] = value ? (mValues[bit / 64] | flag) : (mValues[bit / 64] & ~flag);
+    return *this;
+  }
+
+  /**
+   * Make a fact "not matter", as if it was never set.
+   * @param bit Index of the fact, must be less than Bits.
+   * @return The world state, so calls can be chained.
+   */
+  WorldState& unset(std::size_t bit) {
+    const std::uint64_t flag = std::uint64_t{1} << (bit % 64);
+    mMask[bit / 64] &= ~flag;
+    mValues[bit / 64] &= ~flag;
+    return *this;
+  }
+
+  /**
+   * Check if a fact is set.
+   * @param bit Index of the fact, must be less than Bits.
+   * @return False if the fact does not matter.
+   */
+  bool isSet(std::size_t bit) const {
+    return (mMask[bit / 64] >> (bit % 64)) & 1u;
+  }
+
+  /**
+   * The value of a fact.
+   * @param bit Index of the fact, must be less than Bits.
+   * @return Value of the fact, false if it is not set.
+   */
+  bool get(std::size_t bit) const {
+    return (mValues[bit / 64] >> (bit % 64)) & 1u;
+  }
+
+  /**
+   * Check if the world state meets a set of \a conditions, such as the preconditions of an action or a goal.
+   * @param conditions The facts that must hold, facts not set on \a conditions do not matter.
+   * @return True if every fact set on \a conditions is set on this world state with the same value.
+   */
+  bool satisfies(const WorldState& conditions) const {
+    for (std::size_t i = 0; i < kWords; ++i) {
+      if ((((mValues[i] ^ conditions.mValues[i]) | ~mMask[i]) & conditions.mMask[i]) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Number of facts set on \a conditions that do not hold on this world state.
+   * @param conditions The facts that must hold.
+   * @return Zero if and only if satisfies(\a conditions).
+   */
+  std::size_t distance(const WorldState& conditions) const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < kWords; ++i) {
+      count += popCount((((mValues[i] ^ conditions.mValues[i]) | ~mMask[i]) & conditions.mMask[i]));
+    }
+    return count;
+  }
+
+  /**
+   * Apply the \a effects of an action, overwriting the facts they set.
+   * @param effects The facts changed by the action, facts not set on \a effects are kept.
+   * @return The world state, so calls can be chained.
+   */
+  WorldState& apply(const WorldState& effects) {
+    for (std::size_t i = 0; i < kWords; ++i) {
+      mValues[i] = (mValues[i] & ~effects.mMask[i]) | (effects.mValues[i] & effects.mMask[i]);
+      mMask[i] |= effects.mMask[i];
+    }
+    return *this;
+  }
+
+  /**
+   * Number of facts set.
+   * @return Number of facts that matter.
+   */
+  std::size_t count() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < kWords; ++i) {
+      count += popCount(mMask[i]);
+    }
+    return count;
+  }
+
+  /**
+   * Hash of the world state, for use on hash tables.
+   * @return A hash of the values and mask.
+   */
+  std::uint64_t hash() const {
+    std::uint64_t hash = 0xcbf29ce484222325u;
+    for (std::size_t i = 0; i < kWords; ++i) {
+      hash = mix(hash ^ mValues[i]);
+      hash = mix(hash ^ mMask[i]);
+    }
+    return hash;
+  }
+
+  bool operator==(const WorldState& other) const {
+    return mValues == other.mValues && mMask == other.mMask;
+  }
+
+  bool operator!=(const WorldState& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  static std::size_t popCount(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_popcountll(word));
+#else
+    std::size_t count = 0;
+    for (; word != 0; word &= word - 1) {
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+  static std::uint64_t mix(std::uint64_t value) {
+    // Finalizer of MurmurHash3
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdu;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53u;
+    value ^= value >> 33;
+    return value;
+  }
+
+  std::array<std::uint64_t, kWords> mValues{}; ///< Value of each fact, zero for facts not set.
+  std::array<std::uint64_t, kWords> mMask{}; ///< Facts that are set.
+};
+
+}
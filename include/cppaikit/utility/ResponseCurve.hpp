@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+#include "SimdFloat.hpp"
+
+namespace aikit::utility {
+
+/**
+ * Shapes of a utility::ResponseCurve.
+ */
+enum class CurveType : std::uint8_t {
+  Linear, ///< y = slope * (x - xShift) + yShift
+  Quadratic, ///< y = slope * (x - xShift)^2 + yShift
+  Logistic, ///< y = slope / (1 + e^(-steepness * (x - xShift))) + yShift
+  Piecewise ///< Straight lines between up to kMaxPoints points.
+};
+
+/**
+ * Maps an input of a consideration to a utility in [0, 1].
+ * Curves are plain values, created by linear(), quadratic(), logistic() and piecewise(), and evaluated one input at a
+ * time by evaluate() or many inputs at a time by evaluate(const float*, float*, std::size_t), which uses the widest
+ * SIMD instructions enabled at compile time (AVX2 or SSE2) with a scalar fallback.
+ * @note The output is clamped to [0, 1], the input is not clamped.
+ * @sa utility::Scorer
+ */
+struct ResponseCurve {
+  static constexpr std::size_t kMaxPoints = 8;
+
+  CurveType type = CurveType::Linear;
+  float slope = 1.0f; ///< Scale of the curve, the height of a logistic.
+  float steepness = 1.0f; ///< Steepness of a logistic.
+  float xShift = 0.0f; ///< Shift of the input, the midpoint of a logistic.
+  float yShift = 0.0f; ///< Shift of the output.
+  std::uint32_t pointCount = 0; ///< Number of points of a piecewise curve.
+  std::array<float, kMaxPoints> pointX{}; ///< Inputs of the points of a piecewise curve, increasing.
+  std::array<float, kMaxPoints> pointY{}; ///< Outputs of the points of a piecewise curve.
+
+  /**
+   * Create a straight line, y = slope * (x - xShift) + yShift.
+   */
+  static ResponseCurve linear(float slope = 1.0f, float xShift = 0.0f, float yShift = 0.0f) {
+    ResponseCurve curve;
+    curve.type = CurveType::Linear;
+    curve.slope = slope;
+    curve.xShift = xShift;
+    curve.yShift = yShift;
+    return curve;
+  }
+
+  /**
+   * Create a parabola, y = slope * (x - xShift)^2 + yShift.
+   */
+  static ResponseCurve quadratic(float slope = 1.0f, float xShift = 0.0f, float yShift = 0.0f) {
+    ResponseCurve curve = linear(slope, xShift, yShift);
+    curve.type = CurveType::Quadratic;
+    return curve;
+  }
+
+  /**
+   * Create a S shaped curve, y = height / (1 + e^(-steepness * (x - midpoint))) + yShift.
+   */
+  static ResponseCurve logistic(float steepness = 10.0f, float midpoint = 0.5f, float height = 1.0f,
+                                float yShift = 0.0f) {
+    ResponseCurve curve = linear(height, midpoint, yShift);
+    curve.type = CurveType::Logistic;
+    curve.steepness = steepness;
+    return curve;
+  }
+
+  /**
+   * Create a curve of straight lines between \a points, constant before the first and after the last point.
+   * @param points Pairs of input and output, sorted by input. Points after kMaxPoints are ignored.
+   * @note Points with the same input make a step.
+   */
+  static ResponseCurve piecewise(std::initializer_list<std::pair<float, float>> points) {
+    ResponseCurve curve;
+    curve.type = CurveType::Piecewise;
+    for (const auto& point : points) {
+      if (curve.pointCount == kMaxPoints) {
+        break;
+      }
+      curve.pointX[curve.pointCount] = point.first;
+      curve.pointY[curve.pointCount] = point.second;
+      ++curve.pointCount;
+    }
+    return curve;
+  }
+
+  /**
+   * Evaluate the curve.
+   * @param x The input.
+   * @return The output, in [0, 1].
+   */
+  float evaluate(float x) const {
+    return evaluatePack(detail::ScalarFloat::set(x)).value;
+  }
+
+  /**
+   * Evaluate the curve for many inputs.
+   * @param inputs Inputs, \a count contiguous floats.
+   * @param outputs Receives the outputs, \a count contiguous floats. Can be the same array as \a inputs.
+   * @param count Number of inputs.
+   */
+  void evaluate(const float* inputs, float* outputs, std::size_t count) const {
+    evaluateAll<false>(inputs, outputs, count);
+  }
+
+  /**
+   * Evaluate the curve for many inputs, multiplying the outputs into \a scores.
+   * @param inputs Inputs, \a count contiguous floats.
+   * @param scores Scores multiplied by the outputs, \a count contiguous floats.
+   * @param count Number of inputs.
+   */
+  void multiply(const float* inputs, float* scores, std::size_t count) const {
+    evaluateAll<true>(inputs, scores, count);
+  }
+
+ private:
+  template<bool Multiply>
+  void evaluateAll(const float* inputs, float* outputs, std::size_t count) const {
+    // The shape is chosen once per call, not once per pack
+    switch (type) {
+      case CurveType::Linear: evaluateAll<CurveType::Linear, Multiply>(inputs, outputs, count); break;
+      case CurveType::Quadratic: evaluateAll<CurveType::Quadratic, Multiply>(inputs, outputs, count); break;
+      case CurveType::Logistic: evaluateAll<CurveType::Logistic, Multiply>(inputs, outputs, count); break;
+      case CurveType::Piecewise: evaluateAll<CurveType::Piecewise, Multiply>(inputs, outputs, count); break;
+    }
+  }
+
+  template<CurveType Type, bool Multiply>
+  void evaluateAll(const float* inputs, float* outputs, std::size_t count) const {
+    const Slopes slopes = inverseWidths();
+    std::size_t i = 0;
+    for (; i + detail::SimdFloat::kWidth <= count; i += detail::SimdFloat::kWidth) {
+      store<Multiply>(evaluatePack<Type>(detail::SimdFloat::load(inputs + i), slopes), outputs + i);
+    }
+    for (; i < count; ++i) {
+      store<Multiply>(evaluatePack<Type>(detail::ScalarFloat::load(inputs + i), slopes), outputs + i);
+    }
+  }
+
+  template<bool Multiply, typename V>
+  static void store(V value, float* output) {
+    if (Multiply) {
+      value = value * V::load(output);
+    }
+    value.store(output);
+  }
+
+  typedef std::array<float, kMaxPoints> Slopes;
+
+  /// Inverse of the width of each segment of a piecewise curve, steps get a huge value instead.
+  Slopes inverseWidths() const {
+    Slopes slopes{};
+    for (std::uint32_t point = 1; point < pointCount; ++point) {
+      const float width = pointX[point] - pointX[point - 1];
+      slopes[point] = (width > 0.0f) ? 1.0f / width : 1e30f;
+    }
+    return slopes;
+  }
+
+  template<typename V>
+  V evaluatePack(V x) const {
+    switch (type) {
+      case CurveType::Linear: return evaluatePack<CurveType::Linear>(x, {});
+      case CurveType::Quadratic: return evaluatePack<CurveType::Quadratic>(x, {});
+      case CurveType::Logistic: return evaluatePack<CurveType::Logistic>(x, {});
+      case CurveType::Piecewise: return evaluatePack<CurveType::Piecewise>(x, inverseWidths());
+    }
+    return V::set(0.0f);
+  }
+
+  template<CurveType Type, typename V>
+  V evaluatePack(V x, const Slopes& slopes) const {
+    V y = V::set(0.0f);
+
+    if (Type == CurveType::Linear) {
+      y = V::set(slope) * (x - V::set(xShift)) + V::set(yShift);
+    } else if (Type == CurveType::Quadratic) {
+      const V shifted = x - V::set(xShift);
+      y = V::set(slope) * shifted * shifted + V::set(yShift);
+    } else if (Type == CurveType::Logistic) {
+      const V power = detail::exp(V::set(-steepness) * (x - V::set(xShift)));
+      y = V::set(slope) / (V::set(1.0f) + power) + V::set(yShift);
+    } else if (pointCount > 0) {
+      // Sum of clamped ramps: segments left of x add their whole rise, the one holding x part of it
+      y = V::set(pointY[0]);
+      for (std::uint32_t point = 1; point < pointCount; ++point) {
+        const V t = V::min(V::max((x - V::set(pointX[point - 1])) * V::set(slopes[point]), V::set(0.0f)),
+                           V::set(1.0f));
+        y = y + t * V::set(pointY[point] - pointY[point - 1]);
+      }
+    }
+
+    return V::min(V::max(y, V::set(0.0f)), V::set(1.0f));
+  }
+};
+
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Instrumentation.hpp"
+#include "../Span.hpp"
+#include "../fsm/StateHandle.hpp"
+#include "ResponseCurve.hpp"
+
+namespace aikit::utility {
+
+/**
+ * Utility based action selection for many agents at once.
+ * Each action has considerations, each mapping one input through a utility::ResponseCurve. The score of an action is
+ * its weight times the product of its considerations, and the winner of an agent is its action with the highest score.
+ * Inputs are stored as structure of arrays, the values of an input for all agents are contiguous, so each consideration
+ * is evaluated for a run of agents with SIMD instructions. Agents are scored in blocks small enough for their scores
+ * to stay in cache.
+ * Actions can carry the handle of a FSM state, so the winner drives a machine with transitionToWinner().
+ * @note On ties, the action added first wins.
+ * @sa utility::ResponseCurve
+ */
+class Scorer {
+ public:
+  static constexpr std::uint32_t kNoAction = ~std::uint32_t{0};
+
+  /**
+   * Create a scorer without actions.
+   * @param inputCount Number of inputs of every agent.
+   * @param agentCount Number of agents scored.
+   */
+  Scorer(std::size_t inputCount, std::size_t agentCount)
+      : mInputCount(inputCount), mAgentCount(agentCount), mInputs(inputCount * agentCount, 0.0f),
+        mWinners(agentCount, kNoAction), mWinnerScores(agentCount, 0.0f) {}
+
+  /**
+   * Add an action.
+   * @param state State of a FSM associated to the action, see transitionToWinner().
+   * @param weight Multiplier of the score of the action.
+   * @return Index of the action, used to reference it in the other methods.
+   */
+  std::uint32_t addAction(fsm::StateHandle state = {}, float weight = 1.0f) {
+    mActions.push_back({state, weight, {}});
+    return static_cast<std::uint32_t>(mActions.size() - 1);
+  }
+
+  /**
+   * Add a consideration to an action, multiplying its score by \a curve evaluated on \a input.
+   * @param action Index of the action.
+   * @param input Index of the input.
+   * @param curve Curve mapping the input to a utility.
+   * @return False if \a action or \a input do not exist.
+   */
+  bool addConsideration(std::uint32_t action, std::uint32_t input, const ResponseCurve& curve) {
+    if (action >= mActions.size() || input >= mInputCount) {
+      return false;
+    }
+
+    mActions[action].considerations.push_back({input, curve});
+    return true;
+  }
+
+  /**
+   * The values of an input for all agents, written by the user before score().
+   * @param input Index of the input.
+   * @return agentCount() contiguous values, one per agent.
+   */
+  Span<float> input(std::uint32_t input) {
+    return {mInputs.data() + input * mAgentCount, mAgentCount};
+  }
+
+  /**
+   * Set the value of an input of an agent.
+   * @param input Index of the input.
+   * @param agent Index of the agent.
+   * @param value Value of the input.
+   */
+  void setInput(std::uint32_t input, std::size_t agent, float value) {
+    mInputs[input * mAgentCount + agent] = value;
+  }
+
+  /**
+   * Score every action for every agent, updating the winners.
+   */
+  void score() {
+    std::array<float, kBlockSize> scores;
+    std::array<float, kBlockSize> bestScores;
+
+    for (std::size_t begin = 0; begin < mAgentCount; begin += kBlockSize) {
+      const std::size_t count = std::min(kBlockSize, mAgentCount - begin);
+      std::uint32_t* winners = mWinners.data() + begin;
+      std::fill(bestScores.begin(), bestScores.begin() + count, -1.0f);
+      std::fill(winners, winners + count, kNoAction);
+
+      for (std::uint32_t action = 0; action < mActions.size(); ++action) {
+        const Action& current = mActions[action];
+        std::fill(scores.begin(), scores.begin() + count, current.weight);
+        for (const auto& consideration : current.considerations) {
+          const float* inputs = mInputs.data() + consideration.input * mAgentCount + begin;
+          consideration.curve.multiply(inputs, scores.data(), count);
+        }
+
+        // Branchless so the compiler can vectorize it
+        for (std::size_t i = 0; i < count; ++i) {
+          const bool better = scores[i] > bestScores[i];
+          bestScores[i] = better ? scores[i] : bestScores[i];
+          winners[i] = better ? action : winners[i];
+        }
+      }
+
+      std::copy(bestScores.begin(), bestScores.begin() + count, mWinnerScores.data() + begin);
+    }
+  }
+
+  /**
+   * The action with the highest score for an agent on the last call to score().
+   * @param agent Index of the agent.
+   * @return Index of the action, kNoAction if there are no actions or score() was not called.
+   */
+  std::uint32_t winner(std::size_t agent) const {
+    return mWinners[agent];
+  }
+
+  /**
+   * The winners of all agents on the last call to score().
+   * @return agentCount() indices of actions.
+   */
+  Span<const std::uint32_t> winners() const {
+    return {mWinners.data(), mWinners.size()};
+  }
+
+  /**
+   * The score of the winner of an agent on the last call to score().
+   * @param agent Index of the agent.
+   */
+  float winnerScore(std::size_t agent) const {
+    return mWinnerScores[agent];
+  }
+
+  /**
+   * The FSM state associated to the winner of an agent.
+   * @param agent Index of the agent.
+   * @return Handle given to addAction(), unset if there is no winner.
+   */
+  fsm::StateHandle winnerState(std::size_t agent) const {
+    const std::uint32_t action = mWinners[agent];
+    return (action == kNoAction) ? fsm::StateHandle{} : mActions[action].state;
+  }
+
+  /**
+   * Make a machine transition to the state associated to the winner of an agent.
+   * @param machine A machine with the state given to addAction(), such as fsm::FSM.
+   * @param agent Index of the agent.
+   * @return True if the machine transitioned.
+   * @note Nothing happens if the winner has no state or its state is already the current state of \a machine.
+   */
+  template<typename TMachine>
+  bool transitionToWinner(TMachine& machine, std::size_t agent) const {
+    const fsm::StateHandle state = winnerState(agent);
+    return state.isSet() && state != machine.currentStateHandle() && machine.transitionTo(state);
+  }
+
+  /**
+   * Number of agents scored.
+   */
+  std::size_t agentCount() const {
+    return mAgentCount;
+  }
+
+  /**
+   * Number of inputs of every agent.
+   */
+  std::size_t inputCount() const {
+    return mInputCount;
+  }
+
+  /**
+   * Number of actions.
+   */
+  std::size_t actionCount() const {
+    return mActions.size();
+  }
+
+ private:
+  /// Agents scored at a time, their scores stay in L1 cache.
+  static constexpr std::size_t kBlockSize = 512;
+
+  template<typename T>
+  using Vector = aikit::detail::ModuleVector<T, InstrumentedModule::Utility>;
+
+  struct Consideration {
+    std::uint32_t input;
+    ResponseCurve curve;
+  };
+
+  struct Action {
+    fsm::StateHandle state;
+    float weight;
+    Vector<Consideration> considerations;
+  };
+
+  std::size_t mInputCount;
+  std::size_t mAgentCount;
+  Vector<float> mInputs; ///< Inputs by input then agent.
+  Vector<Action> mActions;
+  Vector<std::uint32_t> mWinners; ///< Winner of each agent.
+  Vector<float> mWinnerScores; ///< Score of the winner of each agent.
+};
+
+}
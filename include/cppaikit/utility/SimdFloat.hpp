@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace aikit::utility::detail {
+
+/**
+ * Minimal packs of floats used to write the curve kernels once for every instruction set.
+ * Each pack has the same operations, kWidth lanes and unaligned loads and stores. The widest pack available at compile
+ * time is SimdFloat, ScalarFloat is the fallback and is also used for the remainder of the arrays.
+ */
+struct ScalarFloat {
+  static constexpr std::size_t kWidth = 1;
+
+  float value;
+
+  static ScalarFloat load(const float* data) { return {*data}; }
+  static ScalarFloat set(float value) { return {value}; }
+  void store(float* data) const { *data = value; }
+
+  friend ScalarFloat operator+(ScalarFloat lhs, ScalarFloat rhs) { return {lhs.value + rhs.value}; }
+  friend ScalarFloat operator-(ScalarFloat lhs, ScalarFloat rhs) { return {lhs.value - rhs.value}; }
+  friend ScalarFloat operator*(ScalarFloat lhs, ScalarFloat rhs) { return {lhs.value * rhs.value}; }
+  friend ScalarFloat operator/(ScalarFloat lhs, ScalarFloat rhs) { return {lhs.value / rhs.value}; }
+
+  static ScalarFloat min(ScalarFloat lhs, ScalarFloat rhs) { return {(rhs.value < lhs.value) ? rhs.value : lhs.value}; }
+  static ScalarFloat max(ScalarFloat lhs, ScalarFloat rhs) { return {(lhs.value < rhs.value) ? rhs.value : lhs.value}; }
+
+  /// Nearest integer, as a float.
+  static ScalarFloat round(ScalarFloat x) {
+    return {static_cast<float>(static_cast<std::int32_t>(x.value + ((x.value < 0.0f) ? -0.5f : 0.5f)))};
+  }
+
+  /// 2 to the power of an integer \a n in [-126, 127], as a float.
+  static ScalarFloat pow2(ScalarFloat n) {
+    const std::uint32_t bits = static_cast<std::uint32_t>(static_cast<std::int32_t>(n.value) + 127) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return {result};
+  }
+};
+
+#if defined(__AVX2__)
+
+struct Avx2Float {
+  static constexpr std::size_t kWidth = 8;
+
+  __m256 value;
+
+  static Avx2Float load(const float* data) { return {_mm256_loadu_ps(data)}; }
+  static Avx2Float set(float value) { return {_mm256_set1_ps(value)}; }
+  void store(float* data) const { _mm256_storeu_ps(data, value); }
+
+  friend Avx2Float operator+(Avx2Float lhs, Avx2Float rhs) { return {_mm256_add_ps(lhs.value, rhs.value)}; }
+  friend Avx2Float operator-(Avx2Float lhs, Avx2Float rhs) { return {_mm256_sub_ps(lhs.value, rhs.value)}; }
+  friend Avx2Float operator*(Avx2Float lhs, Avx2Float rhs) { return {_mm256_mul_ps(lhs.value, rhs.value)}; }
+  friend Avx2Float operator/(Avx2Float lhs, Avx2Float rhs) { return {_mm256_div_ps(lhs.value, rhs.value)}; }
+
+  static Avx2Float min(Avx2Float lhs, Avx2Float rhs) { return {_mm256_min_ps(lhs.value, rhs.value)}; }
+  static Avx2Float max(Avx2Float lhs, Avx2Float rhs) { return {_mm256_max_ps(lhs.value, rhs.value)}; }
+
+  static Avx2Float round(Avx2Float x) {
+    return {_mm256_round_ps(x.value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+  }
+
+  static Avx2Float pow2(Avx2Float n) {
+    const __m256i exponent = _mm256_add_epi32(_mm256_cvtps_epi32(n.value), _mm256_set1_epi32(127));
+    return {_mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23))};
+  }
+};
+
+typedef Avx2Float SimdFloat;
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+struct Sse2Float {
+  static constexpr std::size_t kWidth = 4;
+
+  __m128 value;
+
+  static Sse2Float load(const float* data) { return {_mm_loadu_ps(data)}; }
+  static Sse2Float set(float value) { return {_mm_set1_ps(value)}; }
+  void store(float* data) const { _mm_storeu_ps(data, value); }
+
+  friend Sse2Float operator+(Sse2Float lhs, Sse2Float rhs) { return {_mm_add_ps(lhs.value, rhs.value)}; }
+  friend Sse2Float operator-(Sse2Float lhs, Sse2Float rhs) { return {_mm_sub_ps(lhs.value, rhs.value)}; }
+  friend Sse2Float operator*(Sse2Float lhs, Sse2Float rhs) { return {_mm_mul_ps(lhs.value, rhs.value)}; }
+  friend Sse2Float operator/(Sse2Float lhs, Sse2Float rhs) { return {_mm_div_ps(lhs.value, rhs.value)}; }
+
+  static Sse2Float min(Sse2Float lhs, Sse2Float rhs) { return {_mm_min_ps(lhs.value, rhs.value)}; }
+  static Sse2Float max(Sse2Float lhs, Sse2Float rhs) { return {_mm_max_ps(lhs.value, rhs.value)}; }
+
+  static Sse2Float round(Sse2Float x) {
+    // SSE2 has no round, converting uses the default rounding mode, to nearest
+    return {_mm_cvtepi32_ps(_mm_cvtps_epi32(x.value))};
+  }
+
+  static Sse2Float pow2(Sse2Float n) {
+    const __m128i exponent = _mm_add_epi32(_mm_cvtps_epi32(n.value), _mm_set1_epi32(127));
+    return {_mm_castsi128_ps(_mm_slli_epi32(exponent, 23))};
+  }
+};
+
+typedef Sse2Float SimdFloat;
+
+#else
+
+typedef ScalarFloat SimdFloat;
+
+#endif
+
+/**
+ * Exponential of every lane of \a x, with a relative error below 1e-6.
+ * The same approximation is used by every pack, so all instruction sets give the same curves within float rounding.
+ */
+template<typename V>
+V exp(V x) {
+  x = V::min(V::max(x, V::set(-87.0f)), V::set(88.0f));
+
+  // e^x = 2^n * e^r, with n the nearest integer to x / ln(2) and |r| <= ln(2) / 2
+  const V n = V::round(x * V::set(1.44269504f));
+  const V r = x - n * V::set(0.693145751953125f) - n * V::set(1.428606765330187e-6f);
+
+  // Taylor polynomial of e^r up to r^6
+  V p = V::set(1.0f / 720.0f);
+  p = p * r + V::set(1.0f / 120.0f);
+  p = p * r + V::set(1.0f / 24.0f);
+  p = p * r + V::set(1.0f / 6.0f);
+  p = p * r + V::set(0.5f);
+  p = p * r + V::set(1.0f);
+  p = p * r + V::set(1.0f);
+
+  return p * V::pow2(n);
+}
+
+}
@@ -0,0 +1,166 @@
+#include <cstdint>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/bt/BehaviorTree.hpp>
+
+namespace {
+
+using aikit::bt::Status;
+
+struct TestAgent {
+  bool enemyVisible = false;
+  Status moveStatus = Status::Success;
+  int attacks = 0;
+  int moves = 0;
+  int patrols = 0;
+};
+
+typedef aikit::bt::BehaviorTree<TestAgent> TestTree;
+
+bool isEnemyVisible(TestAgent& agent) { return agent.enemyVisible; }
+
+Status attack(TestAgent& agent) {
+  ++agent.attacks;
+  return Status::Success;
+}
+
+Status move(TestAgent& agent) {
+  ++agent.moves;
+  return agent.moveStatus;
+}
+
+Status patrol(TestAgent& agent) {
+  ++agent.patrols;
+  return Status::Running;
+}
+
+TEST_CASE("BehaviorTree is stored as a flat array of nodes", "[behavior_tree]") {
+  const auto tree = TestTree::Builder()
+      .selector()
+        .sequence()
+          .condition(isEnemyVisible)
+          .action(move)
+          .action(attack)
+        .end()
+        .action(patrol)
+      .end()
+      .build();
+
+  REQUIRE(tree.size() == 6);
+  REQUIRE(tree.instanceSize() == 2);
+
+  const auto nodes = tree.nodes();
+  REQUIRE(nodes[0].type == aikit::bt::NodeType::Selector);
+  REQUIRE(nodes[0].end == 6);
+  REQUIRE(nodes[1].type == aikit::bt::NodeType::Sequence);
+  REQUIRE(nodes[1].end == 5);
+  REQUIRE(nodes[2].end == 3);
+  REQUIRE(nodes[5].type == aikit::bt::NodeType::Action);
+
+  TestAgent agent;
+  std::vector<std::uint32_t> instance(tree.instanceSize());
+
+  SECTION("a failing sequence makes the selector try the next child") {
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.patrols == 1);
+    REQUIRE(agent.moves == 0);
+  }
+
+  SECTION("running nodes are resumed on the next tick") {
+    agent.enemyVisible = true;
+    agent.moveStatus = Status::Running;
+
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.moves == 1);
+
+    // The condition is not checked again while moving
+    agent.enemyVisible = false;
+    agent.moveStatus = Status::Success;
+    REQUIRE(tree.tick(agent, instance) == Status::Success);
+    REQUIRE(agent.moves == 2);
+    REQUIRE(agent.attacks == 1);
+    REQUIRE(agent.patrols == 0);
+    REQUIRE(instance == std::vector<std::uint32_t>(2, 0));
+  }
+
+  SECTION("agents share the tree with their own instances") {
+    TestAgent other;
+    std::vector<std::uint32_t> otherInstance(tree.instanceSize());
+    agent.enemyVisible = true;
+    agent.moveStatus = Status::Running;
+
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(tree.tick(other, otherInstance) == Status::Running);
+    REQUIRE(agent.moves == 1);
+    REQUIRE(other.patrols == 1);
+
+    TestTree::resetInstance(instance);
+    agent.enemyVisible = false;
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.patrols == 1);
+  }
+}
+
+TEST_CASE("BehaviorTree decorators and parallels", "[behavior_tree]") {
+  TestAgent agent;
+
+  SECTION("inverters swap success and failure") {
+    const auto tree = TestTree::Builder().inverter().condition(isEnemyVisible).end().build();
+    std::vector<std::uint32_t> instance(tree.instanceSize());
+
+    REQUIRE(tree.tick(agent, instance) == Status::Success);
+    agent.enemyVisible = true;
+    REQUIRE(tree.tick(agent, instance) == Status::Failure);
+  }
+
+  SECTION("repeats succeed after their child succeeds a number of times") {
+    const auto tree = TestTree::Builder().repeat(3).action(attack).build();
+    std::vector<std::uint32_t> instance(tree.instanceSize());
+
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(tree.tick(agent, instance) == Status::Success);
+    REQUIRE(agent.attacks == 3);
+    REQUIRE(instance[0] == 0);
+  }
+
+  SECTION("parallels abort running children when they finish") {
+    const auto tree = TestTree::Builder()
+        .parallel(1)
+          .sequence()
+            .action(move)
+            .action(attack)
+          .end()
+          .sequence()
+            .action(patrol)
+          .end()
+        .end()
+        .build();
+    std::vector<std::uint32_t> instance(tree.instanceSize());
+
+    agent.moveStatus = Status::Running;
+    REQUIRE(tree.tick(agent, instance) == Status::Running);
+    REQUIRE(instance[1] != 0);
+
+    agent.moveStatus = Status::Success;
+    REQUIRE(tree.tick(agent, instance) == Status::Success);
+    REQUIRE(agent.attacks == 1);
+    REQUIRE(agent.patrols == 2);
+    REQUIRE(instance == std::vector<std::uint32_t>(2, 0));
+  }
+
+  SECTION("parallels fail when the threshold can not be reached") {
+    const auto tree = TestTree::Builder().parallel(2).action(patrol).condition(isEnemyVisible).end().build();
+    std::vector<std::uint32_t> instance(tree.instanceSize());
+
+    REQUIRE(tree.tick(agent, instance) == Status::Failure);
+  }
+
+  SECTION("empty trees and decorators fail") {
+    REQUIRE(TestTree().tick(agent, {}) == Status::Failure);
+    REQUIRE(TestTree::Builder().inverter().build().tick(agent, {}) == Status::Failure);
+  }
+}
+
+}
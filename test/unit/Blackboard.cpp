@@ -0,0 +1,254 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/Blackboard.hpp>
+#include <cppaikit/bt/BehaviorTree.hpp>
+#include <cppaikit/bt/BlackboardConditions.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/goap/BlackboardFacts.hpp>
+
+namespace {
+
+using aikit::Blackboard;
+using aikit::BlackboardKey;
+using aikit::BlackboardSchema;
+
+struct Vector3 {
+  float x, y, z;
+};
+
+TEST_CASE("BlackboardSchema resolves names to typed slots", "[blackboard]") {
+  BlackboardSchema schema;
+  const auto health = schema.addKey<float>("health");
+  const auto ammo = schema.addKey<int>("ammo");
+  const auto target = schema.addKey<Vector3>("target");
+
+  REQUIRE(health.isSet());
+  REQUIRE(health.slot == 0);
+  REQUIRE(ammo.slot == 1);
+  REQUIRE(target.slot == 2);
+  REQUIRE(schema.keyCount() == 3);
+  REQUIRE(schema.storageSize() >= sizeof(float) + sizeof(int) + sizeof(Vector3));
+  REQUIRE(target.offset % alignof(Vector3) == 0);
+
+  SECTION("adding a key again returns the same slot") {
+    REQUIRE(schema.addKey<int>("ammo").slot == ammo.slot);
+    REQUIRE(schema.keyCount() == 3);
+  }
+
+  SECTION("keys are typed") {
+    REQUIRE_FALSE(schema.addKey<double>("ammo").isSet());
+    REQUIRE_FALSE(schema.key<double>("health").isSet());
+    REQUIRE_FALSE(schema.key<int>("shield").isSet());
+    REQUIRE(schema.key<float>("health").slot == health.slot);
+  }
+}
+
+TEST_CASE("Blackboard values and versions", "[blackboard]") {
+  BlackboardSchema schema;
+  const auto health = schema.addKey<float>("health");
+  const auto target = schema.addKey<Vector3>("target");
+
+  Blackboard blackboard(schema);
+  REQUIRE_FALSE(blackboard.has(health));
+  REQUIRE(blackboard.find(health) == nullptr);
+  REQUIRE(blackboard.get(health, 1.0f) == 1.0f);
+  REQUIRE(blackboard.version(health) == 0);
+
+  blackboard.set(health, 0.5f);
+  blackboard.set(target, Vector3{1.0f, 2.0f, 3.0f});
+  REQUIRE(blackboard.has(health));
+  REQUIRE(blackboard.get(health) == 0.5f);
+  REQUIRE(blackboard.get(target).y == 2.0f);
+
+  const auto seen = blackboard.version(health);
+  REQUIRE_FALSE(blackboard.changedSince(health, seen));
+  blackboard.set(health, 0.25f);
+  REQUIRE(blackboard.changedSince(health, seen));
+  REQUIRE_FALSE(blackboard.changedSince(target, blackboard.version(target)));
+
+  SECTION("erasing a value changes its version") {
+    const auto beforeErase = blackboard.version(health);
+    REQUIRE(blackboard.erase(health));
+    REQUIRE_FALSE(blackboard.erase(health));
+    REQUIRE_FALSE(blackboard.has(health));
+    REQUIRE(blackboard.changedSince(health, beforeErase));
+  }
+
+  SECTION("clearing removes all values") {
+    blackboard.clear();
+    REQUIRE_FALSE(blackboard.has(health));
+    REQUIRE_FALSE(blackboard.has(target));
+  }
+
+  SECTION("keys added to the schema later can be set") {
+    const auto ammo = schema.addKey<int>("ammo");
+    REQUIRE_FALSE(blackboard.has(ammo));
+    blackboard.set(ammo, 12);
+    REQUIRE(blackboard.get(ammo) == 12);
+    REQUIRE(blackboard.get(health) == 0.25f);
+  }
+}
+
+TEST_CASE("Blackboard hierarchical lookup", "[blackboard]") {
+  BlackboardSchema schema;
+  const auto alertLevel = schema.addKey<int>("alertLevel");
+  const auto rallyPoint = schema.addKey<Vector3>("rallyPoint");
+  const auto health = schema.addKey<float>("health");
+
+  Blackboard global(schema);
+  Blackboard squad(schema, &global);
+  Blackboard agent(schema, &squad);
+
+  global.set(alertLevel, 1);
+  squad.set(rallyPoint, Vector3{5.0f, 0.0f, 5.0f});
+  agent.set(health, 0.75f);
+
+  REQUIRE(agent.get(alertLevel) == 1);
+  REQUIRE(agent.get(rallyPoint).x == 5.0f);
+  REQUIRE(agent.get(health) == 0.75f);
+  REQUIRE(squad.find(health) == nullptr);
+  REQUIRE_FALSE(agent.has(alertLevel));
+
+  SECTION("closer blackboards override the parents") {
+    squad.set(alertLevel, 3);
+    REQUIRE(agent.get(alertLevel) == 3);
+    REQUIRE(global.get(alertLevel) == 1);
+
+    squad.erase(alertLevel);
+    REQUIRE(agent.get(alertLevel) == 1);
+  }
+
+  SECTION("parents can be changed") {
+    agent.setParent(&global);
+    REQUIRE(agent.parent() == &global);
+    REQUIRE(agent.find(rallyPoint) == nullptr);
+  }
+}
+
+class HealState : public aikit::fsm::State<Blackboard&> {
+ public:
+  explicit HealState(BlackboardKey<float> health) : mHealth(health) {}
+
+  void update(Blackboard& blackboard) override {
+    blackboard.set(mHealth, blackboard.get(mHealth) + 0.25f);
+  }
+
+ private:
+  BlackboardKey<float> mHealth;
+};
+
+// Leaves are plain functions, keys are resolved once when the schema is built
+BlackboardKey<int> ammoKey;
+BlackboardKey<bool> enemyVisibleKey;
+
+aikit::bt::Status attack(Blackboard& blackboard) {
+  blackboard.set(ammoKey, blackboard.get(ammoKey) - 1);
+  return aikit::bt::Status::Success;
+}
+
+bool hasAmmo(Blackboard& blackboard) {
+  return blackboard.get(ammoKey) > 0;
+}
+
+TEST_CASE("Blackboard as data of FSM states and behavior tree leaves", "[blackboard]") {
+  BlackboardSchema schema;
+  const auto health = schema.addKey<float>("health");
+  ammoKey = schema.addKey<int>("ammo");
+
+  Blackboard blackboard(schema);
+  blackboard.set(health, 0.25f);
+  blackboard.set(ammoKey, 1);
+
+  aikit::fsm::FSM<std::string, aikit::fsm::State<Blackboard&>> fsm;
+  fsm.addState("heal", HealState(health));
+  fsm.setCurrentState("heal");
+  fsm.update(blackboard);
+  REQUIRE(blackboard.get(health) == 0.5f);
+
+  const auto tree = aikit::bt::BehaviorTree<Blackboard>::Builder()
+      .sequence()
+        .condition(hasAmmo)
+        .action(attack)
+      .end()
+      .build();
+  std::vector<std::uint32_t> instance(tree.instanceSize());
+  REQUIRE(tree.tick(blackboard, instance) == aikit::bt::Status::Success);
+  REQUIRE(tree.tick(blackboard, instance) == aikit::bt::Status::Failure);
+  REQUIRE(blackboard.get(ammoKey) == 0);
+}
+
+TEST_CASE("Blackboard keys as conditions of behavior trees", "[blackboard]") {
+  BlackboardSchema schema;
+  enemyVisibleKey = schema.addKey<bool>("enemyVisible");
+  ammoKey = schema.addKey<int>("ammo");
+
+  Blackboard squad(schema);
+  Blackboard blackboard(schema, &squad);
+
+  const auto tree = aikit::bt::BehaviorTree<Blackboard>::Builder()
+      .sequence()
+        .condition(aikit::bt::isTrue<enemyVisibleKey>)
+        .condition(aikit::bt::hasValue<ammoKey>)
+      .end()
+      .build();
+  std::vector<std::uint32_t> instance(tree.instanceSize());
+  REQUIRE(tree.tick(blackboard, instance) == aikit::bt::Status::Failure);
+
+  squad.set(enemyVisibleKey, true);
+  REQUIRE(tree.tick(blackboard, instance) == aikit::bt::Status::Failure);
+
+  blackboard.set(ammoKey, 0);
+  REQUIRE(tree.tick(blackboard, instance) == aikit::bt::Status::Success);
+
+  blackboard.set(enemyVisibleKey, false);
+  REQUIRE(tree.tick(blackboard, instance) == aikit::bt::Status::Failure);
+}
+
+TEST_CASE("Blackboard keys as facts of GOAP world states", "[blackboard]") {
+  typedef aikit::goap::WorldState<8> WorldState;
+
+  BlackboardSchema schema;
+  const auto armed = schema.addKey<bool>("armed");
+  const auto enemyDead = schema.addKey<bool>("enemyDead");
+  const auto alarm = schema.addKey<bool>("alarm");
+
+  aikit::goap::BlackboardFacts<8> facts;
+  facts.bind(0, armed).bind(1, enemyDead).bind(5, alarm);
+  REQUIRE(facts.size() == 3);
+
+  Blackboard global(schema);
+  Blackboard blackboard(schema, &global);
+  global.set(alarm, true);
+  blackboard.set(armed, false);
+
+  SECTION("facts take the values of their keys, looked up on the parents") {
+    const WorldState state = facts.read(blackboard);
+    REQUIRE(state.count() == 2);
+    REQUIRE(state.isSet(0));
+    REQUIRE_FALSE(state.get(0));
+    REQUIRE_FALSE(state.isSet(1));
+    REQUIRE(state.get(5));
+    REQUIRE(state.satisfies(WorldState().set(5)));
+  }
+
+  SECTION("facts are written to their keys") {
+    const std::uint32_t alarmVersion = blackboard.version(alarm);
+    facts.write(WorldState().set(0).set(1).set(5), blackboard);
+
+    REQUIRE(blackboard.get(armed));
+    REQUIRE(blackboard.get(enemyDead));
+    REQUIRE(blackboard.get(alarm));
+    REQUIRE(blackboard.changedSince(alarm, alarmVersion));
+    REQUIRE(facts.read(blackboard).satisfies(WorldState().set(0).set(1).set(5)));
+
+    // Facts keeping their value do not change the versions of their keys
+    const std::uint32_t armedVersion = blackboard.version(armed);
+    facts.write(WorldState().set(0), blackboard);
+    REQUIRE_FALSE(blackboard.changedSince(armed, armedVersion));
+  }
+}
+
+}
@@ -0,0 +1,264 @@
+#include <cstdint>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/bt/EventDrivenExecutor.hpp>
+
+namespace {
+
+using aikit::bt::Abort;
+using aikit::bt::Status;
+
+struct TestAgent {
+  bool enemyVisible = false;
+  bool hurt = false;
+  Status moveStatus = Status::Running;
+  int conditionChecks = 0;
+  int attacks = 0;
+  int moves = 0;
+  int patrols = 0;
+};
+
+typedef aikit::bt::BehaviorTree<TestAgent> TestTree;
+typedef aikit::bt::EventDrivenExecutor<TestAgent> TestExecutor;
+
+bool isEnemyVisible(TestAgent& agent) {
+  ++agent.conditionChecks;
+  return agent.enemyVisible;
+}
+
+bool isHurt(TestAgent& agent) {
+  ++agent.conditionChecks;
+  return agent.hurt;
+}
+
+Status attack(TestAgent& agent) {
+  ++agent.attacks;
+  return Status::Success;
+}
+
+Status move(TestAgent& agent) {
+  ++agent.moves;
+  return agent.moveStatus;
+}
+
+Status patrol(TestAgent& agent) {
+  ++agent.patrols;
+  return Status::Running;
+}
+
+TEST_CASE("EventDrivenExecutor gives the same results as ticking the tree", "[behavior_tree]") {
+  const auto tree = TestTree::Builder()
+      .selector()
+        .sequence()
+          .condition(isEnemyVisible)
+          .repeat(2).action(attack).end()
+          .inverter().action(move).end()
+        .end()
+        .action(patrol)
+      .end()
+      .build();
+  const TestExecutor executor(tree);
+
+  TestAgent treeAgent;
+  TestAgent executorAgent;
+  std::vector<std::uint32_t> treeInstance(tree.instanceSize());
+  std::vector<std::uint32_t> executorInstance(executor.instanceSize());
+
+  for (int i = 0; i < 20; ++i) {
+    treeAgent.enemyVisible = executorAgent.enemyVisible = (i % 7) < 4;
+    treeAgent.moveStatus = executorAgent.moveStatus = (i % 3 == 0) ? Status::Failure : Status::Running;
+
+    REQUIRE(executor.tick(executorAgent, executorInstance) == tree.tick(treeAgent, treeInstance));
+    REQUIRE(executorAgent.attacks == treeAgent.attacks);
+    REQUIRE(executorAgent.moves == treeAgent.moves);
+    REQUIRE(executorAgent.patrols == treeAgent.patrols);
+  }
+}
+
+TEST_CASE("EventDrivenExecutor only ticks active nodes", "[behavior_tree]") {
+  const auto tree = TestTree::Builder()
+      .sequence()
+        .condition(isEnemyVisible)
+        .action(move)
+        .action(attack)
+      .end()
+      .build();
+  const TestExecutor executor(tree);
+
+  TestAgent agent;
+  agent.enemyVisible = true;
+  std::vector<std::uint32_t> instance(executor.instanceSize());
+
+  REQUIRE(executor.tick(agent, instance) == Status::Running);
+  REQUIRE(executor.activeCount(instance) == 1);
+  REQUIRE(executor.observerCount(instance) == 0);
+  REQUIRE(agent.conditionChecks == 1);
+
+  REQUIRE(executor.tick(agent, instance) == Status::Running);
+  REQUIRE(executor.tick(agent, instance) == Status::Running);
+  REQUIRE(agent.moves == 3);
+  REQUIRE(agent.conditionChecks == 1);
+
+  SECTION("finishing the running leaf continues with the next node") {
+    agent.moveStatus = Status::Success;
+    REQUIRE(executor.tick(agent, instance) == Status::Success);
+    REQUIRE(agent.attacks == 1);
+    REQUIRE(executor.activeCount(instance) == 0);
+  }
+
+  SECTION("reset aborts the running leaf") {
+    TestExecutor::resetInstance(instance);
+    agent.enemyVisible = false;
+    REQUIRE(executor.tick(agent, instance) == Status::Failure);
+    REQUIRE(agent.conditionChecks == 2);
+  }
+}
+
+TEST_CASE("EventDrivenExecutor observer aborts", "[behavior_tree]") {
+  TestAgent agent;
+
+  SECTION("self aborts stop the later siblings of the condition") {
+    const auto tree = TestTree::Builder()
+        .sequence()
+          .condition(isEnemyVisible, Abort::Self)
+          .action(move)
+        .end()
+        .build();
+    const TestExecutor executor(tree);
+    std::vector<std::uint32_t> instance(executor.instanceSize());
+
+    agent.enemyVisible = true;
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(executor.observerCount(instance) == 1);
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.moves == 2);
+
+    agent.enemyVisible = false;
+    REQUIRE(executor.tick(agent, instance) == Status::Failure);
+    REQUIRE(agent.moves == 2);
+    REQUIRE(executor.activeCount(instance) == 0);
+    REQUIRE(executor.observerCount(instance) == 0);
+  }
+
+  SECTION("lower priority aborts stop the lower priority children of the selector") {
+    const auto tree = TestTree::Builder()
+        .selector()
+          .sequence()
+            .condition(isEnemyVisible, Abort::LowerPriority)
+            .action(attack)
+          .end()
+          .action(patrol)
+        .end()
+        .build();
+    const TestExecutor executor(tree);
+    std::vector<std::uint32_t> instance(executor.instanceSize());
+
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.patrols == 2);
+    REQUIRE(executor.observerCount(instance) == 1);
+
+    agent.enemyVisible = true;
+    REQUIRE(executor.tick(agent, instance) == Status::Success);
+    REQUIRE(agent.attacks == 1);
+    REQUIRE(agent.patrols == 2);
+  }
+
+  SECTION("actions started by an abort are ticked once on that tick") {
+    const auto tree = TestTree::Builder()
+        .selector()
+          .sequence()
+            .condition(isEnemyVisible, Abort::LowerPriority)
+            .action(move)
+          .end()
+          .action(patrol)
+        .end()
+        .build();
+    const TestExecutor executor(tree);
+    std::vector<std::uint32_t> instance(executor.instanceSize());
+
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.patrols == 1);
+
+    agent.enemyVisible = true;
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.moves == 1);
+    REQUIRE(agent.patrols == 1);
+
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.moves == 2);
+  }
+
+  SECTION("without aborts the condition is not checked while running") {
+    const auto tree = TestTree::Builder()
+        .selector()
+          .sequence()
+            .condition(isEnemyVisible)
+            .action(attack)
+          .end()
+          .action(patrol)
+        .end()
+        .build();
+    const TestExecutor executor(tree);
+    std::vector<std::uint32_t> instance(executor.instanceSize());
+
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    agent.enemyVisible = true;
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.patrols == 2);
+    REQUIRE(agent.conditionChecks == 1);
+  }
+
+  SECTION("self aborts restart from the condition, keeping earlier observers") {
+    const auto tree = TestTree::Builder()
+        .sequence()
+          .condition(isHurt, Abort::Self)
+          .condition(isEnemyVisible, Abort::Self)
+          .action(move)
+        .end()
+        .build();
+    const TestExecutor executor(tree);
+    std::vector<std::uint32_t> instance(executor.instanceSize());
+
+    agent.hurt = true;
+    agent.enemyVisible = true;
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(executor.observerCount(instance) == 2);
+
+    // Changing and changing back between ticks does not abort
+    agent.enemyVisible = false;
+    agent.enemyVisible = true;
+    REQUIRE(executor.tick(agent, instance) == Status::Running);
+    REQUIRE(agent.moves == 2);
+
+    agent.hurt = false;
+    REQUIRE(executor.tick(agent, instance) == Status::Failure);
+    REQUIRE(agent.moves == 2);
+  }
+}
+
+TEST_CASE("EventDrivenExecutor parallels", "[behavior_tree]") {
+  const auto tree = TestTree::Builder()
+      .parallel(1)
+        .action(move)
+        .action(patrol)
+      .end()
+      .build();
+  const TestExecutor executor(tree);
+
+  TestAgent agent;
+  std::vector<std::uint32_t> instance(executor.instanceSize());
+
+  REQUIRE(executor.tick(agent, instance) == Status::Running);
+  REQUIRE(executor.activeCount(instance) == 2);
+
+  // The first child to succeed aborts the other
+  agent.moveStatus = Status::Success;
+  REQUIRE(executor.tick(agent, instance) == Status::Success);
+  REQUIRE(executor.activeCount(instance) == 0);
+  REQUIRE(agent.moves == 2);
+  REQUIRE(agent.patrols == 1);
+}
+
+}
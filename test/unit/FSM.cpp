@@ -1,4 +1,9 @@
 #include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <catch/catch.hpp>
 #include <cppaikit/fsm/FSM.hpp>
@@ -40,6 +45,91 @@ class TestState : public aikit::fsm::State<> {
   EventCounter* mCounter;
 };
 
+// Transitions its machine to "target" from inside update()
+class TransitioningState : public aikit::fsm::State<> {
+ public:
+  TransitioningState(aikit::fsm::FSM<>* fsm, EventCounter* counter) : mFsm(fsm), mCounter(counter) {}
+
+  void onExit() override {
+    // Must only happen after update() returns
+    REQUIRE_FALSE(mUpdating);
+    ++mCounter->timesExited;
+  }
+
+  void update(int /*updateData*/) override {
+    mUpdating = true;
+    REQUIRE(mFsm->transitionTo("target"));
+    REQUIRE(*mFsm->currentStateId() == "source");
+    ++mCounter->timesUpdated;
+    mUpdating = false;
+  }
+
+ private:
+  aikit::fsm::FSM<>* mFsm;
+  EventCounter* mCounter;
+  bool mUpdating = false;
+};
+
+// Fails its update with an exception
+class ThrowingState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override { throw std::runtime_error("update failed"); }
+};
+
+// Requests a transition to "target" and then fails its update with an exception
+class TransitioningThrowingState : public aikit::fsm::State<> {
+ public:
+  explicit TransitioningThrowingState(aikit::fsm::FSM<>* fsm) : mFsm(fsm) {}
+
+  void update(int /*updateData*/) override {
+    REQUIRE(mFsm->transitionTo("target"));
+    throw std::runtime_error("update failed");
+  }
+
+ private:
+  aikit::fsm::FSM<>* mFsm;
+};
+
+// Dispatches an event to its machine from inside update()
+class DispatchingState : public aikit::fsm::State<> {
+ public:
+  DispatchingState(aikit::fsm::FSM<>* fsm, aikit::fsm::EventHandle event, EventCounter* counter)
+      : mFsm(fsm), mEvent(event), mCounter(counter) {}
+
+  void onExit() override { ++mCounter->timesExited; }
+
+  void update(int /*updateData*/) override {
+    REQUIRE(mFsm->dispatch(mEvent));
+    REQUIRE(mCounter->timesExited == 0);
+  }
+
+ private:
+  aikit::fsm::FSM<>* mFsm;
+  aikit::fsm::EventHandle mEvent;
+  EventCounter* mCounter;
+};
+
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  int allocations = 0;
+  int deallocations = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
 TEST_CASE("FSM can have states added and removed", "[state_machine], [fsm]") {
   aikit::fsm::FSM<> fsm;
 
@@ -457,4 +547,472 @@ TEST_CASE("FSM can list states and it's ids") {
   }
 }
 
+
+TEST_CASE("FSM states can be referenced by handles", "[state_machine], [fsm]") {
+  aikit::fsm::FSM<> fsm;
+
+  EventCounter eventCounterS1;
+  EventCounter eventCounterS2;
+
+  const auto state1 = fsm.addState("state1", TestState(&eventCounterS1));
+  const auto state2 = fsm.addState("state2", TestState(&eventCounterS2));
+
+  REQUIRE(state1.isSet());
+  REQUIRE(state2.isSet());
+  REQUIRE(state1 != state2);
+  REQUIRE(fsm.hasState(state1));
+  REQUIRE(fsm.stateHandle("state1") == state1);
+  REQUIRE(fsm.getState(state1) == fsm.getState("state1"));
+
+  SECTION("adding state with existing id returns an unset handle") {
+    const auto duplicated = fsm.addState("state1", TestState());
+
+    REQUIRE_FALSE(duplicated.isSet());
+    REQUIRE_FALSE(fsm.hasState(duplicated));
+    REQUIRE_FALSE(fsm.stateHandle("stateInvalid").isSet());
+  }
+
+  SECTION("transitions can be made by handle") {
+    REQUIRE(fsm.transitionTo(state1));
+    REQUIRE(fsm.transitionTo(state2));
+
+    REQUIRE(fsm.currentStateHandle() == state2);
+    REQUIRE(fsm.previousStateHandle() == state1);
+    REQUIRE(*fsm.currentStateId() == "state2");
+    REQUIRE(eventCounterS1.timesEntered == 1);
+    REQUIRE(eventCounterS1.timesExited == 1);
+    REQUIRE(eventCounterS2.timesEntered == 1);
+
+    REQUIRE(fsm.transitionToPreviousState());
+    REQUIRE(fsm.currentStateHandle() == state1);
+  }
+
+  SECTION("current state can be set by handle") {
+    REQUIRE(fsm.setCurrentState(state1));
+
+    REQUIRE(fsm.currentStateHandle() == state1);
+    REQUIRE_FALSE(fsm.previousStateHandle().isSet());
+    REQUIRE(eventCounterS1.timesEntered == 0);
+  }
+
+  SECTION("removed states invalidate their handles") {
+    fsm.transitionTo(state1);
+    fsm.transitionTo(state2);
+
+    REQUIRE(fsm.removeState(state1));
+    REQUIRE_FALSE(fsm.removeState(state1));
+    REQUIRE_FALSE(fsm.hasState(state1));
+    REQUIRE_FALSE(fsm.hasState("state1"));
+    REQUIRE(fsm.getState(state1) == nullptr);
+    REQUIRE_FALSE(fsm.transitionTo(state1));
+    REQUIRE_FALSE(fsm.setCurrentState(state1));
+    REQUIRE_FALSE(fsm.hasPreviousState());
+
+    SECTION("even when the slot of the removed state is reused") {
+      const auto state3 = fsm.addState("state3", TestState());
+
+      REQUIRE(state3.index == state1.index);
+      REQUIRE(state3 != state1);
+      REQUIRE(fsm.hasState(state3));
+      REQUIRE_FALSE(fsm.hasState(state1));
+    }
+  }
+
+  SECTION("removing by handle follows the same rules as removing by id") {
+    fsm.transitionTo(state1);
+    fsm.transitionTo(state2);
+
+    REQUIRE(fsm.removeState(state2));
+    REQUIRE(fsm.currentStateHandle() == state1);
+    REQUIRE(fsm.previousStateHandle() == state1);
+    REQUIRE(eventCounterS2.timesExited == 1);
+  }
+}
+
+
+TEST_CASE("FSM allocates from its memory resource", "[state_machine], [fsm]") {
+  SECTION("all memory is returned to the resource") {
+    CountingResource resource;
+    {
+      aikit::fsm::FSM<> fsm(&resource);
+      REQUIRE(fsm.resource() == &resource);
+
+      fsm.addState("state1", TestState());
+      fsm.addState("state2", TestState());
+      fsm.addState("state3", TestState());
+      fsm.removeState("state2");
+
+      REQUIRE(resource.allocations > 0);
+    }
+
+    REQUIRE(resource.allocations == resource.deallocations);
+  }
+
+  SECTION("a machine can be built on a single block of memory") {
+    alignas(std::max_align_t) std::array<std::byte, 4096> buffer{};
+    // Any allocation not fitting on the buffer would reach the null resource and throw
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    aikit::fsm::FSM<int, aikit::fsm::State<>, aikit::fsm::storage::FlatMap> fsm(&arena);
+    fsm.reserve(20);
+
+    for (int i = 0; i < 20; ++i) {
+      REQUIRE(fsm.addState(i, TestState()).isSet());
+    }
+
+    REQUIRE(fsm.size() == 20);
+    REQUIRE(fsm.transitionTo(10));
+    REQUIRE(fsm.removeState(10));
+    REQUIRE_FALSE(fsm.hasCurrentState());
+  }
+
+  SECTION("allocator aware ids take their memory from the resource") {
+    CountingResource resource;
+    aikit::fsm::FSM<std::pmr::string> fsm(&resource);
+
+    fsm.addState(std::pmr::string("a state id long enough to not fit on small string buffer"), TestState());
+    const int allocationsAfterAdd = resource.allocations;
+
+    // Node, slots, index node and the id, which the index does not copy
+    REQUIRE(allocationsAfterAdd == 4);
+    REQUIRE(fsm.hasState(std::pmr::string("a state id long enough to not fit on small string buffer")));
+  }
+
+  SECTION("move assigned machines take the resource of the machine moved") {
+    CountingResource source;
+    CountingResource target;
+    {
+      aikit::fsm::FSM<> moved(&source);
+      moved.addState("idle", TestState());
+      moved.setCurrentState("idle");
+      aikit::fsm::FSM<> fsm(&target);
+      fsm.addState("patrol", TestState());
+
+      const int sourceAllocations = source.allocations;
+      fsm = std::move(moved);
+
+      // The memory of the target was returned to its resource, the memory of the source was taken as is
+      REQUIRE(target.allocations == target.deallocations);
+      REQUIRE(source.allocations == sourceAllocations);
+      REQUIRE(*fsm.currentStateId() == "idle");
+      REQUIRE_FALSE(fsm.hasState("patrol"));
+
+      fsm.addState("patrol", TestState());
+      REQUIRE(source.allocations > sourceAllocations);
+      REQUIRE(target.deallocations == target.allocations);
+    }
+
+    REQUIRE(source.allocations == source.deallocations);
+  }
+}
+
+
+TEST_CASE("FSM transitions can be deferred", "[state_machine], [fsm]") {
+  aikit::fsm::FSM<> fsm;
+
+  EventCounter sourceCounter;
+  EventCounter targetCounter;
+  EventCounter otherCounter;
+
+  const auto source = fsm.addState("source", TransitioningState(&fsm, &sourceCounter));
+  const auto target = fsm.addState("target", TestState(&targetCounter));
+  const auto other = fsm.addState("other", TestState(&otherCounter));
+
+  SECTION("transitions made from inside update() happen after the state is updated") {
+    fsm.setCurrentState(source);
+    fsm.update(1);
+
+    REQUIRE(fsm.currentStateHandle() == target);
+    REQUIRE(fsm.previousStateHandle() == source);
+    REQUIRE(sourceCounter.timesUpdated == 1);
+    REQUIRE(sourceCounter.timesExited == 1);
+    REQUIRE(targetCounter.timesEntered == 1);
+    REQUIRE_FALSE(fsm.hasPendingTransitions());
+  }
+
+  SECTION("updating only the current state keeps transitions pending") {
+    fsm.setCurrentState(source);
+    fsm.updateCurrentState(1);
+
+    REQUIRE(fsm.currentStateHandle() == source);
+    REQUIRE(fsm.hasPendingTransitions());
+
+    fsm.commitTransitions();
+
+    REQUIRE(fsm.currentStateHandle() == target);
+    REQUIRE_FALSE(fsm.hasPendingTransitions());
+  }
+
+  SECTION("requested transitions are committed in order") {
+    REQUIRE(fsm.requestTransition("other"));
+    REQUIRE(fsm.requestTransition(target));
+    REQUIRE_FALSE(fsm.requestTransition("invalid"));
+    REQUIRE_FALSE(fsm.hasCurrentState());
+
+    fsm.commitTransitions();
+
+    REQUIRE(fsm.currentStateHandle() == target);
+    REQUIRE(fsm.previousStateHandle() == other);
+    REQUIRE(otherCounter.timesEntered == 1);
+    REQUIRE(otherCounter.timesExited == 1);
+    REQUIRE(targetCounter.timesEntered == 1);
+  }
+
+  SECTION("transitions are not deferred after an update throws") {
+    const auto throwing = fsm.addState("throwing", ThrowingState());
+    fsm.setCurrentState(throwing);
+    REQUIRE_THROWS_AS(fsm.update(1), std::runtime_error);
+
+    REQUIRE(fsm.transitionTo(target));
+    REQUIRE(fsm.currentStateHandle() == target);
+    REQUIRE_FALSE(fsm.hasPendingTransitions());
+  }
+
+  SECTION("transitions requested by an update that throws are dropped") {
+    const auto throwing = fsm.addState("throwing", TransitioningThrowingState(&fsm));
+    fsm.setCurrentState(throwing);
+    REQUIRE_THROWS_AS(fsm.updateCurrentState(1), std::runtime_error);
+    REQUIRE_FALSE(fsm.hasPendingTransitions());
+
+    fsm.commitTransitions();
+    REQUIRE(fsm.currentStateHandle() == throwing);
+    REQUIRE(targetCounter.timesEntered == 0);
+  }
+
+  SECTION("requests to states removed before the commit are ignored") {
+    fsm.setCurrentState(target);
+    REQUIRE(fsm.requestTransition(other));
+    fsm.removeState(other);
+
+    fsm.commitTransitions();
+
+    REQUIRE(fsm.currentStateHandle() == target);
+    REQUIRE(otherCounter.timesEntered == 0);
+  }
+}
+
+
+TEST_CASE("FSM takes transitions from its transition table", "[state_machine], [fsm]") {
+  aikit::fsm::FSM<> fsm;
+
+  EventCounter idleCounter;
+  EventCounter walkCounter;
+  EventCounter runCounter;
+
+  const auto idle = fsm.addState("idle", TestState(&idleCounter));
+  const auto walk = fsm.addState("walk", TestState(&walkCounter));
+  const auto run = fsm.addState("run", TestState(&runCounter));
+
+  const auto move = fsm.addEvent();
+  const auto stop = fsm.addEvent();
+
+  REQUIRE(fsm.eventCount() == 2);
+  REQUIRE(fsm.hasEvent(stop));
+  REQUIRE_FALSE(fsm.hasEvent(aikit::fsm::EventHandle{}));
+
+  REQUIRE(fsm.addTransition(idle, move, walk));
+  REQUIRE(fsm.addTransition("walk", stop, "idle"));
+  REQUIRE_FALSE(fsm.addTransition("walk", stop, "invalid"));
+  REQUIRE_FALSE(fsm.addTransition(idle, aikit::fsm::EventHandle{}, walk));
+
+  REQUIRE(fsm.transitionTarget(idle, move) == walk);
+  REQUIRE_FALSE(fsm.transitionTarget(idle, stop).isSet());
+
+  fsm.setCurrentState(idle);
+
+  SECTION("dispatch takes the declared transition") {
+    REQUIRE_FALSE(fsm.dispatch(stop));
+    REQUIRE(fsm.currentStateHandle() == idle);
+
+    REQUIRE(fsm.dispatch(move));
+    REQUIRE(fsm.currentStateHandle() == walk);
+    REQUIRE(fsm.previousStateHandle() == idle);
+    REQUIRE(idleCounter.timesExited == 1);
+    REQUIRE(walkCounter.timesEntered == 1);
+
+    REQUIRE(fsm.dispatch(stop));
+    REQUIRE(fsm.currentStateHandle() == idle);
+  }
+
+  SECTION("guards block transitions and actions run between exit and enter") {
+    bool allowed = false;
+    std::vector<int> order;
+
+    REQUIRE(fsm.addTransition(
+        idle, move, run, [&] { return allowed; },
+        [&] { order.emplace_back(idleCounter.timesExited * 10 + runCounter.timesEntered); }));
+
+    REQUIRE_FALSE(fsm.dispatch(move));
+    REQUIRE(fsm.currentStateHandle() == idle);
+    REQUIRE(order.empty());
+
+    allowed = true;
+    REQUIRE(fsm.dispatch(move));
+    REQUIRE(fsm.currentStateHandle() == run);
+    REQUIRE(order == std::vector<int>{10});
+    REQUIRE(runCounter.timesEntered == 1);
+  }
+
+  SECTION("transitions are removed with their states") {
+    REQUIRE(fsm.removeState(walk));
+    REQUIRE_FALSE(fsm.transitionTarget(idle, move).isSet());
+    REQUIRE_FALSE(fsm.dispatch(move));
+
+    // The slot of "walk" is reused without its transitions
+    const auto jump = fsm.addState("jump", TestState());
+    REQUIRE(jump.index == walk.index);
+    REQUIRE_FALSE(fsm.transitionTarget(jump, stop).isSet());
+  }
+
+  SECTION("transitions can be removed") {
+    REQUIRE(fsm.removeTransition(idle, move));
+    REQUIRE_FALSE(fsm.removeTransition(idle, move));
+    REQUIRE_FALSE(fsm.dispatch(move));
+  }
+
+  SECTION("events added later keep the declared transitions") {
+    const auto jump = fsm.addEvent();
+    REQUIRE(fsm.addTransition(walk, jump, run));
+
+    REQUIRE(fsm.transitionTarget(idle, move) == walk);
+    REQUIRE(fsm.transitionTarget(walk, stop) == idle);
+    REQUIRE(fsm.transitionTarget(walk, jump) == run);
+  }
+}
+
+TEST_CASE("FSM events dispatched while updating are committed after the update", "[state_machine], [fsm]") {
+  aikit::fsm::FSM<> fsm;
+  EventCounter sourceCounter;
+  EventCounter targetCounter;
+
+  const auto event = fsm.addEvent();
+  const auto source = fsm.addState("source", DispatchingState(&fsm, event, &sourceCounter));
+  const auto target = fsm.addState("target", TestState(&targetCounter));
+  fsm.addTransition(source, event, target);
+  fsm.setCurrentState(source);
+
+  fsm.updateCurrentState(1);
+
+  REQUIRE(fsm.currentStateHandle() == source);
+  REQUIRE(fsm.hasPendingTransitions());
+
+  fsm.commitTransitions();
+
+  REQUIRE(fsm.currentStateHandle() == target);
+  REQUIRE(sourceCounter.timesExited == 1);
+  REQUIRE(targetCounter.timesEntered == 1);
+}
+
+
+TEST_CASE("FSM dispatches events posted to its inbox on update", "[state_machine], [fsm]") {
+  aikit::fsm::FSM<> fsm;
+  EventCounter idleCounter;
+  EventCounter walkCounter;
+
+  const auto idle = fsm.addState("idle", TestState(&idleCounter));
+  const auto walk = fsm.addState("walk", TestState(&walkCounter));
+  const auto move = fsm.addEvent();
+  const auto stop = fsm.addEvent();
+  fsm.addTransition(idle, move, walk);
+  fsm.addTransition(walk, stop, idle);
+  fsm.setCurrentState(idle);
+
+  REQUIRE_FALSE(fsm.hasInbox());
+  REQUIRE_FALSE(fsm.postEvent(move));
+
+  fsm.enableInbox(2);
+  REQUIRE(fsm.hasInbox());
+  REQUIRE_FALSE(fsm.postEvent(aikit::fsm::EventHandle{}));
+
+  SECTION("events are dispatched in order before the current state is updated") {
+    REQUIRE(fsm.postEvent(move));
+    REQUIRE(fsm.postEvent(stop));
+    REQUIRE_FALSE(fsm.postEvent(move));
+    REQUIRE(fsm.currentStateHandle() == idle);
+
+    fsm.update(1);
+
+    REQUIRE(fsm.currentStateHandle() == idle);
+    REQUIRE(walkCounter.timesEntered == 1);
+    REQUIRE(walkCounter.timesUpdated == 0);
+    REQUIRE(idleCounter.timesUpdated == 1);
+    REQUIRE(fsm.dispatchInbox() == 0);
+  }
+
+  SECTION("events can be posted from other threads") {
+    std::thread producer([&] {
+      while (!fsm.postEvent(move)) {
+        std::this_thread::yield();
+      }
+    });
+    producer.join();
+
+    REQUIRE(fsm.dispatchInbox() == 1);
+    REQUIRE(fsm.currentStateHandle() == walk);
+  }
+}
+
+
+TEST_CASE("FSM keeps a bounded history of transitions", "[state_machine], [fsm]") {
+  aikit::fsm::FSM<> fsm;
+
+  const auto idle = fsm.addState("idle", TestState());
+  const auto walk = fsm.addState("walk", TestState());
+  const auto run = fsm.addState("run", TestState());
+  const auto faster = fsm.addEvent();
+  fsm.addTransition(walk, faster, run);
+
+  REQUIRE(fsm.historySize() == 0);
+  REQUIRE(fsm.historyEntry(0) == nullptr);
+  REQUIRE_FALSE(fsm.transitionBack());
+
+  fsm.enableHistory(3);
+  fsm.setCurrentState(idle);
+  fsm.update(1);
+  fsm.transitionTo(walk);
+  fsm.update(1);
+  fsm.dispatch(faster);
+
+  REQUIRE(fsm.tick() == 2);
+  REQUIRE(fsm.historySize() == 3);
+
+  const auto* last = fsm.historyEntry(0);
+  REQUIRE(last->from == walk);
+  REQUIRE(last->to == run);
+  REQUIRE(last->event == faster);
+  REQUIRE(last->tick == 2);
+
+  const auto* first = fsm.historyEntry(2);
+  REQUIRE_FALSE(first->from.isSet());
+  REQUIRE(first->to == idle);
+  REQUIRE_FALSE(first->event.isSet());
+  REQUIRE(first->tick == 0);
+
+  SECTION("transitions go back any number of changes") {
+    REQUIRE_FALSE(fsm.transitionBack(0));
+    REQUIRE_FALSE(fsm.transitionBack(3));
+    REQUIRE(fsm.transitionBack(2));
+    REQUIRE(fsm.currentStateHandle() == idle);
+
+    // Going back is recorded as well
+    REQUIRE(fsm.historyEntry(0)->from == run);
+    REQUIRE(fsm.transitionBack());
+    REQUIRE(fsm.currentStateHandle() == run);
+  }
+
+  SECTION("the oldest entries are overwritten") {
+    fsm.transitionTo(idle);
+
+    REQUIRE(fsm.historySize() == 3);
+    REQUIRE(fsm.historyEntry(2)->to == walk);
+    REQUIRE(fsm.historyEntry(3) == nullptr);
+  }
+
+  SECTION("removed states are not transitioned back to") {
+    fsm.removeState(walk);
+    REQUIRE_FALSE(fsm.transitionBack(1));
+    REQUIRE(fsm.transitionBack(2));
+  }
+}
+
 }
@@ -0,0 +1,203 @@
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/FSMPool.hpp>
+
+namespace {
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  void onEnter() override { ++timesEntered; }
+  void onExit() override { ++timesExited; }
+  void update(int updateData) override {
+    ++timesUpdated;
+    accumulatedUpdates += updateData;
+  }
+
+  int timesEntered = 0;
+  int timesExited = 0;
+  int timesUpdated = 0;
+  int accumulatedUpdates = 0;
+};
+
+// Transitions every agent of the pool to "target" when updated
+class TransitionAllState : public aikit::fsm::State<> {
+ public:
+  explicit TransitionAllState(aikit::fsm::FSMPool<>* pool = nullptr) : mPool(pool) {}
+
+  void update(int /*updateData*/) override {
+    ++timesUpdated;
+    for (aikit::fsm::FSMPool<>::AgentId agent = 0; agent < mPool->agentCount(); ++agent) {
+      mPool->transitionTo(agent, "target");
+    }
+  }
+
+  int timesUpdated = 0;
+
+ private:
+  aikit::fsm::FSMPool<>* mPool;
+};
+
+// Provides its own batched update, recording each batch it receives
+class BatchedState : public aikit::fsm::State<> {
+ public:
+  static void updateBatch(aikit::fsm::StateBatch<BatchedState> batch, int updateData) {
+    ++timesBatched;
+    lastBatch.assign(batch.agents.begin(), batch.agents.end());
+    for (const auto agent : batch.agents) {
+      batch.states[agent].value += updateData;
+    }
+  }
+
+  void update(int /*updateData*/) override {
+    FAIL("update() must not be called when the state has a batched update");
+  }
+
+  int value = 0;
+
+  static int timesBatched;
+  static std::vector<std::uint32_t> lastBatch;
+};
+
+int BatchedState::timesBatched = 0;
+std::vector<std::uint32_t> BatchedState::lastBatch;
+
+TEST_CASE("FSMPool keeps a copy of every state per agent", "[state_machine], [fsm_pool]") {
+  aikit::fsm::FSMPool<> pool;
+
+  const auto idle = pool.addState("idle", TestState());
+  const auto agent0 = pool.addAgent();
+  const auto agent1 = pool.addAgent();
+  const auto walk = pool.addState("walk", TestState());
+
+  REQUIRE(pool.size() == 2);
+  REQUIRE(pool.agentCount() == 2);
+  REQUIRE(pool.hasState("idle"));
+  REQUIRE(pool.hasState(walk));
+  REQUIRE(pool.stateHandle("walk") == walk);
+  REQUIRE_FALSE(pool.addState("idle", TestState()).isSet());
+  REQUIRE_FALSE(pool.stateHandle("invalid").isSet());
+
+  SECTION("states added after agents are also copied to them") {
+    REQUIRE(pool.getState(agent0, walk) != nullptr);
+    REQUIRE(pool.getState(agent1, walk) != nullptr);
+    REQUIRE(pool.getState(agent0, walk) != pool.getState(agent1, walk));
+  }
+
+  SECTION("agents start without current state") {
+    REQUIRE_FALSE(pool.hasCurrentState(agent0));
+    REQUIRE_FALSE(pool.hasPreviousState(agent0));
+    REQUIRE(pool.currentState(agent0) == nullptr);
+    REQUIRE_FALSE(pool.currentStateHandle(agent0).isSet());
+  }
+
+  SECTION("agents transition independently") {
+    REQUIRE(pool.transitionTo(agent0, idle));
+    REQUIRE(pool.transitionTo(agent0, "walk"));
+    REQUIRE(pool.setCurrentState(agent1, walk));
+
+    REQUIRE(pool.currentStateHandle(agent0) == walk);
+    REQUIRE(pool.previousStateHandle(agent0) == idle);
+    REQUIRE(pool.currentStateHandle(agent1) == walk);
+    REQUIRE_FALSE(pool.hasPreviousState(agent1));
+
+    const auto* agent0Idle = static_cast<const TestState*>(pool.getState(agent0, idle));
+    const auto* agent0Walk = static_cast<const TestState*>(pool.getState(agent0, walk));
+    const auto* agent1Walk = static_cast<const TestState*>(pool.getState(agent1, walk));
+    REQUIRE(agent0Idle->timesEntered == 1);
+    REQUIRE(agent0Idle->timesExited == 1);
+    REQUIRE(agent0Walk->timesEntered == 1);
+    REQUIRE(agent1Walk->timesEntered == 0);
+
+    REQUIRE(pool.transitionToPreviousState(agent0));
+    REQUIRE(pool.currentStateHandle(agent0) == idle);
+    REQUIRE_FALSE(pool.transitionToPreviousState(agent1));
+    REQUIRE_FALSE(pool.transitionTo(agent1, "invalid"));
+  }
+}
+
+TEST_CASE("FSMPool updates all agents grouped by state", "[state_machine], [fsm_pool]") {
+  aikit::fsm::FSMPool<> pool;
+
+  const auto idle = pool.addState("idle", TestState());
+  const auto walk = pool.addState("walk", TestState());
+  pool.reserveAgents(5);
+  for (int i = 0; i < 5; ++i) {
+    pool.addAgent();
+  }
+
+  pool.setCurrentState(0, walk);
+  pool.setCurrentState(1, idle);
+  pool.setCurrentState(2, walk);
+  pool.setCurrentState(3, idle);
+  // Agent 4 has no current state
+
+  pool.updateAll(3);
+  pool.updateAll(2);
+
+  for (aikit::fsm::FSMPool<>::AgentId agent = 0; agent < 5; ++agent) {
+    const auto* idleState = static_cast<const TestState*>(pool.getState(agent, idle));
+    const auto* walkState = static_cast<const TestState*>(pool.getState(agent, walk));
+    const bool isWalking = (agent == 0 || agent == 2);
+    const bool isIdle = (agent == 1 || agent == 3);
+
+    REQUIRE(walkState->timesUpdated == (isWalking ? 2 : 0));
+    REQUIRE(walkState->accumulatedUpdates == (isWalking ? 5 : 0));
+    REQUIRE(idleState->timesUpdated == (isIdle ? 2 : 0));
+  }
+
+  SECTION("a single agent can be updated") {
+    pool.update(1, 10);
+
+    REQUIRE(static_cast<const TestState*>(pool.getState(1, idle))->accumulatedUpdates == 15);
+    REQUIRE(static_cast<const TestState*>(pool.getState(3, idle))->accumulatedUpdates == 5);
+  }
+}
+
+TEST_CASE("FSMPool allows transitions while updating all agents", "[state_machine], [fsm_pool]") {
+  aikit::fsm::FSMPool<> pool;
+
+  const auto source = pool.addState("source", TransitionAllState(&pool));
+  const auto target = pool.addState("target", TestState());
+  const auto other = pool.addState("other", TestState());
+  pool.addAgent();
+  pool.addAgent();
+  pool.setCurrentState(0, source);
+  pool.setCurrentState(1, other);
+
+  pool.updateAll(1);
+
+  // Agent 1 left "other" before its batch was updated, it is not updated on this call
+  REQUIRE(pool.currentStateHandle(0) == target);
+  REQUIRE(pool.currentStateHandle(1) == target);
+  REQUIRE(static_cast<const TransitionAllState*>(pool.getState(0, source))->timesUpdated == 1);
+  REQUIRE(static_cast<const TestState*>(pool.getState(1, other))->timesUpdated == 0);
+  REQUIRE(static_cast<const TestState*>(pool.getState(0, target))->timesUpdated == 0);
+
+  pool.updateAll(1);
+
+  REQUIRE(static_cast<const TestState*>(pool.getState(0, target))->timesUpdated == 1);
+  REQUIRE(static_cast<const TestState*>(pool.getState(1, target))->timesUpdated == 1);
+}
+
+
+TEST_CASE("FSMPool updates states with batched updates once per state", "[state_machine], [fsm_pool]") {
+  aikit::fsm::FSMPool<> pool;
+  BatchedState::timesBatched = 0;
+
+  const auto batched = pool.addState("batched", BatchedState());
+  const auto idle = pool.addState("idle", TestState());
+  for (int i = 0; i < 6; ++i) {
+    pool.setCurrentState(pool.addAgent(), (i % 3 == 0) ? idle : batched);
+  }
+
+  pool.updateAll(4);
+
+  REQUIRE(BatchedState::timesBatched == 1);
+  REQUIRE(BatchedState::lastBatch == std::vector<std::uint32_t>{1, 2, 4, 5});
+  REQUIRE(static_cast<const BatchedState*>(pool.getState(1, batched))->value == 4);
+  REQUIRE(static_cast<const BatchedState*>(pool.getState(0, batched))->value == 0);
+  REQUIRE(static_cast<const TestState*>(pool.getState(3, idle))->timesUpdated == 1);
+}
+
+}
@@ -0,0 +1,157 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/WorkStealingPool.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/FSMScheduler.hpp>
+
+namespace {
+
+class CountingState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override {
+    ++timesUpdated;
+    accumulatedUpdates += updateData;
+  }
+
+  int timesUpdated = 0;
+  int accumulatedUpdates = 0;
+};
+
+TEST_CASE("WorkStealingPool runs every element of a loop exactly once", "[concurrency]") {
+  for (const std::size_t threadCount : {std::size_t{1}, std::size_t{2}, std::size_t{4}}) {
+    aikit::WorkStealingPool pool(threadCount);
+    REQUIRE(pool.threadCount() == threadCount);
+
+    for (const std::size_t chunkSize : {std::size_t{1}, std::size_t{7}, std::size_t{1000}}) {
+      std::vector<std::atomic<int>> visits(1001);
+
+      pool.parallelFor(visits.size(), chunkSize, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          ++visits[i];
+        }
+      });
+
+      for (const auto& visit : visits) {
+        REQUIRE(visit == 1);
+      }
+    }
+
+    // Empty loops do nothing
+    pool.parallelFor(0, 8, [](std::size_t, std::size_t) { FAIL("empty loop must not run"); });
+  }
+}
+
+TEST_CASE("WorkStealingPool rethrows exceptions of loops on the calling thread", "[concurrency]") {
+  for (const std::size_t threadCount : {std::size_t{1}, std::size_t{4}}) {
+    aikit::WorkStealingPool pool(threadCount);
+
+    // Every chunk throws, so both the calling thread and the workers throw
+    REQUIRE_THROWS_AS(pool.parallelFor(1000, 1, [](std::size_t, std::size_t) { throw std::runtime_error("chunk"); }),
+                      std::runtime_error);
+
+    // Only the chunk of element 500 throws, the other threads stop taking chunks
+    std::atomic<int> chunks{0};
+    REQUIRE_THROWS_WITH(pool.parallelFor(1000, 1,
+                                         [&](std::size_t begin, std::size_t end) {
+                                           ++chunks;
+                                           if (begin <= 500 && 500 < end) {
+                                             throw std::runtime_error("chunk 500");
+                                           }
+                                         }),
+                        "chunk 500");
+    REQUIRE(chunks > 0);
+
+    // The pool keeps working after a loop threw
+    std::vector<std::atomic<int>> visits(100);
+    pool.parallelFor(visits.size(), 3, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        ++visits[i];
+      }
+    });
+    for (const auto& visit : visits) {
+      REQUIRE(visit == 1);
+    }
+  }
+}
+
+TEST_CASE("FSMScheduler updates every machine once per tick", "[state_machine], [fsm_scheduler]") {
+  typedef aikit::fsm::FSM<> TestFSM;
+
+  std::vector<TestFSM> machines(500);
+  std::vector<TestFSM*> machinePointers;
+  for (auto& machine : machines) {
+    machine.addState("state", CountingState());
+    machine.setCurrentState("state");
+    machinePointers.emplace_back(&machine);
+  }
+  // Machines without current state are also handled
+  machines[42].removeState("state");
+
+  aikit::fsm::FSMScheduler<TestFSM> scheduler(4, 16);
+  REQUIRE(scheduler.threadCount() == 4);
+  REQUIRE(scheduler.chunkSize() == 16);
+
+  scheduler.update(machines, 2);
+  scheduler.setChunkSize(3);
+  scheduler.update(machinePointers, 3);
+
+  for (std::size_t i = 0; i < machines.size(); ++i) {
+    const auto* state = static_cast<const CountingState*>(machines[i].currentState());
+    if (i == 42) {
+      REQUIRE(state == nullptr);
+    } else {
+      REQUIRE(state->timesUpdated == 2);
+      REQUIRE(state->accumulatedUpdates == 5);
+    }
+  }
+}
+
+
+TEST_CASE("FSMScheduler commits transitions serially in machine order", "[state_machine], [fsm_scheduler]") {
+  typedef aikit::fsm::FSM<> TestFSM;
+
+  std::vector<int> enterOrder;
+
+  // Requests a transition to "next" on every update
+  class RequestingState : public aikit::fsm::State<> {
+   public:
+    explicit RequestingState(TestFSM* fsm) : mFsm(fsm) {}
+    void update(int /*updateData*/) override { mFsm->transitionTo("next"); }
+
+   private:
+    TestFSM* mFsm;
+  };
+
+  // Records the order machines enter it
+  class RecordingState : public aikit::fsm::State<> {
+   public:
+    RecordingState(std::vector<int>* order, int machine) : mOrder(order), mMachine(machine) {}
+    void onEnter() override { mOrder->emplace_back(mMachine); }
+    void update(int /*updateData*/) override {}
+
+   private:
+    std::vector<int>* mOrder;
+    int mMachine;
+  };
+
+  std::vector<TestFSM> machines(200);
+  for (int i = 0; i < static_cast<int>(machines.size()); ++i) {
+    auto& machine = machines[static_cast<std::size_t>(i)];
+    machine.addState("start", RequestingState(&machine));
+    machine.addState("next", RecordingState(&enterOrder, i));
+    machine.setCurrentState("start");
+  }
+
+  aikit::fsm::FSMScheduler<TestFSM> scheduler(4, 1);
+  scheduler.update(machines, 0);
+
+  REQUIRE(enterOrder.size() == machines.size());
+  for (std::size_t i = 0; i < enterOrder.size(); ++i) {
+    REQUIRE(enterOrder[i] == static_cast<int>(i));
+  }
+}
+
+}
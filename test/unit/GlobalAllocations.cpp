@@ -0,0 +1,51 @@
+// Kept apart from the tests, as bench/Main.cpp does, so the compiler does not inline these into container code
+#include <cstdlib>
+#include <new>
+
+#include "GlobalAllocations.hpp"
+
+// Count every allocation of the program, including those not made on a memory resource
+void* operator new(std::size_t size) {
+  aikit::test::globalAllocationCount().fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc((size > 0) ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+// Catch allocates with the nothrow overloads, replaced too so every allocation is freed by the matching function
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  aikit::test::globalAllocationCount().fetch_add(1, std::memory_order_relaxed);
+  return std::malloc((size > 0) ? size : 1);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  aikit::test::globalAllocationCount().fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc needs a non zero size multiple of the alignment
+  const auto align = static_cast<std::size_t>(alignment);
+  const std::size_t rounded = (((size > 0) ? size : 1) + align - 1) / align * align;
+  if (void* memory = std::aligned_alloc(align, rounded)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace aikit::test {
+
+/**
+ * Number of calls to the global operator new since the start of the program, counted by the replacement in
+ * GlobalAllocations.cpp.
+ */
+inline std::atomic<std::uint64_t>& globalAllocationCount() {
+  static std::atomic<std::uint64_t> count{0};
+  return count;
+}
+
+}
@@ -0,0 +1,220 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/HFSM.hpp>
+
+namespace {
+
+typedef std::vector<std::string> EventLog;
+
+// Logs every call it receives as "<call>:<name>"
+class LoggingState : public aikit::fsm::State<> {
+ public:
+  LoggingState(EventLog* log, std::string name) : mLog(log), mName(std::move(name)) {}
+
+  void onEnter() override { mLog->emplace_back("enter:" + mName); }
+  void onExit() override { mLog->emplace_back("exit:" + mName); }
+  void update(int /*updateData*/) override { mLog->emplace_back("update:" + mName); }
+
+ protected:
+  EventLog* mLog;
+  std::string mName;
+};
+
+// Transitions its machine to "dead" when updated
+class DyingState : public LoggingState {
+ public:
+  DyingState(aikit::fsm::HFSM<>* hfsm, EventLog* log, std::string name)
+      : LoggingState(log, std::move(name)), mHfsm(hfsm) {}
+
+  void update(int updateData) override {
+    LoggingState::update(updateData);
+    mHfsm->transitionTo("dead");
+  }
+
+ private:
+  aikit::fsm::HFSM<>* mHfsm;
+};
+
+// Fails its first update with an exception
+class ThrowingOnceState : public LoggingState {
+ public:
+  using LoggingState::LoggingState;
+
+  void update(int updateData) override {
+    LoggingState::update(updateData);
+    if (!mThrown) {
+      mThrown = true;
+      throw std::runtime_error("update failed");
+    }
+  }
+
+ private:
+  bool mThrown = false;
+};
+
+TEST_CASE("HFSM exits and enters states through the least common ancestor", "[state_machine], [hfsm]") {
+  EventLog log;
+  aikit::fsm::HFSM<> hfsm;
+
+  // alive -> (idle, moving -> (walk, run)), dead
+  const auto alive = hfsm.addState("alive", LoggingState(&log, "alive"));
+  const auto idle = hfsm.addState("idle", LoggingState(&log, "idle"), alive);
+  const auto moving = hfsm.addState("moving", LoggingState(&log, "moving"), "alive");
+  const auto walk = hfsm.addState("walk", LoggingState(&log, "walk"), moving);
+  const auto run = hfsm.addState("run", LoggingState(&log, "run"), moving);
+  const auto dead = hfsm.addState("dead", LoggingState(&log, "dead"));
+
+  REQUIRE(hfsm.size() == 6);
+  REQUIRE_FALSE(hfsm.addState("idle", LoggingState(&log, "idle")).isSet());
+  REQUIRE_FALSE(hfsm.addState("orphan", LoggingState(&log, "orphan"), "invalid").isSet());
+  REQUIRE(hfsm.parentOf(run) == moving);
+  REQUIRE_FALSE(hfsm.parentOf(alive).isSet());
+  hfsm.build();
+
+  SECTION("setting a parent as current state sets its initial leaf") {
+    REQUIRE(hfsm.setCurrentState("alive"));
+    REQUIRE(hfsm.currentStateHandle() == idle);
+    REQUIRE(*hfsm.currentStateId() == "idle");
+    REQUIRE(hfsm.isInState(alive));
+    REQUIRE_FALSE(hfsm.isInState(moving));
+    REQUIRE(log.empty());
+  }
+
+  SECTION("transitions to a parent enter its initial children") {
+    hfsm.setCurrentState(idle);
+    REQUIRE(hfsm.transitionTo(moving));
+
+    REQUIRE(hfsm.currentStateHandle() == walk);
+    REQUIRE(hfsm.previousStateHandle() == idle);
+    REQUIRE(log == EventLog{"exit:idle", "enter:moving", "enter:walk"});
+  }
+
+  SECTION("transitions between siblings only exit and enter the siblings") {
+    hfsm.setCurrentState(walk);
+    REQUIRE(hfsm.transitionTo("run"));
+
+    REQUIRE(log == EventLog{"exit:walk", "enter:run"});
+  }
+
+  SECTION("transitions between top level states exit and enter the whole chains") {
+    hfsm.setCurrentState(run);
+    hfsm.transitionTo(dead);
+    REQUIRE(log == EventLog{"exit:run", "exit:moving", "exit:alive", "enter:dead"});
+
+    log.clear();
+    REQUIRE(hfsm.transitionToPreviousState());
+    REQUIRE(hfsm.currentStateHandle() == run);
+    REQUIRE(log == EventLog{"exit:dead", "enter:alive", "enter:moving", "enter:run"});
+  }
+
+  SECTION("transitions to an active state exit and enter it again") {
+    hfsm.setCurrentState(run);
+    hfsm.transitionTo(moving);
+    REQUIRE(log == EventLog{"exit:run", "exit:moving", "enter:moving", "enter:walk"});
+
+    log.clear();
+    hfsm.transitionTo(walk);
+    REQUIRE(log == EventLog{"exit:walk", "enter:walk"});
+  }
+
+  SECTION("the first transition enters the whole chain") {
+    REQUIRE(hfsm.transitionTo(run));
+    REQUIRE(log == EventLog{"enter:alive", "enter:moving", "enter:run"});
+    REQUIRE_FALSE(hfsm.hasPreviousState());
+  }
+
+  SECTION("the initial state can be changed") {
+    REQUIRE(hfsm.setInitialState(moving, run));
+    REQUIRE_FALSE(hfsm.setInitialState(moving, idle));
+
+    hfsm.setCurrentState(idle);
+    hfsm.transitionTo(moving);
+    REQUIRE(hfsm.currentStateHandle() == run);
+  }
+
+  SECTION("invalid transitions are ignored") {
+    hfsm.setCurrentState(idle);
+    REQUIRE_FALSE(hfsm.transitionTo("invalid"));
+    REQUIRE_FALSE(hfsm.transitionTo(aikit::fsm::StateHandle{}));
+    REQUIRE(hfsm.currentStateHandle() == idle);
+    REQUIRE(log.empty());
+  }
+}
+
+TEST_CASE("HFSM updates all active states from the top level down", "[state_machine], [hfsm]") {
+  EventLog log;
+  aikit::fsm::HFSM<> hfsm;
+
+  hfsm.addState("alive", LoggingState(&log, "alive"));
+  hfsm.addState("moving", DyingState(&hfsm, &log, "moving"), "alive");
+  hfsm.addState("walk", LoggingState(&log, "walk"), "moving");
+  hfsm.addState("dead", LoggingState(&log, "dead"));
+  hfsm.setCurrentState("walk");
+
+  // The transition made by "moving" happens after "walk" is updated
+  hfsm.update(1);
+
+  REQUIRE(log == EventLog{"update:alive", "update:moving", "update:walk", "exit:walk", "exit:moving", "exit:alive",
+                          "enter:dead"});
+  REQUIRE(hfsm.isInState("dead"));
+
+  SECTION("states added after building are included on the next transition") {
+    log.clear();
+    hfsm.addState("ghost", LoggingState(&log, "ghost"), "dead");
+    hfsm.transitionTo("alive");
+
+    REQUIRE(log == EventLog{"exit:dead", "enter:alive", "enter:moving", "enter:walk"});
+    REQUIRE(hfsm.transitionTo("dead"));
+    REQUIRE(hfsm.currentStateHandle() == hfsm.stateHandle("ghost"));
+  }
+}
+
+TEST_CASE("HFSM drops the transitions of an update that throws", "[state_machine], [hfsm]") {
+  EventLog log;
+  aikit::fsm::HFSM<> hfsm;
+
+  hfsm.addState("alive", LoggingState(&log, "alive"));
+  hfsm.addState("moving", DyingState(&hfsm, &log, "moving"), "alive");
+  hfsm.addState("walk", ThrowingOnceState(&log, "walk"), "moving");
+  hfsm.addState("dead", LoggingState(&log, "dead"));
+  hfsm.setCurrentState("walk");
+
+  REQUIRE_THROWS_AS(hfsm.update(1), std::runtime_error);
+  REQUIRE(hfsm.isInState("walk"));
+
+  // Only the transition of the second update is made
+  log.clear();
+  hfsm.update(1);
+  REQUIRE(log == EventLog{"update:alive", "update:moving", "update:walk", "exit:walk", "exit:moving", "exit:alive",
+                          "enter:dead"});
+}
+
+TEST_CASE("HFSM builds paths for hierarchies with many levels", "[state_machine], [hfsm]") {
+  EventLog log;
+  aikit::fsm::HFSM<int> hfsm;
+
+  // Two chains of 10 levels under the same top level state
+  constexpr int kDepth = 10;
+  hfsm.addState(0, LoggingState(&log, "0"));
+  for (int branch = 1; branch <= 2; ++branch) {
+    auto parent = hfsm.stateHandle(0);
+    for (int level = 1; level <= kDepth; ++level) {
+      const int id = branch * 100 + level;
+      parent = hfsm.addState(id, LoggingState(&log, std::to_string(id)), parent);
+    }
+  }
+
+  hfsm.setCurrentState(100 + kDepth);
+  hfsm.transitionTo(200 + kDepth);
+
+  REQUIRE(log.size() == 2 * kDepth);
+  REQUIRE(log.front() == "exit:110");
+  REQUIRE(log[kDepth - 1] == "exit:101");
+  REQUIRE(log[kDepth] == "enter:201");
+  REQUIRE(log.back() == "enter:210");
+}
+
+}
@@ -0,0 +1,251 @@
+// Built as its own test executable with CppAIKit_INSTRUMENTATION defined, see CMakeLists.txt
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/Blackboard.hpp>
+#include <cppaikit/Instrumentation.hpp>
+#include <cppaikit/bt/EventDrivenExecutor.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/FSMPool.hpp>
+#include <cppaikit/fsm/HFSM.hpp>
+#include <cppaikit/fsm/StackFSM.hpp>
+#include <cppaikit/goap/Planner.hpp>
+#include <cppaikit/utility/Scorer.hpp>
+
+#include "GlobalAllocations.hpp"
+
+namespace {
+
+using aikit::AllocationStats;
+using aikit::CountingResource;
+using aikit::InstrumentedModule;
+using aikit::test::globalAllocationCount;
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { mAccumulated += updateData; }
+
+ private:
+  int mAccumulated = 0;
+};
+
+// Requests a transition to "idle" from inside update(), exercising the pending transitions
+class FleeState : public aikit::fsm::State<> {
+ public:
+  explicit FleeState(aikit::fsm::FSM<>* fsm) : mFsm(fsm) {}
+
+  void update(int /*updateData*/) override { mFsm->transitionTo("idle"); }
+
+ private:
+  aikit::fsm::FSM<>* mFsm;
+};
+
+TEST_CASE("CountingResource counts allocations, bytes and peak memory", "[instrumentation]") {
+  aikit::resetModuleAllocationStats(InstrumentedModule::User);
+  const AllocationStats moduleBefore = aikit::moduleAllocationStats(InstrumentedModule::User);
+
+  CountingResource resource;
+  void* first = resource.allocate(64, 8);
+  void* second = resource.allocate(32, 8);
+  resource.deallocate(first, 64, 8);
+
+  REQUIRE(resource.stats().allocations == 2);
+  REQUIRE(resource.stats().deallocations == 1);
+  REQUIRE(resource.stats().bytes == 96);
+  REQUIRE(resource.stats().liveBytes == 32);
+  REQUIRE(resource.stats().peakBytes == 96);
+
+  const AllocationStats module = aikit::moduleAllocationStats(InstrumentedModule::User);
+  REQUIRE(module.allocations - moduleBefore.allocations == 2);
+  REQUIRE(module.liveBytes - moduleBefore.liveBytes == 32);
+
+  SECTION("resetting keeps the memory in use") {
+    resource.resetStats();
+    REQUIRE(resource.stats().allocations == 0);
+    REQUIRE(resource.stats().bytes == 0);
+    REQUIRE(resource.stats().liveBytes == 32);
+    REQUIRE(resource.stats().peakBytes == 32);
+  }
+
+  resource.deallocate(second, 32, 8);
+  REQUIRE(resource.stats().liveBytes == 0);
+}
+
+TEST_CASE("FSM counts the allocations of each instance", "[instrumentation]") {
+  const AllocationStats moduleBefore = aikit::moduleAllocationStats(InstrumentedModule::FSM);
+
+  aikit::fsm::FSM<> fsm;
+  aikit::fsm::FSM<> other;
+  REQUIRE(fsm.resource() == std::pmr::get_default_resource());
+
+  fsm.addState("idle", TestState());
+  fsm.addState("patrol", TestState());
+  REQUIRE(fsm.allocationStats().allocations > 0);
+  REQUIRE(fsm.allocationStats().liveBytes > 0);
+  REQUIRE(other.allocationStats().allocations == 0);
+
+  const auto module = aikit::moduleAllocationStats(InstrumentedModule::FSM);
+  REQUIRE(module.allocations - moduleBefore.allocations == fsm.allocationStats().allocations);
+
+  const auto liveBytes = fsm.allocationStats().liveBytes;
+  REQUIRE(fsm.removeState("patrol"));
+  REQUIRE(fsm.allocationStats().deallocations > 0);
+  REQUIRE(fsm.allocationStats().liveBytes < liveBytes);
+  REQUIRE(fsm.allocationStats().peakBytes >= liveBytes);
+
+  SECTION("moved machines keep counting") {
+    aikit::fsm::FSM<> moved(std::move(fsm));
+    moved.addState("attack", TestState());
+    REQUIRE(moved.allocationStats().allocations > 0);
+  }
+
+  SECTION("assigned machines take the counter of the machine moved") {
+    const auto allocations = fsm.allocationStats().allocations;
+    other.addState("attack", TestState());
+    other = std::move(fsm);
+    REQUIRE(other.hasState("idle"));
+    REQUIRE_FALSE(other.hasState("attack"));
+    REQUIRE(other.allocationStats().allocations == allocations);
+
+    other.addState("attack", TestState());
+    REQUIRE(other.allocationStats().allocations > allocations);
+  }
+
+  SECTION("machines can be erased from vectors") {
+    std::vector<aikit::fsm::FSM<>> machines;
+    machines.emplace_back().addState("idle", TestState());
+    machines.emplace_back().addState("patrol", TestState());
+    machines.erase(machines.begin());
+    REQUIRE(machines.size() == 1);
+    REQUIRE(machines.front().hasState("patrol"));
+  }
+}
+
+TEST_CASE("Every module counts its allocations", "[instrumentation]") {
+  const auto allocated = [](InstrumentedModule module, const auto& create) {
+    aikit::resetModuleAllocationStats(module);
+    create();
+    const AllocationStats stats = aikit::moduleAllocationStats(module);
+    return stats.allocations > 0 && stats.allocations == stats.deallocations;
+  };
+
+  REQUIRE(allocated(InstrumentedModule::HFSM, [] {
+    aikit::fsm::HFSM<> hfsm;
+    const auto alive = hfsm.addState("alive", TestState());
+    hfsm.addState("idle", TestState(), alive);
+    hfsm.setCurrentState("idle");
+  }));
+
+  REQUIRE(allocated(InstrumentedModule::FSMPool, [] {
+    aikit::fsm::FSMPool<> pool;
+    pool.addState("idle", TestState());
+    pool.addAgent();
+  }));
+
+  REQUIRE(allocated(InstrumentedModule::FSM, [] {
+    aikit::fsm::StackFSM<> stack;
+    stack.addState("idle", TestState());
+    REQUIRE(stack.allocationStats().allocations > 0);
+  }));
+
+  REQUIRE(allocated(InstrumentedModule::BehaviorTree, [] {
+    const auto tree = aikit::bt::BehaviorTree<int>::Builder()
+        .sequence()
+          .condition([](int&) { return true; })
+          .action([](int&) { return aikit::bt::Status::Success; })
+        .end()
+        .build();
+    aikit::bt::EventDrivenExecutor<int> executor(tree);
+  }));
+
+  REQUIRE(allocated(InstrumentedModule::GOAP, [] {
+    aikit::goap::Planner<> planner(16);
+    planner.addAction({});
+    planner.enableCache(4);
+  }));
+
+  REQUIRE(allocated(InstrumentedModule::Blackboard, [] {
+    aikit::BlackboardSchema schema;
+    schema.addKey<int>("ammo");
+    aikit::Blackboard blackboard(schema);
+  }));
+
+  REQUIRE(allocated(InstrumentedModule::Utility, [] {
+    aikit::utility::Scorer scorer(2, 16);
+    scorer.addAction();
+  }));
+}
+
+TEST_CASE("FSM updates and transitions do not allocate after warm-up", "[instrumentation]") {
+  aikit::fsm::FSM<> fsm;
+  fsm.reserve(3);
+  const auto idle = fsm.addState("idle", TestState());
+  const auto patrol = fsm.addState("patrol", TestState());
+  fsm.addState("flee", FleeState(&fsm));
+  const auto alarm = fsm.addEvent();
+  fsm.addTransition(idle, alarm, patrol);
+  fsm.enableHistory(8);
+  fsm.setCurrentState("idle");
+
+  const auto tick = [&] {
+    fsm.update(1);
+    fsm.transitionTo("patrol");
+    fsm.transitionTo(idle);
+    fsm.dispatch(alarm);
+    fsm.transitionTo("flee");
+    fsm.update(1);
+    fsm.transitionToPreviousState();
+  };
+
+  tick();
+  fsm.resetAllocationStats();
+  const std::uint64_t globalBefore = globalAllocationCount().load(std::memory_order_relaxed);
+
+  for (int i = 0; i < 100; ++i) {
+    tick();
+  }
+
+  // Allocations outside of the resource of the machine (e.g. temporaries) are only seen on the global heap
+  const std::uint64_t globalAfter = globalAllocationCount().load(std::memory_order_relaxed);
+  REQUIRE(fsm.allocationStats().allocations == 0);
+  REQUIRE(fsm.allocationStats().deallocations == 0);
+  REQUIRE(globalAfter == globalBefore);
+}
+
+TEST_CASE("Cached planning does not allocate after warm-up", "[instrumentation]") {
+  typedef aikit::goap::WorldState<8> WorldState;
+
+  aikit::goap::Planner<8> planner(64);
+  for (std::size_t fact = 0; fact < 4; ++fact) {
+    planner.addAction({WorldState(), WorldState().set(fact), 1.0f});
+  }
+  planner.enableCache(2);
+
+  // Three goals on a cache of two plans, so plans are both found and evicted
+  const WorldState goals[] = {WorldState().set(0).set(1), WorldState().set(1).set(2).set(3), WorldState().set(3)};
+  std::vector<std::uint32_t> plan;
+  plan.reserve(4);
+  const auto tick = [&] {
+    for (const auto& goal : goals) {
+      planner.plan(WorldState(), goal, plan);
+      planner.plan(WorldState(), goal, plan);
+    }
+  };
+
+  tick();
+  aikit::resetModuleAllocationStats(InstrumentedModule::GOAP);
+  const std::uint64_t globalBefore = globalAllocationCount().load(std::memory_order_relaxed);
+
+  for (int i = 0; i < 100; ++i) {
+    tick();
+  }
+
+  REQUIRE(aikit::moduleAllocationStats(InstrumentedModule::GOAP).allocations == 0);
+  REQUIRE(globalAllocationCount().load(std::memory_order_relaxed) == globalBefore);
+  REQUIRE(planner.cache().hits() > 0);
+}
+
+}
@@ -0,0 +1,73 @@
+#include <thread>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/MPSCQueue.hpp>
+
+namespace {
+
+TEST_CASE("MPSCQueue keeps elements in order up to its capacity", "[concurrency]") {
+  aikit::MPSCQueue<int> queue(6);
+  REQUIRE(queue.capacity() == 8);
+
+  int value = -1;
+  REQUIRE_FALSE(queue.tryPop(value));
+  REQUIRE(value == -1);
+
+  // Go around the ring buffer a few times
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(queue.tryPush(round * 8 + i));
+    }
+    REQUIRE_FALSE(queue.tryPush(-1));
+
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(queue.tryPop(value));
+      REQUIRE(value == round * 8 + i);
+    }
+    REQUIRE_FALSE(queue.tryPop(value));
+  }
+}
+
+TEST_CASE("MPSCQueue delivers every element of concurrent producers", "[concurrency]") {
+  constexpr int kProducers = 4;
+  constexpr int kElementsPerProducer = 10000;
+
+  aikit::MPSCQueue<int> queue(64);
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducers; ++producer) {
+    producers.emplace_back([&queue, producer] {
+      for (int i = 0; i < kElementsPerProducer; ++i) {
+        while (!queue.tryPush(producer * kElementsPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Elements of each producer must arrive in the order they were pushed
+  std::vector<int> nextOfProducer(kProducers, 0);
+  int received = 0;
+  bool ordered = true;
+  while (received < kProducers * kElementsPerProducer) {
+    int value = 0;
+    if (queue.tryPop(value)) {
+      const int producer = value / kElementsPerProducer;
+      ordered = ordered && (value % kElementsPerProducer == nextOfProducer[static_cast<std::size_t>(producer)]);
+      ++nextOfProducer[static_cast<std::size_t>(producer)];
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  REQUIRE(ordered);
+  REQUIRE(nextOfProducer == std::vector<int>(kProducers, kElementsPerProducer));
+}
+
+}
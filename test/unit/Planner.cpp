@@ -0,0 +1,316 @@
+#include <cstdint>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/goap/Planner.hpp>
+
+namespace {
+
+enum Fact : std::size_t { HasAxe, HasWood, HasFirewood, HasMoney, NearTree, Fact_count };
+
+typedef aikit::goap::WorldState<Fact_count> TestWorldState;
+typedef aikit::goap::Planner<Fact_count> TestPlanner;
+
+TestPlanner::Action_type makeAction(TestWorldState preconditions, TestWorldState effects, float cost) {
+  return {preconditions, effects, cost};
+}
+
+TEST_CASE("WorldState bitwise facts", "[goap]") {
+  TestWorldState state;
+  REQUIRE(state.count() == 0);
+
+  state.set(HasAxe).set(HasWood, false);
+  REQUIRE(state.isSet(HasAxe));
+  REQUIRE(state.get(HasAxe));
+  REQUIRE(state.isSet(HasWood));
+  REQUIRE_FALSE(state.get(HasWood));
+  REQUIRE_FALSE(state.isSet(HasMoney));
+  REQUIRE(state.count() == 2);
+
+  SECTION("facts not set on the conditions do not matter") {
+    REQUIRE(state.satisfies(TestWorldState().set(HasAxe)));
+    REQUIRE(state.satisfies(TestWorldState()));
+    REQUIRE_FALSE(state.satisfies(TestWorldState().set(HasWood)));
+    REQUIRE(state.distance(TestWorldState().set(HasWood).set(HasAxe)) == 1);
+  }
+
+  SECTION("facts not set on the state never meet a condition") {
+    REQUIRE_FALSE(state.satisfies(TestWorldState().set(HasMoney, false)));
+    REQUIRE(state.distance(TestWorldState().set(HasMoney, false)) == 1);
+  }
+
+  SECTION("effects overwrite only the facts they set") {
+    state.apply(TestWorldState().set(HasWood).set(HasMoney));
+    REQUIRE(state.get(HasAxe));
+    REQUIRE(state.get(HasWood));
+    REQUIRE(state.get(HasMoney));
+    REQUIRE(state.count() == 3);
+  }
+
+  SECTION("unset facts compare as never set") {
+    TestWorldState other = TestWorldState().set(HasAxe);
+    REQUIRE(state != other);
+    state.unset(HasWood);
+    REQUIRE(state == other);
+    REQUIRE(state.hash() == other.hash());
+  }
+}
+
+TEST_CASE("WorldState with more than one word", "[goap]") {
+  aikit::goap::WorldState<130> state;
+  state.set(3).set(70).set(129);
+  REQUIRE(state.count() == 3);
+  REQUIRE(state.get(129));
+  REQUIRE(state.satisfies(aikit::goap::WorldState<130>().set(70)));
+  REQUIRE_FALSE(state.satisfies(aikit::goap::WorldState<130>().set(128)));
+}
+
+TEST_CASE("Planner finds the cheapest plan", "[goap]") {
+  TestPlanner planner(64);
+  const auto buyAxe = planner.addAction(
+      makeAction(TestWorldState().set(HasMoney), TestWorldState().set(HasAxe).set(HasMoney, false), 2.0f));
+  const auto walkToTree = planner.addAction(makeAction(TestWorldState(), TestWorldState().set(NearTree), 1.0f));
+  const auto chopTree = planner.addAction(
+      makeAction(TestWorldState().set(HasAxe).set(NearTree), TestWorldState().set(HasWood), 2.0f));
+  const auto gatherBranches = planner.addAction(
+      makeAction(TestWorldState().set(NearTree), TestWorldState().set(HasWood), 8.0f));
+  const auto makeFirewood = planner.addAction(
+      makeAction(TestWorldState().set(HasWood), TestWorldState().set(HasFirewood), 1.0f));
+
+  REQUIRE(planner.actionCount() == 5);
+
+  const TestWorldState goal = TestWorldState().set(HasFirewood);
+  const TestWorldState start = TestWorldState().set(HasAxe, false).set(HasMoney).set(HasWood, false);
+  std::vector<std::uint32_t> plan;
+
+  REQUIRE(planner.plan(start, goal, plan));
+  REQUIRE(plan.size() == 4);
+  REQUIRE(plan[0] != chopTree);
+  REQUIRE(plan[2] == chopTree);
+  REQUIRE(plan[3] == makeFirewood);
+  REQUIRE(((plan[0] == buyAxe && plan[1] == walkToTree) || (plan[0] == walkToTree && plan[1] == buyAxe)));
+
+  SECTION("without money the expensive action is used") {
+    REQUIRE(planner.plan(TestWorldState().set(HasMoney, false), goal, plan));
+    REQUIRE(plan == std::vector<std::uint32_t>{walkToTree, gatherBranches, makeFirewood});
+  }
+
+  SECTION("removed actions are not used") {
+    REQUIRE(planner.removeAction(gatherBranches));
+    REQUIRE_FALSE(planner.hasAction(gatherBranches));
+    REQUIRE(planner.getAction(gatherBranches) == nullptr);
+    REQUIRE_FALSE(planner.removeAction(gatherBranches));
+    REQUIRE(planner.actionCount() == 4);
+
+    REQUIRE_FALSE(planner.plan(TestWorldState().set(HasMoney, false), goal, plan));
+    REQUIRE(plan.empty());
+  }
+
+  SECTION("a start meeting the goal needs no action") {
+    REQUIRE(planner.plan(TestWorldState().set(HasFirewood), goal, plan));
+    REQUIRE(plan.empty());
+  }
+
+  SECTION("the planner is reused between searches") {
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(planner.plan(start, goal, plan));
+      REQUIRE(plan.size() == 4);
+    }
+  }
+}
+
+TEST_CASE("Planner fails when the node pool is exhausted", "[goap]") {
+  typedef aikit::goap::WorldState<16> WideState;
+  aikit::goap::Planner<16> planner(8);
+
+  // Goal needs all 16 facts set, one per action, too many states for the pool
+  for (std::size_t bit = 0; bit < 16; ++bit) {
+    planner.addAction({WideState(), WideState().set(bit), 1.0f});
+  }
+
+  WideState goal;
+  WideState start;
+  for (std::size_t bit = 0; bit < 16; ++bit) {
+    goal.set(bit);
+    start.set(bit, false);
+  }
+
+  std::vector<std::uint32_t> plan;
+  REQUIRE(planner.nodeCapacity() == 8);
+  REQUIRE_FALSE(planner.plan(start, goal, plan));
+
+  aikit::goap::Planner<16> largePlanner(1 << 17);
+  for (std::size_t bit = 0; bit < 16; ++bit) {
+    largePlanner.addAction({WideState(), WideState().set(bit), 1.0f});
+  }
+  REQUIRE(largePlanner.plan(start, goal, plan));
+  REQUIRE(plan.size() == 16);
+}
+
+TEST_CASE("Planner incremental searches", "[goap]") {
+  typedef aikit::goap::WorldState<16> WideState;
+  aikit::goap::Planner<16> planner;
+  for (std::size_t bit = 0; bit < 8; ++bit) {
+    planner.addAction({WideState(), WideState().set(bit), 1.0f});
+  }
+
+  WideState goal;
+  WideState start;
+  for (std::size_t bit = 0; bit < 8; ++bit) {
+    goal.set(bit);
+    start.set(bit, false);
+  }
+
+  std::vector<std::uint32_t> plan;
+  aikit::goap::Planner<16>::Search search(256);
+  REQUIRE(search.status() == aikit::goap::PlanStatus::NotFound);
+  REQUIRE(planner.begin(search, start, goal) == aikit::goap::PlanStatus::Running);
+
+  SECTION("a search runs a bounded number of expansions per step") {
+    std::size_t steps = 0;
+    while (planner.step(search, 2) == aikit::goap::PlanStatus::Running) {
+      REQUIRE_FALSE(planner.result(search, plan));
+      ++steps;
+    }
+
+    REQUIRE(steps >= 4);
+    REQUIRE(search.status() == aikit::goap::PlanStatus::Found);
+    REQUIRE(planner.result(search, plan));
+    REQUIRE(plan.size() == 8);
+  }
+
+  SECTION("searches of many agents run side by side") {
+    aikit::goap::Planner<16>::Search otherSearch(256);
+    REQUIRE(planner.begin(otherSearch, start, WideState().set(3)) == aikit::goap::PlanStatus::Running);
+
+    for (bool running = true; running;) {
+      const bool searchRunning = planner.step(search, 1) == aikit::goap::PlanStatus::Running;
+      const bool otherRunning = planner.step(otherSearch, 1) == aikit::goap::PlanStatus::Running;
+      running = searchRunning || otherRunning;
+    }
+
+    REQUIRE(planner.result(search, plan));
+    REQUIRE(plan.size() == 8);
+    REQUIRE(planner.result(otherSearch, plan));
+    REQUIRE(plan == std::vector<std::uint32_t>{3});
+  }
+
+  SECTION("a search without a plan finishes as not found") {
+    planner.begin(search, start, WideState().set(12));
+    REQUIRE(planner.step(search, 1000) == aikit::goap::PlanStatus::NotFound);
+    REQUIRE(search.visitedCount() == 256);
+    REQUIRE_FALSE(planner.result(search, plan));
+  }
+
+  SECTION("a search without memory never runs") {
+    aikit::goap::Planner<16>::Search emptySearch(0);
+    REQUIRE(planner.begin(emptySearch, start, goal) == aikit::goap::PlanStatus::OutOfNodes);
+  }
+
+  SECTION("a search needing more world states than its capacity stops") {
+    aikit::goap::Planner<16>::Search smallSearch(16);
+    REQUIRE(planner.begin(smallSearch, start, goal) == aikit::goap::PlanStatus::Running);
+    REQUIRE(planner.step(smallSearch, 1000) == aikit::goap::PlanStatus::OutOfNodes);
+    REQUIRE(smallSearch.visitedCount() == 16);
+    REQUIRE_FALSE(planner.result(smallSearch, plan));
+
+    // Finished searches are not run again
+    REQUIRE(planner.step(smallSearch, 1000) == aikit::goap::PlanStatus::OutOfNodes);
+  }
+}
+
+TEST_CASE("Planner fails when out of nodes instead of returning a worse plan", "[goap]") {
+  const auto addActions = [](TestPlanner& planner) {
+    planner.addAction(makeAction(TestWorldState(), TestWorldState().set(HasWood), 10.0f));
+    planner.addAction(makeAction(TestWorldState(), TestWorldState().set(NearTree), 1.0f));
+    planner.addAction(makeAction(TestWorldState().set(NearTree), TestWorldState().set(HasWood), 1.0f));
+  };
+  const TestWorldState start = TestWorldState().set(NearTree, false);
+  const TestWorldState goal = TestWorldState().set(HasWood);
+  std::vector<std::uint32_t> plan;
+
+  // The expensive plan takes the last node, the cheapest one needs the world state near the tree too
+  TestPlanner smallPlanner(2);
+  addActions(smallPlanner);
+  REQUIRE_FALSE(smallPlanner.plan(start, goal, plan));
+  REQUIRE(plan.empty());
+
+  TestPlanner planner(4);
+  addActions(planner);
+  REQUIRE(planner.plan(start, goal, plan));
+  REQUIRE(plan == std::vector<std::uint32_t>{1, 2});
+}
+
+TEST_CASE("Planner plan cache", "[goap]") {
+  TestPlanner planner(64);
+  const auto walkToTree = planner.addAction(makeAction(TestWorldState(), TestWorldState().set(NearTree), 1.0f));
+  const auto gatherBranches = planner.addAction(
+      makeAction(TestWorldState().set(NearTree), TestWorldState().set(HasWood), 8.0f));
+  planner.enableCache(2);
+
+  const TestWorldState start = TestWorldState().set(NearTree, false);
+  const TestWorldState goal = TestWorldState().set(HasWood);
+  std::vector<std::uint32_t> plan;
+
+  REQUIRE(planner.plan(start, goal, plan));
+  REQUIRE(planner.cache().misses() == 1);
+  REQUIRE(planner.cache().size() == 1);
+
+  plan.clear();
+  REQUIRE(planner.plan(start, goal, plan));
+  REQUIRE(plan == std::vector<std::uint32_t>{walkToTree, gatherBranches});
+  REQUIRE(planner.cache().hits() == 1);
+  REQUIRE(planner.cache().hitRate() == Approx(0.5));
+
+  SECTION("failed searches are cached too") {
+    REQUIRE_FALSE(planner.plan(start, TestWorldState().set(HasMoney), plan));
+    REQUIRE_FALSE(planner.plan(start, TestWorldState().set(HasMoney), plan));
+    REQUIRE(plan.empty());
+    REQUIRE(planner.cache().hits() == 2);
+  }
+
+  SECTION("changing the actions invalidates the cache") {
+    const auto version = planner.actionsVersion();
+    const auto chopTree = planner.addAction(
+        makeAction(TestWorldState().set(NearTree), TestWorldState().set(HasWood), 2.0f));
+    REQUIRE(planner.actionsVersion() != version);
+    REQUIRE(planner.cache().size() == 0);
+
+    REQUIRE(planner.plan(start, goal, plan));
+    REQUIRE(plan == std::vector<std::uint32_t>{walkToTree, chopTree});
+    REQUIRE(planner.cache().misses() == 2);
+  }
+
+  SECTION("the least recently used plan is evicted") {
+    const TestWorldState nearTree = TestWorldState().set(NearTree);
+    const TestWorldState hasWood = TestWorldState().set(HasWood);
+
+    REQUIRE(planner.plan(nearTree, goal, plan));
+    REQUIRE(planner.plan(start, goal, plan)); // Hit, now the most recently used
+    REQUIRE(planner.plan(hasWood, goal, plan)); // Evicts the plan from nearTree
+    REQUIRE(planner.cache().size() == 2);
+
+    const auto misses = planner.cache().misses();
+    REQUIRE(planner.plan(start, goal, plan));
+    REQUIRE(planner.cache().misses() == misses);
+    REQUIRE(planner.plan(nearTree, goal, plan));
+    REQUIRE(planner.cache().misses() == misses + 1);
+  }
+  SECTION("plans longer than the maximum plan length are not cached") {
+    planner.enableCache(2, 1);
+    REQUIRE(planner.cache().maxPlanLength() == 1);
+
+    REQUIRE(planner.plan(start, goal, plan));
+    REQUIRE(planner.plan(start, goal, plan));
+    REQUIRE(planner.cache().size() == 0);
+    REQUIRE(planner.cache().misses() == 2);
+
+    const TestWorldState nearTree = TestWorldState().set(NearTree);
+    REQUIRE(planner.plan(nearTree, goal, plan));
+    REQUIRE(planner.plan(nearTree, goal, plan));
+    REQUIRE(plan == std::vector<std::uint32_t>{gatherBranches});
+    REQUIRE(planner.cache().hits() == 1);
+  }
+}
+
+}
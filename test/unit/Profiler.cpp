@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/FSMScheduler.hpp>
+#include <cppaikit/fsm/Profiler.hpp>
+
+namespace {
+
+using aikit::fsm::ProfileStats;
+
+typedef aikit::fsm::FSM<std::string, aikit::fsm::State<>, aikit::fsm::storage::Map, aikit::fsm::Profiler> ProfiledFSM;
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override {}
+};
+
+class SlowState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override { std::this_thread::sleep_for(std::chrono::microseconds(100)); }
+};
+
+class ThrowingState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override { throw std::runtime_error("update failed"); }
+};
+
+TEST_CASE("NoProfiler is compiled out", "[profiler]") {
+  REQUIRE(std::is_empty_v<aikit::fsm::detail::ProfilerHolder<aikit::fsm::NoProfiler>>);
+  REQUIRE(sizeof(ProfiledFSM) > sizeof(aikit::fsm::FSM<>));
+}
+
+TEST_CASE("Profiler counts enters, exits, updates and transitions", "[profiler]") {
+  ProfileStats stats;
+  ProfiledFSM fsm;
+  fsm.profiler().attach(&stats);
+  REQUIRE(fsm.profiler().stats() == &stats);
+
+  const auto idle = fsm.addState("idle", TestState());
+  const auto work = fsm.addState("work", SlowState());
+
+  fsm.setCurrentState(idle);
+  fsm.update(0);
+  fsm.transitionTo(work);
+  fsm.update(0);
+  fsm.update(0);
+  fsm.transitionTo(idle);
+
+  const auto& idleStats = stats.state(idle.index);
+  const auto& workStats = stats.state(work.index);
+  REQUIRE(idleStats.enterCount == 2);
+  REQUIRE(idleStats.exitCount == 1);
+  REQUIRE(idleStats.updateCount == 1);
+  REQUIRE(workStats.enterCount == 1);
+  REQUIRE(workStats.exitCount == 1);
+  REQUIRE(workStats.updateCount == 2);
+  REQUIRE(workStats.updateNanoseconds >= 200000);
+  REQUIRE(workStats.dwellNanoseconds >= workStats.updateNanoseconds);
+
+  REQUIRE(stats.transitionCount(idle.index, work.index) == 1);
+  REQUIRE(stats.transitionCount(work.index, idle.index) == 1);
+  REQUIRE(stats.transitionCount(work.index, work.index) == 0);
+
+  const auto exits = std::accumulate(workStats.dwellHistogram.begin(), workStats.dwellHistogram.end(),
+                                     std::uint64_t{0});
+  REQUIRE(exits == workStats.exitCount);
+
+  SECTION("removing the current state exits it") {
+    fsm.removeState(idle);
+    REQUIRE(stats.state(idle.index).exitCount == 2);
+  }
+
+  SECTION("updates that throw are still sampled") {
+    const auto throwing = fsm.addState("throwing", ThrowingState());
+    fsm.transitionTo(throwing);
+    REQUIRE_THROWS_AS(fsm.update(0), std::runtime_error);
+    fsm.transitionTo(idle);
+    REQUIRE(stats.state(throwing.index).updateCount == 1);
+  }
+
+  SECTION("detached profilers record nothing") {
+    fsm.profiler().attach(nullptr);
+    fsm.transitionTo(work);
+    REQUIRE(stats.state(work.index).enterCount == 1);
+  }
+}
+
+TEST_CASE("Machines updated in parallel share profile stats", "[profiler], [fsm_scheduler]") {
+  ProfileStats stats;
+  std::vector<ProfiledFSM> machines(64);
+  for (auto& machine : machines) {
+    machine.profiler().attach(&stats);
+    machine.addState("idle", SlowState());
+    machine.addState("attack", SlowState());
+    machine.setCurrentState("idle");
+  }
+
+  aikit::fsm::FSMScheduler<ProfiledFSM> scheduler(4, 8);
+  scheduler.update(machines, 0);
+  for (auto& machine : machines) {
+    machine.transitionTo("attack");
+  }
+  scheduler.update(machines, 0);
+  scheduler.update(machines, 0);
+
+  const auto idle = machines.front().stateHandle("idle");
+  const auto attack = machines.front().stateHandle("attack");
+  REQUIRE(stats.state(idle.index).updateCount == machines.size());
+  REQUIRE(stats.state(attack.index).updateCount == 2 * machines.size());
+  REQUIRE(stats.transitionCount(idle.index, attack.index) == machines.size());
+
+  SECTION("updates not committed yet are recorded on the next transition") {
+    for (auto& machine : machines) {
+      machine.updateCurrentState(0);
+      machine.transitionTo("idle");
+    }
+    REQUIRE(stats.state(attack.index).updateCount == 3 * machines.size());
+  }
+}
+
+TEST_CASE("Profile stats aggregate machines", "[profiler]") {
+  ProfileStats stats;
+  ProfiledFSM first;
+  ProfiledFSM second;
+  ProfileStats otherThread;
+  ProfiledFSM third;
+
+  for (auto* fsm : {&first, &second, &third}) {
+    fsm->profiler().attach((fsm == &third) ? &otherThread : &stats);
+    fsm->addState("idle", TestState());
+    fsm->addState("attack", TestState());
+    fsm->setCurrentState("idle");
+    fsm->transitionTo("attack");
+  }
+
+  const auto attack = first.stateHandle("attack");
+  REQUIRE(stats.state(attack.index).enterCount == 2);
+  REQUIRE(stats.stateCount() == 2);
+
+  stats.merge(otherThread);
+  REQUIRE(stats.state(attack.index).enterCount == 3);
+  REQUIRE(stats.transitionCount(first.stateHandle("idle").index, attack.index) == 3);
+
+  SECTION("the report names states and transitions") {
+    std::ostringstream report;
+    stats.writeReport(report, [](std::uint32_t state) { return (state == 0) ? "idle" : "attack"; });
+    REQUIRE(report.str().find("attack") != std::string::npos);
+    REQUIRE(report.str().find("idle -> attack: 3") != std::string::npos);
+  }
+
+  SECTION("clearing resets all counters") {
+    stats.clear();
+    REQUIRE(stats.stateCount() == 0);
+    REQUIRE(stats.state(attack.index).enterCount == 0);
+  }
+}
+
+}
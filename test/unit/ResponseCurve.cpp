@@ -0,0 +1,73 @@
+#include <cmath>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/utility/ResponseCurve.hpp>
+
+namespace {
+
+using aikit::utility::ResponseCurve;
+
+TEST_CASE("ResponseCurve shapes", "[utility]") {
+  SECTION("linear") {
+    const auto curve = ResponseCurve::linear(-1.0f, 0.0f, 1.0f);
+    REQUIRE(curve.evaluate(0.0f) == Approx(1.0f));
+    REQUIRE(curve.evaluate(0.25f) == Approx(0.75f));
+    REQUIRE(curve.evaluate(1.0f) == Approx(0.0f));
+  }
+
+  SECTION("quadratic") {
+    const auto curve = ResponseCurve::quadratic(4.0f, 0.5f);
+    REQUIRE(curve.evaluate(0.5f) == Approx(0.0f));
+    REQUIRE(curve.evaluate(0.75f) == Approx(0.25f));
+    REQUIRE(curve.evaluate(0.0f) == Approx(1.0f));
+  }
+
+  SECTION("logistic") {
+    const auto curve = ResponseCurve::logistic(10.0f, 0.5f);
+    REQUIRE(curve.evaluate(0.5f) == Approx(0.5f));
+    for (float x = -1.0f; x <= 2.0f; x += 0.125f) {
+      REQUIRE(curve.evaluate(x) == Approx(1.0f / (1.0f + std::exp(-10.0f * (x - 0.5f)))).epsilon(1e-5));
+    }
+  }
+
+  SECTION("piecewise") {
+    const auto curve = ResponseCurve::piecewise({{0.2f, 0.0f}, {0.4f, 1.0f}, {0.6f, 1.0f}, {0.6f, 0.5f}});
+    REQUIRE(curve.pointCount == 4);
+    REQUIRE(curve.evaluate(0.0f) == Approx(0.0f));
+    REQUIRE(curve.evaluate(0.3f) == Approx(0.5f));
+    REQUIRE(curve.evaluate(0.5f) == Approx(1.0f));
+    REQUIRE(curve.evaluate(0.7f) == Approx(0.5f));
+  }
+
+  SECTION("outputs are clamped") {
+    const auto curve = ResponseCurve::linear(2.0f, 0.0f, -0.5f);
+    REQUIRE(curve.evaluate(0.0f) == 0.0f);
+    REQUIRE(curve.evaluate(1.0f) == 1.0f);
+  }
+}
+
+TEST_CASE("ResponseCurve evaluates many inputs like one at a time", "[utility]") {
+  // An odd count so both the SIMD loop and the remainder are used
+  std::vector<float> inputs(37);
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    inputs[i] = static_cast<float>(i) / 32.0f - 0.1f;
+  }
+
+  for (const auto& curve : {ResponseCurve::linear(0.5f, 0.2f, 0.1f), ResponseCurve::quadratic(-1.0f, 1.0f, 1.0f),
+                            ResponseCurve::logistic(-8.0f, 0.3f, 0.9f),
+                            ResponseCurve::piecewise({{0.0f, 1.0f}, {0.5f, 0.2f}, {1.0f, 0.6f}})}) {
+    std::vector<float> outputs(inputs.size());
+    curve.evaluate(inputs.data(), outputs.data(), inputs.size());
+
+    std::vector<float> scores(inputs.size(), 0.5f);
+    curve.multiply(inputs.data(), scores.data(), inputs.size());
+
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+      REQUIRE(outputs[i] == Approx(curve.evaluate(inputs[i])));
+      REQUIRE(scores[i] == Approx(0.5f * curve.evaluate(inputs[i])));
+    }
+  }
+}
+
+}
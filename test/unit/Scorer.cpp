@@ -0,0 +1,92 @@
+#include <string>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/utility/Scorer.hpp>
+
+namespace {
+
+using aikit::utility::ResponseCurve;
+using aikit::utility::Scorer;
+
+enum Input : std::uint32_t { Health, EnemyDistance, Input_count };
+
+TEST_CASE("Scorer picks the action with the highest score for each agent", "[utility]") {
+  constexpr std::size_t agentCount = 1000;
+  Scorer scorer(Input_count, agentCount);
+
+  REQUIRE(scorer.winner(0) == Scorer::kNoAction);
+  REQUIRE_FALSE(scorer.winnerState(0).isSet());
+
+  // Flee when hurt, attack when the enemy is close and healthy, idle otherwise
+  const auto flee = scorer.addAction();
+  REQUIRE(scorer.addConsideration(flee, Health, ResponseCurve::linear(-1.0f, 0.0f, 1.0f)));
+  const auto attack = scorer.addAction();
+  REQUIRE(scorer.addConsideration(attack, Health, ResponseCurve::logistic(10.0f, 0.3f)));
+  REQUIRE(scorer.addConsideration(attack, EnemyDistance, ResponseCurve::quadratic(1.0f, 1.0f)));
+  const auto idle = scorer.addAction({}, 0.3f);
+
+  REQUIRE_FALSE(scorer.addConsideration(idle, Input_count, ResponseCurve()));
+  REQUIRE_FALSE(scorer.addConsideration(3, Health, ResponseCurve()));
+  REQUIRE(scorer.actionCount() == 3);
+
+  for (std::size_t agent = 0; agent < agentCount; ++agent) {
+    scorer.setInput(Health, agent, static_cast<float>(agent % 10) / 10.0f);
+    scorer.input(EnemyDistance)[agent] = static_cast<float>(agent % 7) / 7.0f;
+  }
+  scorer.score();
+
+  for (std::size_t agent = 0; agent < agentCount; ++agent) {
+    const float health = static_cast<float>(agent % 10) / 10.0f;
+    const float distance = static_cast<float>(agent % 7) / 7.0f;
+    const float scores[] = {ResponseCurve::linear(-1.0f, 0.0f, 1.0f).evaluate(health),
+                            ResponseCurve::logistic(10.0f, 0.3f).evaluate(health) *
+                                ResponseCurve::quadratic(1.0f, 1.0f).evaluate(distance),
+                            0.3f};
+    const auto expected = static_cast<std::uint32_t>(std::max_element(scores, scores + 3) - scores);
+
+    REQUIRE(scorer.winner(agent) == expected);
+    REQUIRE(scorer.winnerScore(agent) == Approx(scores[expected]));
+  }
+
+  REQUIRE(scorer.winner(0) == flee);
+  REQUIRE(scorer.winners().size() == agentCount);
+}
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  void onEnter() override { ++mEnters; }
+  void update(int) override {}
+
+  int mEnters = 0;
+};
+
+TEST_CASE("Scorer drives a FSM through state handles", "[utility]") {
+  aikit::fsm::FSM<std::string, TestState> fsm;
+  const auto idleHandle = fsm.addState("idle", TestState());
+  const auto fleeHandle = fsm.addState("flee", TestState());
+  fsm.setCurrentState(idleHandle);
+
+  Scorer scorer(1, 1);
+  scorer.addAction(idleHandle, 0.5f);
+  const auto flee = scorer.addAction(fleeHandle);
+  scorer.addConsideration(flee, 0, ResponseCurve::linear(-1.0f, 0.0f, 1.0f));
+
+  scorer.setInput(0, 0, 1.0f);
+  scorer.score();
+  REQUIRE(scorer.winnerState(0) == idleHandle);
+  REQUIRE_FALSE(scorer.transitionToWinner(fsm, 0));
+
+  scorer.setInput(0, 0, 0.1f);
+  scorer.score();
+  REQUIRE(scorer.winnerState(0) == fleeHandle);
+  REQUIRE(scorer.transitionToWinner(fsm, 0));
+  REQUIRE(fsm.currentStateHandle() == fleeHandle);
+  REQUIRE(fsm.getState(fleeHandle)->mEnters == 1);
+
+  // Already in the winner state, the state is not entered again
+  REQUIRE_FALSE(scorer.transitionToWinner(fsm, 0));
+  REQUIRE(fsm.getState(fleeHandle)->mEnters == 1);
+}
+
+}
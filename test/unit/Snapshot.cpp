@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/Profiler.hpp>
+#include <cppaikit/fsm/Snapshot.hpp>
+
+namespace {
+
+struct EventCounter {
+  int timesEntered = 0;
+  int timesExited = 0;
+};
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  explicit TestState(EventCounter* counter = nullptr) : mCounter(counter) {}
+
+  void onEnter() override {
+    if (mCounter) {
+      ++mCounter->timesEntered;
+    }
+  }
+
+  void onExit() override {
+    if (mCounter) {
+      ++mCounter->timesExited;
+    }
+  }
+
+  void update(int /*updateData*/) override {}
+
+ private:
+  EventCounter* mCounter;
+};
+
+// States with data worth saving: a counter of updates
+class CountingState : public aikit::fsm::State<> {
+ public:
+  void update(int updateData) override { count += updateData; }
+
+  std::int32_t count = 0;
+};
+
+void buildMachine(aikit::fsm::FSM<>& fsm, EventCounter* counter = nullptr) {
+  fsm.addState("idle", TestState(counter));
+  fsm.addState("patrol", TestState(counter));
+  fsm.addState("attack", TestState(counter));
+}
+
+}
+
+template<>
+struct aikit::fsm::StateSerializer<CountingState> {
+  static constexpr bool kEnabled = true;
+
+  static std::size_t size(const CountingState& /*state*/) { return sizeof(std::int32_t); }
+
+  static void write(const CountingState& state, unsigned char* output) {
+    std::memcpy(output, &state.count, sizeof(std::int32_t));
+  }
+
+  static bool read(CountingState& state, const unsigned char* input, std::size_t size) {
+    if (size != sizeof(std::int32_t)) {
+      return false;
+    }
+    std::memcpy(&state.count, input, sizeof(std::int32_t));
+    return true;
+  }
+};
+
+namespace {
+
+TEST_CASE("FSM snapshots restore the current and previous states", "[snapshot]") {
+  aikit::fsm::FSM<> saved;
+  buildMachine(saved);
+  saved.setCurrentState("idle");
+  saved.transitionTo("attack");
+
+  std::vector<unsigned char> snapshot(saved.snapshotSize());
+  REQUIRE(snapshot.size() == 8);
+  REQUIRE(saved.writeSnapshot(snapshot.data()) == snapshot.size());
+
+  EventCounter counter;
+  aikit::fsm::FSM<> restored;
+  buildMachine(restored, &counter);
+  restored.setCurrentState("patrol");
+  REQUIRE(restored.readSnapshot(snapshot.data(), snapshot.size()) == snapshot.size());
+
+  REQUIRE(*restored.currentStateId() == "attack");
+  REQUIRE(*restored.previousStateId() == "idle");
+  REQUIRE(restored.currentStateHandle() == saved.currentStateHandle());
+  REQUIRE(counter.timesEntered == 0);
+  REQUIRE(counter.timesExited == 0);
+
+  SECTION("machines without a current state") {
+    aikit::fsm::FSM<> empty;
+    buildMachine(empty);
+    empty.writeSnapshot(snapshot.data());
+    REQUIRE(restored.readSnapshot(snapshot.data(), snapshot.size()) == snapshot.size());
+    REQUIRE_FALSE(restored.hasCurrentState());
+    REQUIRE_FALSE(restored.hasPreviousState());
+  }
+
+  SECTION("snapshots of states not on the machine are rejected") {
+    restored.removeState("idle");
+    REQUIRE(restored.readSnapshot(snapshot.data(), snapshot.size()) == 0);
+    REQUIRE(restored.readSnapshot(snapshot.data(), snapshot.size() - 1) == 0);
+  }
+
+  SECTION("machines that removed and added states again are restored on fresh machines") {
+    saved.removeState("idle");
+    saved.addState("idle", TestState());
+    saved.transitionTo("idle");
+    saved.writeSnapshot(snapshot.data());
+
+    aikit::fsm::FSM<> rebuilt;
+    buildMachine(rebuilt);
+    REQUIRE(rebuilt.readSnapshot(snapshot.data(), snapshot.size()) == snapshot.size());
+    REQUIRE(*rebuilt.currentStateId() == "idle");
+    REQUIRE(*rebuilt.previousStateId() == "attack");
+  }
+}
+
+TEST_CASE("FSM snapshots are restored as a change of current state", "[snapshot]") {
+  typedef aikit::fsm::FSM<std::string, aikit::fsm::State<>, aikit::fsm::storage::Map, aikit::fsm::Profiler>
+      ProfiledFSM;
+
+  ProfiledFSM saved;
+  saved.addState("idle", TestState());
+  saved.addState("attack", TestState());
+  saved.setCurrentState("attack");
+  std::vector<unsigned char> snapshot(saved.snapshotSize());
+  saved.writeSnapshot(snapshot.data());
+
+  aikit::fsm::ProfileStats stats;
+  ProfiledFSM restored;
+  restored.profiler().attach(&stats);
+  const auto idle = restored.addState("idle", TestState());
+  const auto attack = restored.addState("attack", TestState());
+  restored.enableHistory(4);
+  restored.setCurrentState(idle);
+  REQUIRE(restored.readSnapshot(snapshot.data(), snapshot.size()) == snapshot.size());
+
+  REQUIRE(restored.historySize() == 2);
+  REQUIRE(restored.historyEntry(0)->from == idle);
+  REQUIRE(restored.historyEntry(0)->to == attack);
+  REQUIRE(stats.state(idle.index).exitCount == 1);
+  REQUIRE(stats.state(attack.index).enterCount == 1);
+
+  SECTION("restoring a machine without current state exits the current state") {
+    ProfiledFSM empty;
+    std::vector<unsigned char> emptySnapshot(empty.snapshotSize());
+    empty.writeSnapshot(emptySnapshot.data());
+    REQUIRE(restored.readSnapshot(emptySnapshot.data(), emptySnapshot.size()) == emptySnapshot.size());
+    REQUIRE_FALSE(restored.hasCurrentState());
+    REQUIRE(stats.state(attack.index).exitCount == 1);
+    REQUIRE(restored.historySize() == 3);
+    REQUIRE(restored.historyEntry(0)->from == attack);
+    REQUIRE_FALSE(restored.historyEntry(0)->to.isSet());
+  }
+}
+
+TEST_CASE("FSM snapshots save the payload of states", "[snapshot]") {
+  typedef aikit::fsm::FSM<std::string, CountingState> CountingFSM;
+
+  CountingFSM saved;
+  saved.addState("a", CountingState());
+  saved.addState("b", CountingState());
+  saved.setCurrentState("a");
+  saved.update(3);
+  saved.transitionTo("b");
+  saved.update(5);
+
+  std::vector<unsigned char> snapshot(saved.snapshotSize());
+  REQUIRE(snapshot.size() == 8 + 4 + 2 * (8 + 4));
+  saved.writeSnapshot(snapshot.data());
+
+  CountingFSM restored;
+  restored.addState("a", CountingState());
+  restored.addState("b", CountingState());
+  REQUIRE(restored.readSnapshot(snapshot.data(), snapshot.size()) == snapshot.size());
+  REQUIRE(restored.getState(restored.stateHandle("a"))->count == 3);
+  REQUIRE(restored.currentState()->count == 5);
+
+  SECTION("truncated payloads are rejected") {
+    CountingFSM other;
+    other.addState("a", CountingState());
+    other.addState("b", CountingState());
+    REQUIRE(other.readSnapshot(snapshot.data(), snapshot.size() - 2) == 0);
+    REQUIRE_FALSE(other.hasCurrentState());
+  }
+}
+
+TEST_CASE("Snapshots of many machines on a single buffer", "[snapshot]") {
+  std::vector<aikit::fsm::FSM<>> saved(100);
+  for (std::size_t i = 0; i < saved.size(); ++i) {
+    buildMachine(saved[i]);
+    saved[i].setCurrentState((i % 2 == 0) ? "patrol" : "attack");
+  }
+
+  std::vector<unsigned char> buffer;
+  const std::size_t written = aikit::fsm::saveSnapshots<aikit::fsm::FSM<>>(saved, buffer);
+  REQUIRE(written == buffer.size());
+  REQUIRE(written == 12 + saved.size() * (4 + 8));
+
+  std::vector<aikit::fsm::FSM<>> restored(saved.size());
+  for (auto& machine : restored) {
+    buildMachine(machine);
+  }
+  REQUIRE(aikit::fsm::loadSnapshots<aikit::fsm::FSM<>>(restored, buffer.data(), buffer.size()) == restored.size());
+  for (std::size_t i = 0; i < saved.size(); ++i) {
+    REQUIRE(restored[i].currentStateHandle() == saved[i].currentStateHandle());
+  }
+
+  SECTION("buffers of a different number of machines are rejected") {
+    restored.pop_back();
+    REQUIRE(aikit::fsm::loadSnapshots<aikit::fsm::FSM<>>(restored, buffer.data(), buffer.size()) == 0);
+  }
+
+  SECTION("buffers not written by saveSnapshots() are rejected") {
+    buffer[0] = 0;
+    REQUIRE(aikit::fsm::loadSnapshots<aikit::fsm::FSM<>>(restored, buffer.data(), buffer.size()) == 0);
+  }
+
+  SECTION("truncated buffers restore the machines before the cut") {
+    REQUIRE(aikit::fsm::loadSnapshots<aikit::fsm::FSM<>>(restored, buffer.data(), 12 + 10 * 12 + 5) == 10);
+  }
+}
+
+}
@@ -0,0 +1,170 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/StackFSM.hpp>
+
+namespace {
+
+typedef std::vector<std::string> EventLog;
+typedef aikit::fsm::StackFSM<std::string, aikit::fsm::State<>, 3> TestStackFSM;
+
+// Logs every call it receives as "<call>:<name>"
+class LoggingState : public aikit::fsm::State<> {
+ public:
+  LoggingState(EventLog* log, std::string name) : mLog(log), mName(std::move(name)) {}
+
+  void onEnter() override { mLog->emplace_back("enter:" + mName); }
+  void onExit() override { mLog->emplace_back("exit:" + mName); }
+  void update(int /*updateData*/) override { mLog->emplace_back("update:" + mName); }
+
+ protected:
+  EventLog* mLog;
+  std::string mName;
+};
+
+// Pops itself from the stack when updated
+class PoppingState : public LoggingState {
+ public:
+  PoppingState(TestStackFSM* fsm, EventLog* log, std::string name) : LoggingState(log, std::move(name)), mFsm(fsm) {}
+
+  void update(int updateData) override {
+    LoggingState::update(updateData);
+    REQUIRE(mFsm->pop());
+    REQUIRE(mFsm->push("reload"));
+    mLog->emplace_back("updated:" + mName);
+  }
+
+ private:
+  TestStackFSM* mFsm;
+};
+
+// Pushes "reload" and then fails its update with an exception
+class ThrowingState : public LoggingState {
+ public:
+  ThrowingState(TestStackFSM* fsm, EventLog* log, std::string name) : LoggingState(log, std::move(name)), mFsm(fsm) {}
+
+  void update(int updateData) override {
+    LoggingState::update(updateData);
+    REQUIRE(mFsm->push("reload"));
+    throw std::runtime_error("update failed");
+  }
+
+ private:
+  TestStackFSM* mFsm;
+};
+
+TEST_CASE("StackFSM interrupts and resumes states", "[state_machine], [stack_fsm]") {
+  EventLog log;
+  TestStackFSM fsm;
+
+  const auto patrol = fsm.addState("patrol", LoggingState(&log, "patrol"));
+  const auto stun = fsm.addState("stun", LoggingState(&log, "stun"));
+  const auto cutscene = fsm.addState("cutscene", LoggingState(&log, "cutscene"));
+  fsm.addState("reload", LoggingState(&log, "reload"));
+
+  REQUIRE(TestStackFSM::kCapacity == 3);
+  REQUIRE_FALSE(fsm.hasCurrentState());
+  REQUIRE_FALSE(fsm.pop());
+  REQUIRE_FALSE(fsm.push("invalid"));
+
+  REQUIRE(fsm.push(patrol));
+  REQUIRE(fsm.push("stun"));
+
+  REQUIRE(*fsm.currentStateId() == "stun");
+  REQUIRE(fsm.stackSize() == 2);
+  REQUIRE(log == EventLog{"enter:patrol", "exit:patrol", "enter:stun"});
+
+  SECTION("popping resumes the state below") {
+    log.clear();
+    REQUIRE(fsm.pop());
+
+    REQUIRE(fsm.currentStateHandle() == patrol);
+    REQUIRE(log == EventLog{"exit:stun", "enter:patrol"});
+
+    REQUIRE(fsm.pop());
+    REQUIRE_FALSE(fsm.hasCurrentState());
+    REQUIRE(fsm.currentState() == nullptr);
+  }
+
+  SECTION("replacing keeps the states below") {
+    log.clear();
+    REQUIRE(fsm.replace(cutscene));
+
+    REQUIRE(fsm.stackSize() == 2);
+    REQUIRE(log == EventLog{"exit:stun", "enter:cutscene"});
+    REQUIRE(fsm.stack()[0] == patrol);
+    REQUIRE(fsm.stack()[1] == cutscene);
+  }
+
+  SECTION("the stack has a fixed capacity") {
+    REQUIRE(fsm.push(cutscene));
+    REQUIRE_FALSE(fsm.push(stun));
+    REQUIRE(fsm.stackSize() == 3);
+    REQUIRE(fsm.currentStateHandle() == cutscene);
+  }
+
+  SECTION("clearing only exits the current state") {
+    log.clear();
+    fsm.clear();
+
+    REQUIRE(fsm.stackSize() == 0);
+    REQUIRE(log == EventLog{"exit:stun"});
+  }
+
+  SECTION("states on the stack can not be removed") {
+    REQUIRE_FALSE(fsm.removeState(patrol));
+    REQUIRE(fsm.removeState("cutscene"));
+    REQUIRE_FALSE(fsm.hasState(cutscene));
+  }
+}
+
+TEST_CASE("StackFSM applies operations made while updating after the update", "[state_machine], [stack_fsm]") {
+  EventLog log;
+  TestStackFSM fsm;
+
+  fsm.addState("patrol", LoggingState(&log, "patrol"));
+  fsm.addState("stun", PoppingState(&fsm, &log, "stun"));
+  fsm.addState("reload", LoggingState(&log, "reload"));
+  fsm.push("patrol");
+  fsm.push("stun");
+  log.clear();
+
+  fsm.update(1);
+
+  REQUIRE(log == EventLog{"update:stun", "updated:stun", "exit:stun", "enter:patrol", "exit:patrol", "enter:reload"});
+  REQUIRE(*fsm.currentStateId() == "reload");
+  REQUIRE(fsm.stackSize() == 2);
+
+  log.clear();
+  fsm.update(1);
+  REQUIRE(log == EventLog{"update:reload"});
+}
+
+TEST_CASE("StackFSM drops the operations of an update that throws", "[state_machine], [stack_fsm]") {
+  EventLog log;
+  TestStackFSM fsm;
+
+  fsm.addState("patrol", LoggingState(&log, "patrol"));
+  fsm.addState("stun", ThrowingState(&fsm, &log, "stun"));
+  fsm.addState("reload", LoggingState(&log, "reload"));
+  fsm.push("patrol");
+  fsm.push("stun");
+
+  REQUIRE_THROWS_AS(fsm.update(1), std::runtime_error);
+  REQUIRE(*fsm.currentStateId() == "stun");
+  REQUIRE(fsm.stackSize() == 2);
+
+  // Operations made after the throw are applied right away
+  REQUIRE(fsm.pop());
+  REQUIRE(*fsm.currentStateId() == "patrol");
+
+  // The push made by the failed update is not applied by the next one
+  log.clear();
+  fsm.update(1);
+  REQUIRE(log == EventLog{"update:patrol"});
+  REQUIRE(fsm.stackSize() == 1);
+}
+
+}
@@ -0,0 +1,123 @@
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/State.hpp>
+#include <cppaikit/fsm/StaticFSM.hpp>
+
+namespace {
+
+struct EventCounter {
+  int timesEntered = 0;
+  int timesExited = 0;
+  int timesUpdated = 0;
+  int accumulatedUpdates = 0;
+};
+
+struct Idle {
+  void onEnter() { ++counter.timesEntered; }
+  void onExit() { ++counter.timesExited; }
+  void update(int updateData) {
+    ++counter.timesUpdated;
+    counter.accumulatedUpdates += updateData;
+  }
+
+  EventCounter counter;
+};
+
+struct Walk {
+  void update(int updateData) { distance += updateData; }
+
+  int distance = 0;
+};
+
+// States inheriting from fsm::State are supported, calls are resolved without virtual dispatch
+class Attack : public aikit::fsm::State<> {
+ public:
+  void onEnter() override { ++counter.timesEntered; }
+  void onExit() override { ++counter.timesExited; }
+  void update(int updateData) override { counter.accumulatedUpdates += updateData; }
+
+  EventCounter counter;
+};
+
+typedef aikit::fsm::StaticFSM<Idle, Walk, Attack> TestFSM;
+
+static_assert(TestFSM::kStateCount == 3);
+static_assert(TestFSM::indexOf<Walk>() == 1);
+static_assert(TestFSM::contains<Attack>());
+static_assert(!TestFSM::contains<int>());
+static_assert(aikit::fsm::detail::AreUnique<Idle, Walk, Attack>::value);
+static_assert(!aikit::fsm::detail::AreUnique<Idle, Walk, Idle>::value);
+
+TEST_CASE("StaticFSM starts without a current state", "[state_machine], [static_fsm]") {
+  TestFSM fsm;
+
+  REQUIRE_FALSE(fsm.hasCurrentState());
+  REQUIRE_FALSE(fsm.hasPreviousState());
+  REQUIRE(fsm.currentStateIndex() == TestFSM::kNoState);
+
+  SECTION("update without current state is ignored") {
+    fsm.update(1);
+
+    REQUIRE(fsm.getState<Idle>().counter.timesUpdated == 0);
+  }
+}
+
+TEST_CASE("StaticFSM can transition between states", "[state_machine], [static_fsm]") {
+  TestFSM fsm;
+
+  fsm.transitionTo<Idle>();
+  REQUIRE(fsm.isCurrentState<Idle>());
+  REQUIRE_FALSE(fsm.hasPreviousState());
+  REQUIRE(fsm.getState<Idle>().counter.timesEntered == 1);
+
+  SECTION("transition calls onExit() and onEnter() when they are present") {
+    fsm.transitionTo<Walk>();
+
+    REQUIRE(fsm.isCurrentState<Walk>());
+    REQUIRE(fsm.isPreviousState<Idle>());
+    REQUIRE(fsm.getState<Idle>().counter.timesExited == 1);
+
+    fsm.transitionTo<Attack>();
+
+    REQUIRE(fsm.isCurrentState<Attack>());
+    REQUIRE(fsm.isPreviousState<Walk>());
+    REQUIRE(fsm.getState<Attack>().counter.timesEntered == 1);
+  }
+
+  SECTION("transition to previous state") {
+    fsm.transitionTo<Attack>();
+    REQUIRE(fsm.transitionToPreviousState());
+
+    REQUIRE(fsm.isCurrentState<Idle>());
+    REQUIRE(fsm.isPreviousState<Attack>());
+    REQUIRE(fsm.getState<Idle>().counter.timesEntered == 2);
+    REQUIRE(fsm.getState<Attack>().counter.timesExited == 1);
+  }
+
+  SECTION("setting current state does not call onExit() and onEnter()") {
+    fsm.setCurrentState<Attack>();
+
+    REQUIRE(fsm.isCurrentState<Attack>());
+    REQUIRE(fsm.isPreviousState<Idle>());
+    REQUIRE(fsm.getState<Idle>().counter.timesExited == 0);
+    REQUIRE(fsm.getState<Attack>().counter.timesEntered == 0);
+  }
+}
+
+TEST_CASE("StaticFSM updates only the current state", "[state_machine], [static_fsm]") {
+  TestFSM fsm(Idle{}, Walk{10}, Attack{});
+
+  fsm.setCurrentState<Walk>();
+  fsm.update(2);
+  fsm.update(3);
+
+  REQUIRE(fsm.getState<Walk>().distance == 15);
+  REQUIRE(fsm.getState<Idle>().counter.timesUpdated == 0);
+
+  fsm.transitionTo<Attack>();
+  fsm.update(4);
+
+  REQUIRE(fsm.getState<Attack>().counter.accumulatedUpdates == 4);
+  REQUIRE(fsm.getState<Walk>().distance == 15);
+}
+
+}
@@ -0,0 +1,173 @@
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+#include <cppaikit/fsm/Storage.hpp>
+
+namespace {
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override {}
+};
+
+template<typename TIndex>
+void checkIndexOperations() {
+  // Indexes keep the address of the keys, which must outlive their entries
+  const std::string a = "a";
+  const std::string b = "b";
+  const std::string c = "c";
+  const std::string otherB = "b";
+  TIndex index;
+
+  REQUIRE(index.size() == 0);
+  REQUIRE(index.find("missing") == nullptr);
+
+  REQUIRE(index.insert(a, 1));
+  REQUIRE(index.insert(b, 2));
+  REQUIRE(index.insert(c, 3));
+  REQUIRE_FALSE(index.insert(otherB, 4));
+  REQUIRE(index.size() == 3);
+  REQUIRE(*index.find("b") == 2);
+
+  REQUIRE(index.erase("b"));
+  REQUIRE_FALSE(index.erase("b"));
+  REQUIRE(index.find("b") == nullptr);
+  REQUIRE(*index.find("a") == 1);
+  REQUIRE(*index.find("c") == 3);
+  REQUIRE(index.size() == 2);
+
+  REQUIRE(index.insert(otherB, 4));
+  REQUIRE(*index.find("b") == 4);
+}
+
+template<typename TIndex>
+void checkIndexManyKeys() {
+  std::vector<std::string> keys;
+  for (std::uint32_t i = 0; i < 1000; ++i) {
+    keys.push_back(std::to_string(i));
+  }
+
+  TIndex index;
+  index.reserve(16);
+
+  for (std::uint32_t i = 0; i < 1000; ++i) {
+    REQUIRE(index.insert(keys[i], i));
+  }
+
+  // Remove every third key, forcing entries of shared probe sequences to be moved
+  for (std::uint32_t i = 0; i < 1000; i += 3) {
+    REQUIRE(index.erase(std::to_string(i)));
+  }
+
+  for (std::uint32_t i = 0; i < 1000; ++i) {
+    const auto* found = index.find(std::to_string(i));
+    if (i % 3 == 0) {
+      REQUIRE(found == nullptr);
+    } else {
+      REQUIRE(found != nullptr);
+      REQUIRE(*found == i);
+    }
+  }
+}
+
+template<typename TStorage>
+void checkFSMWithStorage() {
+  aikit::fsm::FSM<std::string, aikit::fsm::State<>, TStorage> fsm;
+  fsm.reserve(3);
+
+  fsm.addState("state1", TestState());
+  fsm.addState("state2", TestState());
+  fsm.addState("state3", TestState());
+  REQUIRE(fsm.size() == 3);
+
+  REQUIRE(fsm.transitionTo("state1"));
+  const std::string* state1Id = fsm.currentStateId();
+  const auto* state1 = fsm.currentState();
+
+  // Adding and removing other states must not invalidate pointers to the current state
+  for (int i = 0; i < 100; ++i) {
+    fsm.addState("extra" + std::to_string(i), TestState());
+  }
+  REQUIRE(fsm.removeState("state2"));
+
+  REQUIRE(fsm.currentStateId() == state1Id);
+  REQUIRE(fsm.currentState() == state1);
+  REQUIRE(*fsm.currentStateId() == "state1");
+  REQUIRE(fsm.getState("state1") == state1);
+  REQUIRE(fsm.size() == 102);
+
+  REQUIRE(fsm.transitionTo("state3"));
+  REQUIRE(fsm.previousStateId() == state1Id);
+  REQUIRE_FALSE(fsm.hasState("state2"));
+  REQUIRE_FALSE(fsm.transitionTo("state2"));
+
+  // Released slots are reused by new states
+  fsm.addState("state2", TestState());
+  REQUIRE(fsm.hasState("state2"));
+  REQUIRE(fsm.stateIds().size() == 103);
+  REQUIRE(fsm.states().size() == 103);
+}
+
+template<typename TStorage>
+void checkFSMIdsOnBuffer() {
+  std::array<std::byte, 16384> buffer;
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+  std::pmr::memory_resource* defaultResource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+  // Ids too long for the small string buffer, copies of them made by the index would need the default resource
+  {
+    aikit::fsm::FSM<std::pmr::string, aikit::fsm::State<>, TStorage> fsm(&arena);
+    fsm.reserve(16);
+    for (int i = 0; i < 16; ++i) {
+      fsm.addState(std::pmr::string("a state with a long id " + std::to_string(i), &arena), TestState());
+    }
+    REQUIRE(fsm.hasState(std::pmr::string("a state with a long id 7", &arena)));
+    REQUIRE(fsm.removeState(std::pmr::string("a state with a long id 7", &arena)));
+  }
+
+  std::pmr::set_default_resource(defaultResource);
+}
+
+TEST_CASE("Storage indexes map keys to slots", "[state_machine], [fsm], [storage]") {
+  SECTION("map index") {
+    checkIndexOperations<aikit::fsm::storage::MapIndex<std::string>>();
+    checkIndexManyKeys<aikit::fsm::storage::MapIndex<std::string>>();
+  }
+
+  SECTION("flat map index") {
+    checkIndexOperations<aikit::fsm::storage::FlatMapIndex<std::string>>();
+    checkIndexManyKeys<aikit::fsm::storage::FlatMapIndex<std::string>>();
+  }
+
+  SECTION("hash map index") {
+    checkIndexOperations<aikit::fsm::storage::HashMapIndex<std::string>>();
+    checkIndexManyKeys<aikit::fsm::storage::HashMapIndex<std::string>>();
+  }
+}
+
+TEST_CASE("FSM behaves the same with every storage policy", "[state_machine], [fsm], [storage]") {
+  SECTION("map storage") {
+    checkFSMWithStorage<aikit::fsm::storage::Map>();
+  }
+
+  SECTION("flat map storage") {
+    checkFSMWithStorage<aikit::fsm::storage::FlatMap>();
+  }
+
+  SECTION("hash map storage") {
+    checkFSMWithStorage<aikit::fsm::storage::HashMap>();
+  }
+}
+
+TEST_CASE("Storage indexes do not copy ids", "[state_machine], [fsm], [storage]") {
+  checkFSMIdsOnBuffer<aikit::fsm::storage::Map>();
+  checkFSMIdsOnBuffer<aikit::fsm::storage::FlatMap>();
+  checkFSMIdsOnBuffer<aikit::fsm::storage::HashMap>();
+}
+
+}
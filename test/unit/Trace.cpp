@@ -0,0 +1,183 @@
+// Built as its own test executable with CppAIKit_TRACING defined, see CMakeLists.txt
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <cppaikit/Trace.hpp>
+#include <cppaikit/fsm/FSM.hpp>
+
+namespace {
+
+using aikit::trace::Record;
+
+class TestState : public aikit::fsm::State<> {
+ public:
+  void update(int /*updateData*/) override {}
+};
+
+std::vector<Record> collectAll() {
+  std::vector<Record> records;
+  aikit::trace::collect(records);
+  return records;
+}
+
+TEST_CASE("FSM transitions are traced", "[trace]") {
+  collectAll();
+
+  aikit::fsm::FSM<> fsm;
+  fsm.setTraceId(7);
+  const auto idle = fsm.addState("idle", TestState());
+  const auto patrol = fsm.addState("patrol", TestState());
+  const auto alarm = fsm.addEvent();
+  fsm.addTransition(patrol, alarm, idle);
+
+  fsm.setCurrentState(idle);
+  fsm.transitionTo(patrol);
+  fsm.dispatch(alarm);
+
+  const auto records = collectAll();
+  REQUIRE(records.size() == 3);
+  for (const auto& record : records) {
+    REQUIRE(record.machine == 7);
+  }
+
+  REQUIRE(records[0].from == aikit::trace::kNone);
+  REQUIRE(records[0].to == idle.index);
+  REQUIRE(records[1].from == idle.index);
+  REQUIRE(records[1].to == patrol.index);
+  REQUIRE(records[1].event == aikit::trace::kNone);
+  REQUIRE(records[2].to == idle.index);
+  REQUIRE(records[2].event == alarm.index);
+  REQUIRE(records[0].timestamp <= records[1].timestamp);
+  REQUIRE(records[1].timestamp <= records[2].timestamp);
+
+  SECTION("collected records are not collected again") {
+    REQUIRE(collectAll().empty());
+  }
+
+  SECTION("machines left without current state trace no state entered") {
+    aikit::fsm::FSM<> single;
+    const auto only = single.addState("only", TestState());
+    single.setCurrentState(only);
+    collectAll();
+    single.removeState(only);
+    const auto removed = collectAll();
+    REQUIRE(removed.size() == 1);
+    REQUIRE(removed[0].from == only.index);
+    REQUIRE(removed[0].to == aikit::trace::kNone);
+  }
+
+  SECTION("machines get distinct ids") {
+    aikit::fsm::FSM<> first;
+    aikit::fsm::FSM<> second;
+    REQUIRE(first.traceId() != second.traceId());
+  }
+}
+
+TEST_CASE("Each thread records on its own buffer", "[trace]") {
+  collectAll();
+
+  constexpr std::uint32_t threadCount = 4;
+  constexpr std::uint32_t transitionCount = 100;
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t thread = 0; thread < threadCount; ++thread) {
+    threads.emplace_back([thread] {
+      for (std::uint32_t i = 0; i < transitionCount; ++i) {
+        aikit::trace::recordTransition(thread, i, i + 1, aikit::trace::kNone);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const auto records = collectAll();
+  REQUIRE(records.size() == threadCount * transitionCount);
+
+  std::vector<std::uint32_t> perMachine(threadCount, 0);
+  for (const auto& record : records) {
+    REQUIRE(record.to == record.from + 1);
+    ++perMachine[record.machine];
+  }
+  for (const auto count : perMachine) {
+    REQUIRE(count == transitionCount);
+  }
+}
+
+TEST_CASE("Full buffers keep the newest records", "[trace]") {
+  collectAll();
+  aikit::trace::setBufferCapacity(10);
+
+  // A new thread gets a buffer of the new capacity, rounded up to 16
+  std::thread([] {
+    for (std::uint32_t i = 0; i < 40; ++i) {
+      aikit::trace::recordTransition(0, i, i, aikit::trace::kNone);
+    }
+  }).join();
+
+  const auto records = collectAll();
+  REQUIRE(records.size() == 16);
+  REQUIRE(records.front().to == 24);
+  REQUIRE(records.back().to == 39);
+
+  aikit::trace::setBufferCapacity(4096);
+}
+
+TEST_CASE("Records overwritten while collected are dropped, not torn", "[trace]") {
+  collectAll();
+  aikit::trace::setBufferCapacity(16);
+
+  // Every field of a record holds the same value, a torn record mixes the words of two records
+  constexpr std::uint32_t transitionCount = 200000;
+  std::atomic<bool> done{false};
+  std::thread writer([&done] {
+    for (std::uint32_t i = 0; i < transitionCount; ++i) {
+      aikit::trace::recordTransition(i, i, i, i);
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  std::vector<Record> records;
+  bool finished = false;
+  while (!finished) {
+    finished = done.load(std::memory_order_acquire);
+    records.clear();
+    aikit::trace::collect(records);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+      REQUIRE(records[i].machine == records[i].from);
+      REQUIRE(records[i].from == records[i].to);
+      REQUIRE(records[i].to == records[i].event);
+      if (i > 0) {
+        REQUIRE(records[i].to > records[i - 1].to);
+      }
+    }
+  }
+  writer.join();
+
+  REQUIRE(collectAll().empty());
+  aikit::trace::setBufferCapacity(4096);
+}
+
+TEST_CASE("Records are written as a Chrome trace", "[trace]") {
+  collectAll();
+
+  aikit::trace::recordTransition(3, aikit::trace::kNone, 1, aikit::trace::kNone);
+  aikit::trace::recordTransition(3, 1, 2, 5);
+
+  std::ostringstream output;
+  REQUIRE(aikit::trace::writeChromeTrace(output) == 2);
+
+  const std::string json = output.str();
+  REQUIRE(json.find("{\"traceEvents\":[") == 0);
+  REQUIRE(json.find("\"tid\":3") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"from\":null,\"to\":1,\"event\":null}") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"from\":1,\"to\":2,\"event\":5}") != std::string::npos);
+  REQUIRE(json.find("\"displayTimeUnit\":\"ns\"}") != std::string::npos);
+}
+
+}